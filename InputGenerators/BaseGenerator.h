@@ -3,9 +3,12 @@
 
 
 #include <stddef.h>
+#include <stdint.h>
 
 typedef void (*input_fill_generator)(void* arr, size_t len);
 
+// Uniform fills over the historical ranges. Deterministic: every call with the
+// same length produces the same data for the seed set by gen_set_seed().
 void gen_int_signed    (void* arr, size_t len);
 void gen_int_unsigned  (void* arr, size_t len);
 void gen_float_signed  (void* arr, size_t len);
@@ -13,4 +16,61 @@ void gen_float_unsigned(void* arr, size_t len);
 void gen_double_signed  (void* arr, size_t len);
 void gen_double_unsigned(void* arr, size_t len);
 
+void gen_set_seed(uint64_t seed);
+
+// ===================== shaped generators =====================
+// Values come from a counter-based PRNG (element i depends only on seed and
+// i), so any sub-range can be produced independently and in parallel.
+
+typedef enum {
+    GEN_INT_SIGNED,      // int32   [-100000, 100000]
+    GEN_INT_UNSIGNED,    // int32   [0, 2^31-1]
+    GEN_FLOAT_SIGNED,    // float   [-1e6, 1e6]
+    GEN_FLOAT_UNSIGNED,  // float   [0, 1e6]
+    GEN_DOUBLE_SIGNED,   // double  [-1e12, 1e12]
+    GEN_DOUBLE_UNSIGNED, // double  [0, 1e12]
+    GEN_TYPE_COUNT
+} gen_type;
+
+typedef enum {
+    GEN_UNIFORM,
+    GEN_SORTED,          // ascending ramp over the range
+    GEN_REVERSED,        // descending ramp
+    GEN_NEARLY_SORTED,   // ramp with `param` disjoint random swaps   (default n/1000)
+    GEN_SAWTOOTH,        // ascending ramps of period `param`         (default n/16)
+    GEN_ORGAN_PIPE,      // ascending first half, descending second half
+    GEN_FEW_UNIQUE,      // `param` distinct values                   (default 16)
+    GEN_ZIPF,            // `param` ranks with exponent `zipf_s`      (default 65536, 1.0)
+    GEN_GAUSSIAN,        // normal around the range midpoint, sd = range/8, clamped
+    GEN_RADIX_HOT_DIGIT, // random top 16 bits, all lower digits identical
+    GEN_SHAPE_COUNT
+} gen_shape;
+
+typedef struct {
+    gen_type  type;
+    gen_shape shape;
+    uint64_t  seed;
+    size_t    param;   // shape parameter, 0 = default
+    double    zipf_s;  // Zipf exponent, 0 = default
+} gen_spec;
+
+// A plan holds per-spec precomputed state (e.g. the Zipf CDF) for an array of
+// `total` elements. Fills are thread-safe on a shared plan.
+typedef struct gen_plan gen_plan;
+
+gen_plan* gen_plan_create (const gen_spec* spec, size_t total);
+void      gen_plan_fill   (const gen_plan* plan, void* out, size_t first, size_t count);
+void      gen_plan_destroy(gen_plan* plan);
+
+// Fills arr[0, len) in parallel. Returns 0 on success, -1 on allocation failure.
+int gen_fill(void* arr, size_t len, const gen_spec* spec);
+
+size_t      gen_type_size (gen_type type);
+const char* gen_type_name (gen_type type);   // "IntSigned", ...
+const char* gen_shape_name(gen_shape shape); // "Uniform", ...
+
+// Case-insensitive; accepts "IntSigned" or "int_signed" style. -1 if unknown.
+int gen_type_parse (const char* s);
+int gen_shape_parse(const char* s);
+
 #endif //BASEGENERATOR_H
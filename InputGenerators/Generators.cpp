@@ -1,46 +1,350 @@
-#include <cstdlib>
-#include <random>
+#include "BaseGenerator.h"
 
-void gen_int_signed(void* arr, size_t len) {
-    int* a = (int*)arr;
-    for (size_t i = 0; i < len; i++)
-        a[i] = (std::rand() % 200001) - 100000;
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// ===================== counter-based PRNG =====================
+// SplitMix64 finaliser over (seed, stream, index): stateless, so element i is
+// reproducible regardless of thread count or fill order.
+
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rng_at(uint64_t seed, uint64_t stream, uint64_t i) {
+    return mix64(seed ^ mix64(stream * 0x9E3779B97F4A7C15ull + i));
+}
+
+static inline double unit_at(uint64_t seed, uint64_t stream, uint64_t i) {
+    return (double)(rng_at(seed, stream, i) >> 11) * 0x1.0p-53;   // [0, 1)
+}
+
+enum { S_VALUE = 1, S_PICK, S_SWAP_A, S_SWAP_B, S_GAUSS_U1, S_GAUSS_U2 };
+
+// ===================== type ranges =====================
+struct TypeInfo {
+    const char* name;
+    const char* alias;
+    size_t      size;
+    double      lo, hi;
+};
+
+static const TypeInfo kTypes[GEN_TYPE_COUNT] = {
+    {"IntSigned",      "int_signed",      sizeof(int32_t), -100000.0, 100000.0},
+    {"IntUnsigned",    "int_unsigned",    sizeof(int32_t), 0.0,       2147483647.0},
+    {"FloatSigned",    "float_signed",    sizeof(float),   -1e6,      1e6},
+    {"FloatUnsigned",  "float_unsigned",  sizeof(float),   0.0,       1e6},
+    {"DoubleSigned",   "double_signed",   sizeof(double),  -1e12,     1e12},
+    {"DoubleUnsigned", "double_unsigned", sizeof(double),  0.0,       1e12},
+};
+
+static const char* const kShapeNames[GEN_SHAPE_COUNT][2] = {
+    {"Uniform",      "uniform"},
+    {"Sorted",       "sorted"},
+    {"Reversed",     "reversed"},
+    {"NearlySorted", "nearly_sorted"},
+    {"Sawtooth",     "sawtooth"},
+    {"OrganPipe",    "organ_pipe"},
+    {"FewUnique",    "few_unique"},
+    {"Zipf",         "zipf"},
+    {"Gaussian",     "gaussian"},
+    {"RadixHotDigit","radix_hot_digit"},
+};
+
+// ===================== plan =====================
+struct gen_plan {
+    gen_spec            spec;
+    size_t              total;
+    size_t              param;
+    std::vector<double> zipf_cdf;
+};
+
+static size_t default_param(gen_shape shape, size_t total) {
+    switch (shape) {
+        case GEN_NEARLY_SORTED: return std::max<size_t>(1, total / 1000);
+        case GEN_SAWTOOTH:      return std::max<size_t>(2, total / 16);
+        case GEN_FEW_UNIQUE:    return 16;
+        case GEN_ZIPF:          return 65536;
+        default:                return 0;
+    }
+}
+
+gen_plan* gen_plan_create(const gen_spec* spec, size_t total) {
+    if (!spec || spec->type >= GEN_TYPE_COUNT || spec->shape >= GEN_SHAPE_COUNT) return nullptr;
+
+    gen_plan* p = new (std::nothrow) gen_plan();
+    if (!p) return nullptr;
+    p->spec  = *spec;
+    p->total = total;
+    p->param = spec->param ? spec->param : default_param(spec->shape, total);
+
+    if (spec->shape == GEN_ZIPF) {
+        double s = spec->zipf_s > 0 ? spec->zipf_s : 1.0;
+        try {
+            p->zipf_cdf.resize(p->param);
+        } catch (...) {
+            delete p;
+            return nullptr;
+        }
+        double acc = 0.0;
+        for (size_t r = 0; r < p->param; r++) {
+            acc += 1.0 / std::pow((double)(r + 1), s);
+            p->zipf_cdf[r] = acc;
+        }
+        for (double& c : p->zipf_cdf) c /= acc;
+    }
+    return p;
+}
+
+void gen_plan_destroy(gen_plan* plan) {
+    delete plan;
+}
+
+// ===================== per-element value model =====================
+// Every shape is expressed as a position t in [0, 1] of the type's range
+// (ramps, Gaussian) or as a hashed uniform draw (uniform, few-unique, Zipf).
+// RADIX_HOT_DIGIT is the exception: it is defined on raw bit patterns.
+
+template <typename T>
+static inline T from_unit(const TypeInfo& ti, double t) {
+    double v = ti.lo + (ti.hi - ti.lo) * t;
+    if (v < ti.lo) v = ti.lo;
+    if (v > ti.hi) v = ti.hi;
+    return (T)v;
+}
+
+template <>
+inline int32_t from_unit<int32_t>(const TypeInfo& ti, double t) {
+    double v = std::floor(ti.lo + (ti.hi - ti.lo + 1.0) * t);
+    if (v < ti.lo) v = ti.lo;
+    if (v > ti.hi) v = ti.hi;
+    return (int32_t)v;
+}
+
+static inline double ramp(size_t i, size_t n) {
+    return n > 1 ? (double)i / (double)(n - 1) : 0.0;
+}
+
+static inline uint32_t hot_bits32(uint64_t h, bool unsigned_only, bool is_float) {
+    uint32_t b = (uint32_t)(h >> 32) & 0xFFFF0000u;
+    if (is_float && ((b >> 23) & 0xFFu) == 0xFFu) b &= ~0x40000000u;   // keep finite
+    if (unsigned_only) b &= 0x7FFFFFFFu;
+    return b;
+}
+
+static inline uint64_t hot_bits64(uint64_t h, bool unsigned_only) {
+    uint64_t b = h & 0xFFFF000000000000ull;
+    if (((b >> 52) & 0x7FFull) == 0x7FFull) b &= ~0x4000000000000000ull;
+    if (unsigned_only) b &= 0x7FFFFFFFFFFFFFFFull;
+    return b;
 }
 
-void gen_int_unsigned(void* arr, size_t len) {
-    int* a = (int*)arr;
-    for (size_t i = 0; i < len; i++)
-        a[i] = std::rand();
+template <typename T>
+static T hot_digit(gen_type type, uint64_t h) {
+    T v;
+    if (sizeof(T) == 8) {
+        uint64_t b = hot_bits64(h, type == GEN_DOUBLE_UNSIGNED);
+        std::memcpy(&v, &b, sizeof(v));
+    } else {
+        bool is_float = (type == GEN_FLOAT_SIGNED || type == GEN_FLOAT_UNSIGNED);
+        bool uns = (type == GEN_INT_UNSIGNED || type == GEN_FLOAT_UNSIGNED);
+        uint32_t b = hot_bits32(h, uns, is_float);
+        std::memcpy(&v, &b, sizeof(v));
+    }
+    return v;
 }
 
-void gen_float_signed(void* arr, size_t len) {
-    float* a = (float*)arr;
-    std::mt19937 rng(std::random_device{}());
-    std::uniform_real_distribution<float> dist(-1e6f, 1e6f);
-    for (size_t i = 0; i < len; i++)
-        a[i] = dist(rng);
+template <typename T>
+static void fill_typed(const gen_plan* p, T* out, size_t first, size_t count) {
+    const TypeInfo& ti = kTypes[p->spec.type];
+    const uint64_t seed = p->spec.seed;
+    const size_t n = p->total;
+    const size_t k = p->param;
+
+    switch (p->spec.shape) {
+        case GEN_UNIFORM:
+            for (size_t j = 0; j < count; j++)
+                out[j] = from_unit<T>(ti, unit_at(seed, S_VALUE, first + j));
+            break;
+
+        case GEN_SORTED:
+            for (size_t j = 0; j < count; j++) out[j] = from_unit<T>(ti, ramp(first + j, n));
+            break;
+
+        case GEN_REVERSED:
+            for (size_t j = 0; j < count; j++) out[j] = from_unit<T>(ti, ramp(n - 1 - (first + j), n));
+            break;
+
+        case GEN_NEARLY_SORTED: {
+            // k disjoint swaps: stripe s owns one position in its first half
+            // and one in its second half, so each element can be resolved alone.
+            size_t stripe = n / (k ? k : 1);
+            for (size_t j = 0; j < count; j++) {
+                size_t i = first + j, src = i;
+                if (stripe >= 2) {
+                    size_t s = i / stripe;
+                    if (s < k) {
+                        size_t base = s * stripe, half = stripe / 2;
+                        size_t a = base + rng_at(seed, S_SWAP_A, s) % half;
+                        size_t b = base + half + rng_at(seed, S_SWAP_B, s) % (stripe - half);
+                        if (i == a) src = b;
+                        else if (i == b) src = a;
+                    }
+                }
+                out[j] = from_unit<T>(ti, ramp(src, n));
+            }
+            break;
+        }
+
+        case GEN_SAWTOOTH:
+            for (size_t j = 0; j < count; j++) out[j] = from_unit<T>(ti, ramp((first + j) % k, k));
+            break;
+
+        case GEN_ORGAN_PIPE: {
+            size_t half = (n + 1) / 2;
+            for (size_t j = 0; j < count; j++) {
+                size_t i = first + j;
+                size_t pos = i < half ? i : n - 1 - i;
+                out[j] = from_unit<T>(ti, ramp(pos, half));
+            }
+            break;
+        }
+
+        case GEN_FEW_UNIQUE:
+            for (size_t j = 0; j < count; j++) {
+                uint64_t r = rng_at(seed, S_PICK, first + j) % k;
+                out[j] = from_unit<T>(ti, unit_at(seed, S_VALUE, r));
+            }
+            break;
+
+        case GEN_ZIPF: {
+            const double* cdf = p->zipf_cdf.data();
+            for (size_t j = 0; j < count; j++) {
+                double u = unit_at(seed, S_PICK, first + j);
+                size_t r = (size_t)(std::upper_bound(cdf, cdf + k, u) - cdf);
+                if (r >= k) r = k - 1;
+                out[j] = from_unit<T>(ti, unit_at(seed, S_VALUE, r));
+            }
+            break;
+        }
+
+        case GEN_GAUSSIAN:
+            for (size_t j = 0; j < count; j++) {
+                double u1 = 1.0 - unit_at(seed, S_GAUSS_U1, first + j);   // (0, 1]
+                double u2 = unit_at(seed, S_GAUSS_U2, first + j);
+                double z = std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+                out[j] = from_unit<T>(ti, 0.5 + z / 8.0);
+            }
+            break;
+
+        case GEN_RADIX_HOT_DIGIT:
+            for (size_t j = 0; j < count; j++)
+                out[j] = hot_digit<T>(p->spec.type, rng_at(seed, S_VALUE, first + j));
+            break;
+
+        default:
+            break;
+    }
+}
+
+void gen_plan_fill(const gen_plan* plan, void* out, size_t first, size_t count) {
+    if (!plan || !out) return;
+    switch (plan->spec.type) {
+        case GEN_INT_SIGNED:
+        case GEN_INT_UNSIGNED:
+            fill_typed<int32_t>(plan, (int32_t*)out, first, count);
+            break;
+        case GEN_FLOAT_SIGNED:
+        case GEN_FLOAT_UNSIGNED:
+            fill_typed<float>(plan, (float*)out, first, count);
+            break;
+        default:
+            fill_typed<double>(plan, (double*)out, first, count);
+            break;
+    }
+}
+
+int gen_fill(void* arr, size_t len, const gen_spec* spec) {
+    gen_plan* plan = gen_plan_create(spec, len);
+    if (!plan) return -1;
+
+    size_t esz = kTypes[spec->type].size;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+#ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+#else
+        int tid = 0;
+        int threads = 1;
+#endif
+        size_t start = (len * (size_t)tid) / (size_t)threads;
+        size_t end   = (len * (size_t)(tid + 1)) / (size_t)threads;
+        gen_plan_fill(plan, (char*)arr + start * esz, start, end - start);
+    }
+
+    gen_plan_destroy(plan);
+    return 0;
+}
+
+// ===================== names =====================
+size_t gen_type_size(gen_type type) {
+    return type < GEN_TYPE_COUNT ? kTypes[type].size : 0;
+}
+
+const char* gen_type_name(gen_type type) {
+    return type < GEN_TYPE_COUNT ? kTypes[type].name : "?";
+}
+
+const char* gen_shape_name(gen_shape shape) {
+    return shape < GEN_SHAPE_COUNT ? kShapeNames[shape][0] : "?";
 }
 
-void gen_float_unsigned(void* arr, size_t len) {
-    float* a = (float*)arr;
-    std::mt19937 rng(std::random_device{}());
-    std::uniform_real_distribution<float> dist(0.0f, 1e6f);
-    for (size_t i = 0; i < len; i++)
-        a[i] = dist(rng);
+static bool same_name(const char* a, const char* b) {
+    for (; *a && *b; a++, b++)
+        if (std::tolower((unsigned char)*a) != std::tolower((unsigned char)*b)) return false;
+    return *a == *b;
+}
+
+int gen_type_parse(const char* s) {
+    for (int t = 0; t < GEN_TYPE_COUNT; t++)
+        if (same_name(s, kTypes[t].name) || same_name(s, kTypes[t].alias)) return t;
+    return -1;
+}
+
+int gen_shape_parse(const char* s) {
+    for (int t = 0; t < GEN_SHAPE_COUNT; t++)
+        if (same_name(s, kShapeNames[t][0]) || same_name(s, kShapeNames[t][1])) return t;
+    return -1;
+}
+
+// ===================== legacy uniform fills =====================
+static uint64_t g_seed = 1;
+
+void gen_set_seed(uint64_t seed) {
+    g_seed = seed;
 }
 
-void gen_double_signed(void* arr, size_t len) {
-    double* a = (double*)arr;
-    std::mt19937 rng(std::random_device{}());
-    std::uniform_real_distribution<double> dist(-1e12, 1e12);
-    for (size_t i = 0; i < len; i++)
-        a[i] = dist(rng);
+static void gen_uniform(gen_type type, void* arr, size_t len) {
+    gen_spec spec = {type, GEN_UNIFORM, g_seed, 0, 0.0};
+    gen_fill(arr, len, &spec);
 }
 
-void gen_double_unsigned(void* arr, size_t len) {
-    double* a = (double*)arr;
-    std::mt19937 rng(std::random_device{}());
-    std::uniform_real_distribution<double> dist(0.0, 1e12);
-    for (size_t i = 0; i < len; i++)
-        a[i] = dist(rng);
-}
\ No newline at end of file
+void gen_int_signed(void* arr, size_t len)      { gen_uniform(GEN_INT_SIGNED, arr, len); }
+void gen_int_unsigned(void* arr, size_t len)    { gen_uniform(GEN_INT_UNSIGNED, arr, len); }
+void gen_float_signed(void* arr, size_t len)    { gen_uniform(GEN_FLOAT_SIGNED, arr, len); }
+void gen_float_unsigned(void* arr, size_t len)  { gen_uniform(GEN_FLOAT_UNSIGNED, arr, len); }
+void gen_double_signed(void* arr, size_t len)   { gen_uniform(GEN_DOUBLE_SIGNED, arr, len); }
+void gen_double_unsigned(void* arr, size_t len) { gen_uniform(GEN_DOUBLE_UNSIGNED, arr, len); }
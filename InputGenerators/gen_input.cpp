@@ -0,0 +1,225 @@
+// Input file generator for the sort binaries and benchmarks.
+//
+// usage: gen_input [options] <output-file>
+//   --type   int_signed | int_unsigned | float_signed | float_unsigned |
+//            double_signed | double_unsigned                 (default int_signed)
+//   --shape  uniform | sorted | reversed | nearly_sorted | sawtooth |
+//            organ_pipe | few_unique | zipf | gaussian | radix_hot_digit
+//                                                             (default uniform)
+//   --n      element count, 1e9 notation accepted             (default 1e6)
+//   --seed   PRNG seed                                        (default 1)
+//   --param  shape parameter (swaps, period, distinct values, Zipf ranks)
+//   --zipf-s Zipf exponent                                    (default 1.0)
+//   --binary write the raw native-endian array instead of text
+//
+// Text output is one value per line: ints as %d, floats as %.9g and doubles
+// as %.16e, so the sort binaries' type detection sees doubles as float64.
+//
+// Each thread generates and formats its own block and writes it with pwrite,
+// so output runs at close to memory/disk bandwidth on many cores.
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "BaseGenerator.h"
+
+static const size_t kBlock = (size_t)1 << 20;   // elements per thread per round
+
+static void usage() {
+    fprintf(stderr,
+            "usage: gen_input [--type T] [--shape S] [--n N] [--seed S] [--param K]\n"
+            "                 [--zipf-s S] [--binary] <output-file>\n");
+}
+
+// ===================== formatting =====================
+static inline size_t fmt_i32(char* p, int32_t v) {
+    char tmp[12];
+    size_t len = 0, out = 0;
+    uint32_t u = (uint32_t)v;
+    if (v < 0) {
+        p[out++] = '-';
+        u = 0u - u;
+    }
+    do {
+        tmp[len++] = (char)('0' + u % 10u);
+        u /= 10u;
+    } while (u);
+    while (len) p[out++] = tmp[--len];
+    p[out++] = '\n';
+    return out;
+}
+
+static size_t format_block(gen_type type, const void* vals, size_t count, char* out) {
+    size_t pos = 0;
+    switch (type) {
+        case GEN_INT_SIGNED:
+        case GEN_INT_UNSIGNED: {
+            const int32_t* a = (const int32_t*)vals;
+            for (size_t i = 0; i < count; i++) pos += fmt_i32(out + pos, a[i]);
+            break;
+        }
+        case GEN_FLOAT_SIGNED:
+        case GEN_FLOAT_UNSIGNED: {
+            const float* a = (const float*)vals;
+            for (size_t i = 0; i < count; i++) pos += (size_t)snprintf(out + pos, 32, "%.9g\n", a[i]);
+            break;
+        }
+        default: {
+            const double* a = (const double*)vals;
+            for (size_t i = 0; i < count; i++) pos += (size_t)snprintf(out + pos, 32, "%.16e\n", a[i]);
+            break;
+        }
+    }
+    return pos;
+}
+
+static int write_full(int fd, const char* p, size_t len, off_t off) {
+    while (len) {
+        ssize_t w = pwrite(fd, p, len, off);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        len -= (size_t)w;
+        off += w;
+    }
+    return 0;
+}
+
+// ===================== main =====================
+int main(int argc, char** argv) {
+    gen_spec spec = {GEN_INT_SIGNED, GEN_UNIFORM, 1, 0, 0.0};
+    size_t n = 1000000;
+    int binary = 0;
+    const char* path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(a, "--binary") == 0) {
+            binary = 1;
+        } else if (strcmp(a, "--type") == 0 && v) {
+            int t = gen_type_parse(v);
+            if (t < 0) { fprintf(stderr, "Unknown type '%s'\n", v); return 2; }
+            spec.type = (gen_type)t;
+            i++;
+        } else if (strcmp(a, "--shape") == 0 && v) {
+            int s = gen_shape_parse(v);
+            if (s < 0) { fprintf(stderr, "Unknown shape '%s'\n", v); return 2; }
+            spec.shape = (gen_shape)s;
+            i++;
+        } else if (strcmp(a, "--n") == 0 && v) {
+            n = (size_t)strtod(v, NULL);
+            i++;
+        } else if (strcmp(a, "--seed") == 0 && v) {
+            spec.seed = strtoull(v, NULL, 0);
+            i++;
+        } else if (strcmp(a, "--param") == 0 && v) {
+            spec.param = (size_t)strtod(v, NULL);
+            i++;
+        } else if (strcmp(a, "--zipf-s") == 0 && v) {
+            spec.zipf_s = strtod(v, NULL);
+            i++;
+        } else if (a[0] == '-' && a[1] == '-') {
+            usage();
+            return 2;
+        } else if (!path) {
+            path = a;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!path) {
+        usage();
+        return 2;
+    }
+
+    gen_plan* plan = gen_plan_create(&spec, n);
+    if (!plan) {
+        fprintf(stderr, "Failed to create generator plan\n");
+        return 1;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open output file '%s': %s\n", path, strerror(errno));
+        gen_plan_destroy(plan);
+        return 1;
+    }
+
+    const size_t esz = gen_type_size(spec.type);
+    int failed = 0;
+
+#ifdef _OPENMP
+    int threads = omp_get_max_threads();
+#else
+    int threads = 1;
+#endif
+    std::vector<size_t> lens((size_t)threads);
+    off_t base = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+    {
+#ifdef _OPENMP
+        int tid = omp_get_thread_num();
+#else
+        int tid = 0;
+#endif
+        std::vector<unsigned char> vals(kBlock * esz);
+        std::vector<char> text(binary ? 0 : kBlock * 32);
+
+        // Round r covers blocks [r*threads, (r+1)*threads); block b is owned by
+        // thread b % threads. Binary offsets are known up front; text offsets
+        // need the round's block lengths first.
+        size_t rounds = (n + kBlock * (size_t)threads - 1) / (kBlock * (size_t)threads);
+        for (size_t r = 0; r < rounds; r++) {
+            size_t first = (r * (size_t)threads + (size_t)tid) * kBlock;
+            size_t count = first < n ? (n - first < kBlock ? n - first : kBlock) : 0;
+            if (count) gen_plan_fill(plan, vals.data(), first, count);
+
+            if (binary) {
+                if (count && write_full(fd, (const char*)vals.data(), count * esz, (off_t)(first * esz)) != 0)
+                    failed = 1;
+                continue;
+            }
+
+            lens[(size_t)tid] = count ? format_block(spec.type, vals.data(), count, text.data()) : 0;
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+            off_t off = base;
+            for (int t = 0; t < tid; t++) off += (off_t)lens[(size_t)t];
+            if (lens[(size_t)tid] && write_full(fd, text.data(), lens[(size_t)tid], off) != 0) failed = 1;
+#ifdef _OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+            {
+                for (int t = 0; t < threads; t++) base += (off_t)lens[(size_t)t];
+            }
+        }
+    }
+
+    gen_plan_destroy(plan);
+    if (close(fd) != 0) failed = 1;
+    if (failed) {
+        fprintf(stderr, "Failed to write output file '%s': %s\n", path, strerror(errno));
+        return 1;
+    }
+    return 0;
+}
@@ -2,6 +2,7 @@
 #define BASE_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -9,12 +10,34 @@ extern "C" {
     typedef int  (*cmp_func)(const void *, const void *);
     typedef void (*sort_func_t)(void *arr, size_t len, size_t size, cmp_func compar);
 
+    /*
+     * Order-preserving key of the element at elem: elements are sorted by
+     * the unsigned value of their key. offset is passed through from
+     * radix_sort_by_key so one extractor serves any field position.
+     */
+    typedef uint64_t (*key_func)(const void *elem, size_t offset);
+
     void bubble_sort       (void *arr, size_t len, size_t size, cmp_func compar);
     void quick_sort        (void *arr, size_t len, size_t size, cmp_func compar);
     void merge_sort        (void *arr, size_t len, size_t size, cmp_func compar);
+    void heap_sort         (void *arr, size_t len, size_t size, cmp_func compar);
     void radix_sort        (void *arr, size_t len, size_t size, cmp_func compar);
     void bitonic_sort      (void *arr, size_t len, size_t size, cmp_func compar);
 
+    /*
+     * Stable LSD radix sort of len records of size bytes by key(elem, offset),
+     * of which only the low key_bits (1..64) may be set. Keys are extracted
+     * once, (key, index) pairs are radix-sorted and the records are permuted
+     * in a single pass.
+     */
+    void radix_sort_by_key (void *arr, size_t len, size_t size, key_func key, size_t offset, int key_bits);
+
+    /* Built-in extractors for an int / float / double field at offset
+       (32, 32 and 64 key bits). NaNs sort by sign: -NaN first, +NaN last. */
+    uint64_t key_int       (const void *elem, size_t offset);
+    uint64_t key_float     (const void *elem, size_t offset);
+    uint64_t key_double    (const void *elem, size_t offset);
+
 #ifdef __cplusplus
 }
 #endif
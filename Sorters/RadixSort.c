@@ -1,4 +1,8 @@
 #include "Base.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 /*
  * @param arr
@@ -20,8 +24,174 @@
  *
  *      Example signature:
  *          int compar(const void* a, const void* b);
+ *
+ *      A comparator cannot drive a radix sort; use radix_sort_by_key with a
+ *      key extractor instead.
 */
 
 void radix_sort(void* arr, size_t len, size_t size, cmp_func compar) {
     //TODO
 }
+
+#define DIGIT_BITS 8
+#define BUCKETS    (1 << DIGIT_BITS)
+#define MAX_PASSES (64 / DIGIT_BITS)
+
+typedef struct {
+    uint64_t key;
+    size_t   idx;
+} key_pair;
+
+/* ---------------- built-in key extractors ---------------- */
+
+uint64_t key_int(const void* elem, size_t offset) {
+    int32_t x;
+    memcpy(&x, (const char*)elem + offset, sizeof(x));
+    return (uint32_t)x ^ 0x80000000u;
+}
+
+/* negative floats invert all bits, positives flip the sign bit */
+uint64_t key_float(const void* elem, size_t offset) {
+    uint32_t x;
+    memcpy(&x, (const char*)elem + offset, sizeof(x));
+    return x ^ ((uint32_t)((int32_t)x >> 31) | 0x80000000u);
+}
+
+uint64_t key_double(const void* elem, size_t offset) {
+    uint64_t x;
+    memcpy(&x, (const char*)elem + offset, sizeof(x));
+    return x ^ ((uint64_t)((int64_t)x >> 63) | 0x8000000000000000ull);
+}
+
+/* ---------------- (key, index) radix sort ---------------- */
+
+/* Turns counts into bucket starts; returns 0 when every item falls into one
+   bucket and the pass would not move anything. */
+static int prefix_sum(size_t* count, size_t len) {
+    size_t sum = 0;
+    for (int d = 0; d < BUCKETS; d++) {
+        size_t c = count[d];
+        if (c == len) return 0;
+        count[d] = sum;
+        sum += c;
+    }
+    return 1;
+}
+
+/* Keys of at most 32 bits and indices below 2^32 share one word (key in the
+   high half), which halves the bytes moved per pass. Returns the buffer that
+   holds the result. */
+static uint64_t* sort_packed(uint64_t* a, uint64_t* tmp, size_t len, int passes) {
+    size_t count[MAX_PASSES][BUCKETS];
+    memset(count, 0, sizeof(count));
+    for (size_t i = 0; i < len; i++)
+        for (int p = 0; p < passes; p++)
+            count[p][(a[i] >> (32 + p * DIGIT_BITS)) & (BUCKETS - 1)]++;
+
+    for (int p = 0; p < passes; p++) {
+        if (!prefix_sum(count[p], len)) continue;
+        int shift = 32 + p * DIGIT_BITS;
+        for (size_t i = 0; i < len; i++)
+            tmp[count[p][(a[i] >> shift) & (BUCKETS - 1)]++] = a[i];
+        uint64_t* t = a; a = tmp; tmp = t;
+    }
+    return a;
+}
+
+static key_pair* sort_pairs(key_pair* a, key_pair* tmp, size_t len, int passes) {
+    size_t count[MAX_PASSES][BUCKETS];
+    memset(count, 0, sizeof(count));
+    for (size_t i = 0; i < len; i++)
+        for (int p = 0; p < passes; p++)
+            count[p][(a[i].key >> (p * DIGIT_BITS)) & (BUCKETS - 1)]++;
+
+    for (int p = 0; p < passes; p++) {
+        if (!prefix_sum(count[p], len)) continue;
+        int shift = p * DIGIT_BITS;
+        for (size_t i = 0; i < len; i++)
+            tmp[count[p][(a[i].key >> shift) & (BUCKETS - 1)]++] = a[i];
+        key_pair* t = a; a = tmp; tmp = t;
+    }
+    return a;
+}
+
+/* ---------------- permutation ---------------- */
+
+/* dst[i] = src[index of the i-th smallest key]: sequential writes, one
+   random read per record. Common record sizes get fixed-size copies. */
+#define GATHER(bytes, index_of)                                           \
+    for (size_t i = 0; i < len; i++)                                     \
+        memcpy(dst + i * (bytes), src + (index_of) * (bytes), (bytes))
+
+static void gather_packed(char* dst, const char* src, const uint64_t* order, size_t len, size_t size) {
+    switch (size) {
+        case 4:  GATHER(4, (uint32_t)order[i]); break;
+        case 8:  GATHER(8, (uint32_t)order[i]); break;
+        case 16: GATHER(16, (uint32_t)order[i]); break;
+        default: GATHER(size, (uint32_t)order[i]); break;
+    }
+}
+
+static void gather_pairs(char* dst, const char* src, const key_pair* order, size_t len, size_t size) {
+    switch (size) {
+        case 4:  GATHER(4, order[i].idx); break;
+        case 8:  GATHER(8, order[i].idx); break;
+        case 16: GATHER(16, order[i].idx); break;
+        default: GATHER(size, order[i].idx); break;
+    }
+}
+
+/*
+ * @param key
+ *      Key extractor; see key_func in Base.h and the built-in key_int,
+ *      key_float and key_double.
+ *
+ * @param offset
+ *      Passed to key unchanged, e.g. offsetof(struct rec, field).
+ *
+ * @param key_bits
+ *      Number of significant key bits (1..64); one pass per 8 bits.
+ *
+ * Extra memory: two (key, index) arrays and one copy of the records. Leaves
+ * arr untouched when that cannot be allocated.
+*/
+void radix_sort_by_key(void* arr, size_t len, size_t size, key_func key, size_t offset, int key_bits) {
+    if (len < 2 || !key) return;
+    if (key_bits < 1) key_bits = 1;
+    if (key_bits > 64) key_bits = 64;
+    const int passes = (key_bits + DIGIT_BITS - 1) / DIGIT_BITS;
+    const int packed = key_bits <= 32 && len <= UINT32_MAX;
+    const size_t item = packed ? sizeof(uint64_t) : sizeof(key_pair);
+
+    char* base = (char*)arr;
+    void* a = malloc(len * item);
+    void* tmp = malloc(len * item);
+    char* records = (char*)malloc(len * size);
+    if (!a || !tmp || !records) {
+        free(a);
+        free(tmp);
+        free(records);
+        return;
+    }
+
+    if (packed) {
+        uint64_t* k = (uint64_t*)a;
+        for (size_t i = 0; i < len; i++)
+            k[i] = key(base + i * size, offset) << 32 | (uint64_t)i;
+        const uint64_t* order = sort_packed(k, (uint64_t*)tmp, len, passes);
+        gather_packed(records, base, order, len, size);
+    } else {
+        key_pair* k = (key_pair*)a;
+        for (size_t i = 0; i < len; i++) {
+            k[i].key = key(base + i * size, offset);
+            k[i].idx = i;
+        }
+        const key_pair* order = sort_pairs(k, (key_pair*)tmp, len, passes);
+        gather_pairs(records, base, order, len, size);
+    }
+    memcpy(base, records, len * size);
+
+    free(a);
+    free(tmp);
+    free(records);
+}
@@ -0,0 +1,320 @@
+// Sort benchmark matrix: algorithm x input type x shape x size (x threads).
+//
+// Names follow <Algorithm>_<InputType>_<Shape>/n:<size>[/threads:<t>], e.g.
+//   QuickSort_IntSigned_Uniform/n:100000
+//   FinalRadixOmp_DoubleSigned_Zipf/n:10000000/threads:8
+// so RUNNING.SH filters such as "QuickSort.*IntSigned" select rows directly.
+//
+// FinalRadixOmp is libsort (the sort_omp engine) with one sort_ctx reused
+// across iterations, LibArgsort its argsort; FinalRadix is final_sort.c.
+// RadixSortByKey is the generic radix_sort_by_key with the built-in
+// extractor for the element type.
+//
+// LibSegments_<InputType>/seg:<len>/threads:<t> sorts one uniform buffer cut
+// into equal segments of <len> elements with sort_segments_*, reporting
+// segments per second.
+//
+// Environment:
+//   SORT_BENCH_MAX_N   largest size in the matrix (default 1e7, up to 1e9)
+//   SORT_BENCH_SEED    generator seed (default 42); inputs are reproducible
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Base.h"
+#include "BaseComparators.h"
+#include "BaseGenerator.h"
+#include "final_sort_kernels.h"
+#include "sort.h"
+
+namespace {
+
+enum ElemKind { K_INT, K_FLOAT, K_DOUBLE };
+
+struct InputType {
+    gen_type    type;
+    ElemKind    kind;
+    size_t      elem_size;
+    comparator  cmp;
+};
+
+const InputType kInputTypes[] = {
+    {GEN_INT_SIGNED,      K_INT,    sizeof(int),    compare_int_asc},
+    {GEN_INT_UNSIGNED,    K_INT,    sizeof(int),    compare_int_asc},
+    {GEN_FLOAT_SIGNED,    K_FLOAT,  sizeof(float),  compare_float_asc},
+    {GEN_FLOAT_UNSIGNED,  K_FLOAT,  sizeof(float),  compare_float_asc},
+    {GEN_DOUBLE_SIGNED,   K_DOUBLE, sizeof(double), compare_double_asc},
+    {GEN_DOUBLE_UNSIGNED, K_DOUBLE, sizeof(double), compare_double_asc},
+};
+
+const gen_shape kShapes[] = {
+    GEN_UNIFORM, GEN_SORTED, GEN_REVERSED, GEN_NEARLY_SORTED, GEN_SAWTOOTH,
+    GEN_ORGAN_PIPE, GEN_FEW_UNIQUE, GEN_ZIPF, GEN_GAUSSIAN, GEN_RADIX_HOT_DIGIT,
+};
+
+// Generic comparison sorters from Sorters/*.c. max_n keeps the quadratic
+// ones out of sizes that would never finish.
+struct GenericSorter {
+    const char*  name;
+    sort_func_t  fn;
+    size_t       max_n;
+};
+
+const GenericSorter kGenericSorters[] = {
+    {"BubbleSort",  bubble_sort,  10000},
+    {"QuickSort",   quick_sort,   10000000},
+    {"MergeSort",   merge_sort,   10000000},
+    {"HeapSort",    heap_sort,    10000000},
+    {"RadixSort",   radix_sort,   10000000},
+    {"BitonicSort", bitonic_sort, 10000000},
+};
+
+size_t max_n_from_env() {
+    const char* s = std::getenv("SORT_BENCH_MAX_N");
+    if (!s || !*s) return 10000000;
+    double v = std::strtod(s, nullptr);
+    return v >= 1 ? (size_t)v : 10000000;
+}
+
+uint64_t seed_from_env() {
+    const char* s = std::getenv("SORT_BENCH_SEED");
+    return (s && *s) ? std::strtoull(s, nullptr, 0) : 42;
+}
+
+std::vector<size_t> sizes_up_to(size_t cap) {
+    std::vector<size_t> out;
+    for (size_t n = 1000; n <= cap && n <= 1000000000; n *= 10) out.push_back(n);
+    return out;
+}
+
+std::vector<int> thread_counts() {
+    int max_t = (int)std::thread::hardware_concurrency();
+    if (max_t < 1) max_t = 1;
+    std::vector<int> out;
+    for (int t = 1; t < max_t; t *= 2) out.push_back(t);
+    out.push_back(max_t);
+    return out;
+}
+
+bool is_sorted_as(const InputType& t, const void* data, size_t n) {
+    const char* p = (const char*)data;
+    for (size_t i = 1; i < n; i++)
+        if (t.cmp(p + (i - 1) * t.elem_size, p + i * t.elem_size) > 0) return false;
+    return true;
+}
+
+// Inputs are generated once per (type, shape, n) row; every iteration sorts a fresh
+// copy and only the sort call itself is timed.
+template <typename SortCall>
+void run_sort_bench(benchmark::State& state, const InputType& t, gen_shape shape, size_t n, SortCall sort_call) {
+    size_t bytes = n * t.elem_size;
+    std::vector<unsigned char> pristine(bytes), work(bytes);
+    gen_spec spec = {t.type, shape, seed_from_env(), 0, 0.0};
+    if (gen_fill(pristine.data(), n, &spec) != 0) {
+        state.SkipWithError("input generation failed");
+        return;
+    }
+
+    std::memcpy(work.data(), pristine.data(), bytes);
+    sort_call(work.data(), n);
+    if (!is_sorted_as(t, work.data(), n)) {
+        state.SkipWithError("output not sorted");
+        return;
+    }
+
+    for (auto _ : state) {
+        std::memcpy(work.data(), pristine.data(), bytes);
+        auto start = std::chrono::steady_clock::now();
+        sort_call(work.data(), n);
+        auto end = std::chrono::steady_clock::now();
+        benchmark::DoNotOptimize(work.data());
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+    state.SetItemsProcessed((int64_t)state.iterations() * (int64_t)n);
+    state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)bytes);
+}
+
+void final_seq(const InputType& t, void* data, size_t n) {
+    switch (t.kind) {
+        case K_INT:    final_seq_radix_i32((int32_t*)data, n); break;
+        case K_FLOAT:  final_seq_radix_f32((float*)data, n); break;
+        case K_DOUBLE: final_seq_radix_f64((double*)data, n); break;
+    }
+}
+
+void by_key(const InputType& t, void* data, size_t n) {
+    switch (t.kind) {
+        case K_INT:    radix_sort_by_key(data, n, t.elem_size, key_int, 0, 32); break;
+        case K_FLOAT:  radix_sort_by_key(data, n, t.elem_size, key_float, 0, 32); break;
+        case K_DOUBLE: radix_sort_by_key(data, n, t.elem_size, key_double, 0, 64); break;
+    }
+}
+
+void lib_sort(const InputType& t, sort_ctx* ctx, void* data, size_t n) {
+    switch (t.kind) {
+        case K_INT:    sort_i32(ctx, (int32_t*)data, n); break;
+        case K_FLOAT:  sort_f32(ctx, (float*)data, n); break;
+        case K_DOUBLE: sort_f64(ctx, (double*)data, n); break;
+    }
+}
+
+void lib_argsort(const InputType& t, sort_ctx* ctx, const void* data, size_t n, uint32_t* idx) {
+    switch (t.kind) {
+        case K_INT:    argsort_i32(ctx, (const int32_t*)data, n, idx); break;
+        case K_FLOAT:  argsort_f32(ctx, (const float*)data, n, idx); break;
+        case K_DOUBLE: argsort_f64(ctx, (const double*)data, n, idx); break;
+    }
+}
+
+void lib_segments(const InputType& t, sort_ctx* ctx, void* data, const size_t* off, size_t segs) {
+    switch (t.kind) {
+        case K_INT:    sort_segments_i32(ctx, (int32_t*)data, off, segs); break;
+        case K_FLOAT:  sort_segments_f32(ctx, (float*)data, off, segs); break;
+        case K_DOUBLE: sort_segments_f64(ctx, (double*)data, off, segs); break;
+    }
+}
+
+sort_ctx* make_ctx(int threads) {
+    sort_tuning tuning;
+    sort_tuning_default(&tuning);
+    tuning.threads = threads;
+    tuning.parallel_min_n = 0;  // rows measure the requested team size
+    return sort_ctx_create(&tuning);
+}
+
+// Segments are checked by comparing neighbours within each segment.
+void run_segments_bench(benchmark::State& state, const InputType& t, size_t n, size_t seg_len, int threads) {
+    size_t segs = n / seg_len;
+    n = segs * seg_len;
+    size_t bytes = n * t.elem_size;
+    std::vector<size_t> off(segs + 1);
+    for (size_t s = 0; s <= segs; s++) off[s] = s * seg_len;
+    std::vector<unsigned char> pristine(bytes), work(bytes);
+    gen_spec spec = {t.type, GEN_UNIFORM, seed_from_env(), 0, 0.0};
+    if (gen_fill(pristine.data(), n, &spec) != 0) {
+        state.SkipWithError("input generation failed");
+        return;
+    }
+    sort_ctx* ctx = make_ctx(threads);
+
+    std::memcpy(work.data(), pristine.data(), bytes);
+    lib_segments(t, ctx, work.data(), off.data(), segs);
+    for (size_t s = 0; s < segs; s++) {
+        if (!is_sorted_as(t, work.data() + off[s] * t.elem_size, seg_len)) {
+            state.SkipWithError("segment not sorted");
+            sort_ctx_destroy(ctx);
+            return;
+        }
+    }
+
+    for (auto _ : state) {
+        std::memcpy(work.data(), pristine.data(), bytes);
+        auto start = std::chrono::steady_clock::now();
+        lib_segments(t, ctx, work.data(), off.data(), segs);
+        auto end = std::chrono::steady_clock::now();
+        benchmark::DoNotOptimize(work.data());
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+    sort_ctx_destroy(ctx);
+    state.SetItemsProcessed((int64_t)state.iterations() * (int64_t)n);
+    state.counters["segments_per_second"] =
+        benchmark::Counter((double)segs * (double)state.iterations(), benchmark::Counter::kIsRate);
+    state.counters["threads"] = threads;
+}
+
+void register_all() {
+    const size_t cap = max_n_from_env();
+    const std::vector<int> threads = thread_counts();
+
+    for (const InputType& t : kInputTypes) {
+        std::string name = std::string("LibSegments_") + gen_type_name(t.type);
+        auto* b = benchmark::RegisterBenchmark(name.c_str(), [&t, cap](benchmark::State& st) {
+            run_segments_bench(st, t, std::min(cap, (size_t)10000000), (size_t)st.range(0), (int)st.range(1));
+        });
+        b->ArgNames({"seg", "threads"})->UseManualTime()->Unit(benchmark::kMillisecond);
+        for (int64_t len : {10, 100, 1000, 5000})
+            for (int th : threads) b->Args({len, th});
+    }
+
+    for (const InputType& t : kInputTypes) {
+        for (gen_shape shape : kShapes) {
+            std::string row = std::string("_") + gen_type_name(t.type) + "_" + gen_shape_name(shape);
+
+            for (const GenericSorter& s : kGenericSorters) {
+                std::string name = s.name + row;
+                auto* b = benchmark::RegisterBenchmark(name.c_str(), [&t, &s, shape](benchmark::State& st) {
+                    size_t n = (size_t)st.range(0);
+                    run_sort_bench(st, t, shape, n, [&](void* d, size_t len) { s.fn(d, len, t.elem_size, t.cmp); });
+                });
+                b->ArgName("n")->UseManualTime()->Unit(benchmark::kMillisecond);
+                for (size_t n : sizes_up_to(std::min(cap, s.max_n))) b->Arg((int64_t)n);
+            }
+
+            auto* bk = benchmark::RegisterBenchmark(("RadixSortByKey" + row).c_str(), [&t, shape](benchmark::State& st) {
+                size_t n = (size_t)st.range(0);
+                run_sort_bench(st, t, shape, n, [&](void* d, size_t len) { by_key(t, d, len); });
+            });
+            bk->ArgName("n")->UseManualTime()->Unit(benchmark::kMillisecond);
+            for (size_t n : sizes_up_to(cap)) bk->Arg((int64_t)n);
+
+            auto* seq = benchmark::RegisterBenchmark(("FinalRadix" + row).c_str(), [&t, shape](benchmark::State& st) {
+                size_t n = (size_t)st.range(0);
+                run_sort_bench(st, t, shape, n, [&](void* d, size_t len) { final_seq(t, d, len); });
+            });
+            seq->ArgName("n")->UseManualTime()->Unit(benchmark::kMillisecond);
+            for (size_t n : sizes_up_to(cap)) seq->Arg((int64_t)n);
+
+            auto* omp = benchmark::RegisterBenchmark(("FinalRadixOmp" + row).c_str(), [&t, shape](benchmark::State& st) {
+                size_t n = (size_t)st.range(0);
+                int th = (int)st.range(1);
+                sort_ctx* ctx = make_ctx(th);
+                run_sort_bench(st, t, shape, n, [&](void* d, size_t len) { lib_sort(t, ctx, d, len); });
+                sort_ctx_destroy(ctx);
+                st.counters["threads"] = th;
+            });
+            omp->ArgNames({"n", "threads"})->UseManualTime()->Unit(benchmark::kMillisecond);
+            for (size_t n : sizes_up_to(cap))
+                for (int th : threads) omp->Args({(int64_t)n, th});
+
+            // argsort output is checked by gathering the keys through idx
+            auto* arg = benchmark::RegisterBenchmark(("LibArgsort" + row).c_str(), [&t, shape](benchmark::State& st) {
+                size_t n = (size_t)st.range(0);
+                int th = (int)st.range(1);
+                sort_ctx* ctx = make_ctx(th);
+                std::vector<uint32_t> idx(n);
+                std::vector<unsigned char> keys;
+                run_sort_bench(st, t, shape, n, [&](void* d, size_t len) {
+                    lib_argsort(t, ctx, d, len, idx.data());
+                    keys.assign((unsigned char*)d, (unsigned char*)d + len * t.elem_size);
+                    for (size_t i = 0; i < len; i++)
+                        std::memcpy((unsigned char*)d + i * t.elem_size, keys.data() + idx[i] * t.elem_size,
+                                    t.elem_size);
+                });
+                sort_ctx_destroy(ctx);
+                st.counters["threads"] = th;
+            });
+            arg->ArgNames({"n", "threads"})->UseManualTime()->Unit(benchmark::kMillisecond);
+            for (size_t n : sizes_up_to(cap))
+                for (int th : threads) arg->Args({(int64_t)n, th});
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    register_all();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
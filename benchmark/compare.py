@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Compare two sort_bench JSON reports and flag regressions.
+
+usage: compare.py <baseline.json> <current.json> [--threshold 0.10]
+
+Rows are matched by benchmark name. When repetitions were requested the
+median aggregate is used, otherwise the single run. A row regresses when its
+real_time grew by more than the threshold. Exit status is 1 if any row
+regressed, so the script can gate a deployment pipeline.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+    rows = {}
+    for b in report.get("benchmarks", []):
+        if b.get("error_occurred"):
+            continue
+        name = b.get("run_name", b["name"])
+        kind = b.get("run_type", "iteration")
+        if kind == "aggregate":
+            if b.get("aggregate_name") != "median":
+                continue
+            rows[name] = b  # median wins over individual repetitions
+        elif name not in rows:
+            rows[name] = b
+    return rows
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("baseline")
+    ap.add_argument("current")
+    ap.add_argument("--threshold", type=float, default=0.10,
+                    help="relative slowdown that counts as a regression")
+    args = ap.parse_args()
+
+    base = load(args.baseline)
+    cur = load(args.current)
+
+    regressions = 0
+    print(f"{'benchmark':<64} {'base':>12} {'current':>12} {'change':>8}")
+    for name in sorted(cur):
+        if name not in base:
+            continue
+        b = base[name]["real_time"]
+        c = cur[name]["real_time"]
+        unit = cur[name].get("time_unit", "ns")
+        change = (c - b) / b if b > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{name:<64} {b:>10.3f}{unit:>2} {c:>10.3f}{unit:>2} {change:>+7.1%}{flag}")
+
+    missing = sorted(set(base) - set(cur))
+    if missing:
+        print(f"\n{len(missing)} baseline rows not present in current run")
+
+    if regressions:
+        print(f"\n{regressions} regression(s) above {args.threshold:.0%}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,9 @@
+#define main final_sort_seq_main
+#include "../final_sort.c"
+#undef main
+
+#include "final_sort_kernels.h"
+
+void final_seq_radix_i32(int32_t* a, size_t n) { radix_i32(a, n); }
+void final_seq_radix_f32(float* a, size_t n)   { radix_f32(a, n); }
+void final_seq_radix_f64(double* a, size_t n)  { radix_f64(a, n); }
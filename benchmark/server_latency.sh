@@ -0,0 +1,74 @@
+#!/bin/bash
+# Per-job latency: a fresh sort_omp process per job vs. the sort_omp server.
+#
+# usage: benchmark/server_latency.sh [iters]
+#
+# Environment:
+#   BUILD_DIR   CMake build directory          (default: build)
+#   N           elements per job               (default: 1e6)
+#   TYPE        int | float | double           (default: int)
+#
+# The process column is wall time of `sort_omp input /dev/null` (exec, runtime
+# startup, read, parse, sort); its SORT_ONLY share is printed alongside. The
+# server column is the sort_client round trip on a warm server.
+
+set -e
+
+BUILD_DIR="${BUILD_DIR:-build}"
+N="${N:-1e6}"
+TYPE="${TYPE:-int}"
+ITERS="${1:-100}"
+
+case "$TYPE" in
+    int)    GEN_TYPE=int_signed ;;
+    float)  GEN_TYPE=float_signed ;;
+    double) GEN_TYPE=double_signed ;;
+    *) echo "unknown TYPE '$TYPE'" >&2; exit 2 ;;
+esac
+
+cmake -S . -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release > /dev/null
+cmake --build "$BUILD_DIR" -j"$(nproc)" --target sort_omp sort_client gen_input > /dev/null
+
+TMP="$(mktemp -d)"
+SOCK="$TMP/sort.sock"
+trap 'kill "$SERVER" 2> /dev/null; rm -rf "$TMP"' EXIT
+
+"$BUILD_DIR/gen_input" --type "$GEN_TYPE" --n "$N" "$TMP/input.txt"
+
+# ---- one process per job ----
+: > "$TMP/wall"
+: > "$TMP/sort"
+for _ in $(seq "$ITERS"); do
+    t0=$(date +%s%N)
+    "$BUILD_DIR/sort_omp" "$TMP/input.txt" /dev/null 2> "$TMP/err"
+    t1=$(date +%s%N)
+    echo $(( (t1 - t0) / 1000 )) >> "$TMP/wall"
+    awk '/^SORT_ONLY/ { printf "%d\n", $2 * 1e6 }' "$TMP/err" >> "$TMP/sort"
+done
+
+pct() {
+    sort -n "$1" | awk -v label="$2" '
+        { v[NR] = $1 }
+        END {
+            printf "%-11s p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f us\n", label,
+                   v[int(0.50 * (NR - 1) + 1.5)], v[int(0.90 * (NR - 1) + 1.5)],
+                   v[int(0.99 * (NR - 1) + 1.5)], v[NR]
+        }'
+}
+
+echo "== process per job (n=$N type=$TYPE iters=$ITERS)"
+pct "$TMP/wall" wall
+pct "$TMP/sort" sort_only
+
+# ---- warm server ----
+"$BUILD_DIR/sort_omp" --serve "$SOCK" 2> /dev/null &
+SERVER=$!
+for _ in $(seq 50); do
+    [ -S "$SOCK" ] && "$BUILD_DIR/sort_client" --socket "$SOCK" --ping > /dev/null 2>&1 && break
+    sleep 0.1
+done
+
+echo "== server"
+"$BUILD_DIR/sort_client" --socket "$SOCK" --type "$TYPE" --n "$N" --bench "$ITERS"
+"$BUILD_DIR/sort_client" --socket "$SOCK" --shutdown
+wait "$SERVER"
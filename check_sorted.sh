@@ -1,25 +1,24 @@
 #!/bin/bash
+# Thin wrapper around the native verifier (verify_sorted.c).
+#
+# usage: ./check_sorted.sh <output> [input]
+#
+# With <input> it also checks that the output is a permutation of the input.
+# The verifier is looked up in $VERIFY_SORTED, ./build, next to this script,
+# then $PATH.
 
-if [ $# -ne 1 ]; then
-    echo "Usage: $0 <file>"
-    exit 1
+if [ $# -lt 1 ] || [ $# -gt 2 ]; then
+    echo "Usage: $0 <output> [input]"
+    exit 2
 fi
 
-file="$1"
+dir="$(cd "$(dirname "$0")" && pwd)"
+for cand in "$VERIFY_SORTED" "$dir/build/verify_sorted" "$dir/verify_sorted" "$(command -v verify_sorted)"; do
+    if [ -n "$cand" ] && [ -x "$cand" ]; then
+        exec "$cand" "$@"
+    fi
+done
 
-awk '
-NR==1 {
-    prev=$1
-    next
-}
-{
-    if ($1 < prev) {
-        printf("Not sorted at line %d\n", NR)
-        exit 1
-    }
-    prev=$1
-}
-END {
-    print "Sorted"
-}
-' "$file"
+echo "verify_sorted not found; build it with:" >&2
+echo "  gcc -O3 -march=native -std=c11 -Wall -Wextra -fopenmp -o verify_sorted verify_sorted.c" >&2
+exit 2
@@ -0,0 +1,144 @@
+// Decoder for `sort_omp --column` output.
+//
+// Build:
+//   gcc -O3 -march=native -std=c11 -Wall -Wextra -fopenmp -o col_decode
+//   col_decode.c libsort/*.c
+//
+// usage: col_decode [--range FIRST COUNT] [--binary] <in.scol> [output|stdout]
+//
+// Writes the values of a compressed sorted column (sort_col_* in libsort)
+// one per line, formatted like sort_omp prints them, so the text output of
+// `sort_omp --column` piped through col_decode is byte-identical to plain
+// `sort_omp`. --range decodes only values [FIRST, FIRST + COUNT), reading
+// just the blocks that hold them; --binary writes the raw native-endian
+// array instead of text. The column is memory-mapped and decoded in chunks
+// across all threads.
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "libsort/sort.h"
+
+#define CHUNK ((size_t)1 << 20)  // values decoded per call
+
+static void write_text(FILE* f, int type, const void* a, size_t n) {
+  if (type == SORT_COL_I32) {
+    const int32_t* v = (const int32_t*)a;
+    for (size_t i = 0; i < n; i++)
+      fprintf(f, "%d\n", v[i]);
+  } else if (type == SORT_COL_F32) {
+    const float* v = (const float*)a;
+    for (size_t i = 0; i < n; i++)
+      fprintf(f, "%.9g\n", v[i]);
+  } else {
+    const double* v = (const double*)a;
+    for (size_t i = 0; i < n; i++)
+      fprintf(f, "%.17g\n", v[i]);
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* in_path = NULL;
+  const char* out_path = NULL;
+  size_t first = 0, count = SIZE_MAX;
+  int binary = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--range") == 0 && i + 2 < argc) {
+      first = (size_t)strtoull(argv[++i], NULL, 10);
+      count = (size_t)strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--binary") == 0)
+      binary = 1;
+    else if (strncmp(argv[i], "--", 2) == 0)
+      return 2;
+    else if (!in_path)
+      in_path = argv[i];
+    else if (!out_path)
+      out_path = argv[i];
+    else
+      return 2;
+  }
+  if (!in_path)
+    return 2;
+
+  int fd = open(in_path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    fprintf(stderr, "Failed to open input file '%s': %s\n", in_path,
+            strerror(errno));
+    return 1;
+  }
+  const size_t bytes = (size_t)st.st_size;
+  void* map = bytes ? mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+  close(fd);
+  sort_col col;
+  if (map == MAP_FAILED || sort_col_open(&col, map, bytes) != SORT_OK) {
+    fprintf(stderr, "'%s' is not a sorted column\n", in_path);
+    return 1;
+  }
+  if (first > col.n) {
+    fprintf(stderr, "Range starts past the %zu values\n", col.n);
+    return 2;
+  }
+  if (count > col.n - first)
+    count = col.n - first;
+
+  FILE* out = stdout;
+  if (out_path && strcmp(out_path, "stdout") != 0) {
+    out = fopen(out_path, "wb");
+    if (!out) {
+      fprintf(stderr, "Failed to open output file '%s': %s\n", out_path,
+              strerror(errno));
+      return 1;
+    }
+  }
+
+#ifdef _OPENMP
+  omp_set_num_threads(sort_available_cpus());
+#endif
+  sort_tuning tuning;
+  sort_tuning_default(&tuning);
+  sort_ctx* ctx = sort_ctx_create(&tuning);
+  const size_t esz = col.type == SORT_COL_F64 ? sizeof(double) : 4;
+  void* buf = malloc(CHUNK * esz);
+  if (!ctx || !buf) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
+  for (size_t done = 0; done < count;) {
+    size_t len = count - done < CHUNK ? count - done : CHUNK;
+    if (sort_col_decode(ctx, &col, first + done, len, buf) != SORT_OK) {
+      fprintf(stderr, "Decode failed\n");
+      return 1;
+    }
+    if (binary)
+      fwrite(buf, esz, len, out);
+    else
+      write_text(out, col.type, buf, len);
+    done += len;
+  }
+
+  int rc = 0;
+  if (fflush(out) != 0 || ferror(out)) {
+    fprintf(stderr, "Failed to write output\n");
+    rc = 1;
+  }
+  if (out != stdout)
+    fclose(out);
+  free(buf);
+  sort_ctx_destroy(ctx);
+  if (map)
+    munmap(map, bytes);
+  return rc;
+}
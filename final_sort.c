@@ -1,6 +1,7 @@
 // Build:
 //   gcc -O3 -march=native -std=c11 -Wall -Wextra -o sort final_sort.c
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,6 +10,8 @@
 #include <errno.h>
 #include <time.h>
 
+#include "instrument.h"
+
 #ifndef N_EXPECTED
 #define N_EXPECTED 1000000u
 #endif
@@ -122,19 +125,49 @@ static size_t parse_f64_capped(const unsigned char* buf, size_t cap, double* out
 }
 
 // ===================== radix key transforms =====================
+// Branch-free (sign mask instead of a ternary) so the transform loops
+// vectorize: negatives invert all bits, positives flip the sign bit.
 
 static inline uint32_t flip_f32(uint32_t x) {
-    return (x & 0x80000000u) ? ~x : (x ^ 0x80000000u);
+    return x ^ ((uint32_t)((int32_t)x >> 31) | 0x80000000u);
 }
 static inline uint32_t unflip_f32(uint32_t k) {
-    return (k & 0x80000000u) ? (k ^ 0x80000000u) : ~k;
+    return k ^ ((uint32_t)((int32_t)~k >> 31) | 0x80000000u);
 }
 
 static inline uint64_t flip_f64(uint64_t x) {
-    return (x & 0x8000000000000000ull) ? ~x : (x ^ 0x8000000000000000ull);
+    return x ^ ((uint64_t)((int64_t)x >> 63) | 0x8000000000000000ull);
 }
 static inline uint64_t unflip_f64(uint64_t k) {
-    return (k & 0x8000000000000000ull) ? (k ^ 0x8000000000000000ull) : ~k;
+    return k ^ ((uint64_t)((int64_t)~k >> 63) | 0x8000000000000000ull);
+}
+
+// ===================== digit histograms =====================
+// Consecutive keys are counted into HIST_TABLES interleaved 64K tables, so a
+// run of equal digits (narrow-range data) makes independent increment chains
+// instead of stalling on store-to-load forwarding to a single counter. cnt
+// holds HIST_TABLES * 65536 entries; the sums end up in the first table.
+#define HIST_TABLES 4
+
+static void hist16_u32(const uint32_t* src, size_t n, int shift, uint32_t* cnt) {
+    memset(cnt, 0, HIST_TABLES * 65536u * sizeof(uint32_t));
+    size_t i = 0;
+    for (; i + HIST_TABLES <= n; i += HIST_TABLES)
+        for (int j = 0; j < HIST_TABLES; j++) cnt[j * 65536u + ((src[i + j] >> shift) & 0xFFFFu)]++;
+    for (; i < n; i++) cnt[(src[i] >> shift) & 0xFFFFu]++;
+    for (int j = 1; j < HIST_TABLES; j++)
+        for (uint32_t b = 0; b < 65536u; b++) cnt[b] += cnt[j * 65536u + b];
+}
+
+static void hist16_u64(const uint64_t* src, size_t n, int shift, uint32_t* cnt) {
+    memset(cnt, 0, HIST_TABLES * 65536u * sizeof(uint32_t));
+    size_t i = 0;
+    for (; i + HIST_TABLES <= n; i += HIST_TABLES)
+        for (int j = 0; j < HIST_TABLES; j++)
+            cnt[j * 65536u + (uint32_t)((src[i + j] >> shift) & 0xFFFFull)]++;
+    for (; i < n; i++) cnt[(uint32_t)((src[i] >> shift) & 0xFFFFull)]++;
+    for (int j = 1; j < HIST_TABLES; j++)
+        for (uint32_t b = 0; b < 65536u; b++) cnt[b] += cnt[j * 65536u + b];
 }
 
 // ===================== radix sort int32 (2 passes base 2^16) =====================
@@ -143,19 +176,20 @@ static void radix_i32(int32_t* a, size_t n) {
 
     uint32_t* src = (uint32_t*)malloc(n * sizeof(uint32_t));
     uint32_t* dst = (uint32_t*)malloc(n * sizeof(uint32_t));
-    uint32_t* cnt = (uint32_t*)calloc(65536u, sizeof(uint32_t));
+    uint32_t* cnt = (uint32_t*)calloc(HIST_TABLES * 65536u, sizeof(uint32_t));
     if (!src || !dst || !cnt) {
         fprintf(stderr, "Allocation failed (radix_i32)\n");
         exit(1);
     }
 
+    PHASE_BEGIN(m_xf);
     for (size_t i = 0; i < n; i++) src[i] = ((uint32_t)a[i]) ^ 0x80000000u;
+    PHASE_END(m_xf, "key_transform", 2 * n * sizeof(uint32_t));
 
     for (int pass = 0; pass < 2; pass++) {
-        memset(cnt, 0, 65536u * sizeof(uint32_t));
+        PHASE_BEGIN(m_pass);
         int shift = pass * 16;
-
-        for (size_t i = 0; i < n; i++) cnt[(src[i] >> shift) & 0xFFFFu]++;
+        hist16_u32(src, n, shift, cnt);
 
         uint32_t sum = 0;
         for (uint32_t i = 0; i < 65536u; i++) {
@@ -170,9 +204,12 @@ static void radix_i32(int32_t* a, size_t n) {
         }
 
         uint32_t* tmp = src; src = dst; dst = tmp;
+        PHASE_END_IDX(m_pass, "radix_pass", pass, 3 * n * sizeof(uint32_t));
     }
 
+    PHASE_BEGIN(m_unxf);
     for (size_t i = 0; i < n; i++) a[i] = (int32_t)(src[i] ^ 0x80000000u);
+    PHASE_END(m_unxf, "key_untransform", 2 * n * sizeof(uint32_t));
 
     free(src); free(dst); free(cnt);
 }
@@ -183,23 +220,24 @@ static void radix_f32(float* a, size_t n) {
 
     uint32_t* src = (uint32_t*)malloc(n * sizeof(uint32_t));
     uint32_t* dst = (uint32_t*)malloc(n * sizeof(uint32_t));
-    uint32_t* cnt = (uint32_t*)calloc(65536u, sizeof(uint32_t));
+    uint32_t* cnt = (uint32_t*)calloc(HIST_TABLES * 65536u, sizeof(uint32_t));
     if (!src || !dst || !cnt) {
         fprintf(stderr, "Allocation failed (radix_f32)\n");
         exit(1);
     }
 
+    PHASE_BEGIN(m_xf);
     for (size_t i = 0; i < n; i++) {
         uint32_t x;
         memcpy(&x, &a[i], sizeof(x));
         src[i] = flip_f32(x);
     }
+    PHASE_END(m_xf, "key_transform", 2 * n * sizeof(uint32_t));
 
     for (int pass = 0; pass < 2; pass++) {
-        memset(cnt, 0, 65536u * sizeof(uint32_t));
+        PHASE_BEGIN(m_pass);
         int shift = pass * 16;
-
-        for (size_t i = 0; i < n; i++) cnt[(src[i] >> shift) & 0xFFFFu]++;
+        hist16_u32(src, n, shift, cnt);
 
         uint32_t sum = 0;
         for (uint32_t i = 0; i < 65536u; i++) {
@@ -214,12 +252,15 @@ static void radix_f32(float* a, size_t n) {
         }
 
         uint32_t* tmp = src; src = dst; dst = tmp;
+        PHASE_END_IDX(m_pass, "radix_pass", pass, 3 * n * sizeof(uint32_t));
     }
 
+    PHASE_BEGIN(m_unxf);
     for (size_t i = 0; i < n; i++) {
         uint32_t x = unflip_f32(src[i]);
         memcpy(&a[i], &x, sizeof(x));
     }
+    PHASE_END(m_unxf, "key_untransform", 2 * n * sizeof(uint32_t));
 
     free(src); free(dst); free(cnt);
 }
@@ -230,23 +271,24 @@ static void radix_f64(double* a, size_t n) {
 
     uint64_t* src = (uint64_t*)malloc(n * sizeof(uint64_t));
     uint64_t* dst = (uint64_t*)malloc(n * sizeof(uint64_t));
-    uint32_t* cnt = (uint32_t*)calloc(65536u, sizeof(uint32_t));
+    uint32_t* cnt = (uint32_t*)calloc(HIST_TABLES * 65536u, sizeof(uint32_t));
     if (!src || !dst || !cnt) {
         fprintf(stderr, "Allocation failed (radix_f64)\n");
         exit(1);
     }
 
+    PHASE_BEGIN(m_xf);
     for (size_t i = 0; i < n; i++) {
         uint64_t x;
         memcpy(&x, &a[i], sizeof(x));
         src[i] = flip_f64(x);
     }
+    PHASE_END(m_xf, "key_transform", 2 * n * sizeof(uint64_t));
 
     for (int pass = 0; pass < 4; pass++) {
-        memset(cnt, 0, 65536u * sizeof(uint32_t));
+        PHASE_BEGIN(m_pass);
         int shift = pass * 16;
-
-        for (size_t i = 0; i < n; i++) cnt[(uint32_t)((src[i] >> shift) & 0xFFFFull)]++;
+        hist16_u64(src, n, shift, cnt);
 
         uint32_t sum = 0;
         for (uint32_t i = 0; i < 65536u; i++) {
@@ -261,12 +303,15 @@ static void radix_f64(double* a, size_t n) {
         }
 
         uint64_t* tmp = src; src = dst; dst = tmp;
+        PHASE_END_IDX(m_pass, "radix_pass", pass, 3 * n * sizeof(uint64_t));
     }
 
+    PHASE_BEGIN(m_unxf);
     for (size_t i = 0; i < n; i++) {
         uint64_t x = unflip_f64(src[i]);
         memcpy(&a[i], &x, sizeof(x));
     }
+    PHASE_END(m_unxf, "key_untransform", 2 * n * sizeof(uint64_t));
 
     free(src); free(dst); free(cnt);
 }
@@ -276,14 +321,135 @@ static inline void write_i32(FILE* f, int32_t v) { fprintf(f, "%d\n", v); }
 static inline void write_f32(FILE* f, float v)  { fprintf(f, "%.9g\n", v); }   // enough for float
 static inline void write_f64(FILE* f, double v) { fprintf(f, "%.17g\n", v); }  // enough for double
 
+static inline void write_i32_count(FILE* f, int32_t v, size_t c) { fprintf(f, "%d %zu\n", v, c); }
+static inline void write_f32_count(FILE* f, float v, size_t c)  { fprintf(f, "%.9g %zu\n", v, c); }
+static inline void write_f64_count(FILE* f, double v, size_t c) { fprintf(f, "%.17g %zu\n", v, c); }
+
+// ===================== output modes =====================
+//   OUT_ALL    - every value, one per line (default)
+//   OUT_UNIQUE - each distinct value once            (--unique)
+//   OUT_COUNTS - each distinct value + multiplicity  (--counts)
+typedef enum { OUT_ALL, OUT_UNIQUE, OUT_COUNTS } OutMode;
+
+// Dedup is fused into the formatter: the array is already sorted, so equal
+// values form runs. Floats compare by bit pattern so -0/+0 and NaN payloads
+// stay distinct, exactly as they print.
+static void emit_i32(FILE* f, const int32_t* a, size_t n, OutMode mode) {
+    if (mode == OUT_ALL) {
+        for (size_t i = 0; i < n; i++) write_i32(f, a[i]);
+        return;
+    }
+    for (size_t i = 0; i < n;) {
+        size_t j = i + 1;
+        while (j < n && a[j] == a[i]) j++;
+        if (mode == OUT_UNIQUE) write_i32(f, a[i]);
+        else write_i32_count(f, a[i], j - i);
+        i = j;
+    }
+}
+
+static void emit_f32(FILE* f, const float* a, size_t n, OutMode mode) {
+    if (mode == OUT_ALL) {
+        for (size_t i = 0; i < n; i++) write_f32(f, a[i]);
+        return;
+    }
+    for (size_t i = 0; i < n;) {
+        uint32_t x, y;
+        memcpy(&x, &a[i], sizeof(x));
+        size_t j = i + 1;
+        for (; j < n; j++) {
+            memcpy(&y, &a[j], sizeof(y));
+            if (y != x) break;
+        }
+        if (mode == OUT_UNIQUE) write_f32(f, a[i]);
+        else write_f32_count(f, a[i], j - i);
+        i = j;
+    }
+}
+
+static void emit_f64(FILE* f, const double* a, size_t n, OutMode mode) {
+    if (mode == OUT_ALL) {
+        for (size_t i = 0; i < n; i++) write_f64(f, a[i]);
+        return;
+    }
+    for (size_t i = 0; i < n;) {
+        uint64_t x, y;
+        memcpy(&x, &a[i], sizeof(x));
+        size_t j = i + 1;
+        for (; j < n; j++) {
+            memcpy(&y, &a[j], sizeof(y));
+            if (y != x) break;
+        }
+        if (mode == OUT_UNIQUE) write_f64(f, a[i]);
+        else write_f64_count(f, a[i], j - i);
+        i = j;
+    }
+}
+
+// ===================== histogram path (unique/counts, int32) =====================
+// When the key range is small, a single counting pass replaces the sort: no
+// src/dst copies and no scatter. The table is walked in order at output time.
+#ifndef HIST_MAX_RANGE
+#define HIST_MAX_RANGE (1u << 22)
+#endif
+
+static uint32_t* hist_i32(const int32_t* a, size_t n, int32_t* out_lo, uint32_t* out_range) {
+    if (n == 0) return NULL;
+
+    int32_t lo = a[0], hi = a[0];
+    for (size_t i = 1; i < n; i++) {
+        if (a[i] < lo) lo = a[i];
+        if (a[i] > hi) hi = a[i];
+    }
+    uint64_t range = (uint64_t)((int64_t)hi - (int64_t)lo) + 1u;
+    if (range > HIST_MAX_RANGE || range > 2u * (uint64_t)n) return NULL;
+
+    uint32_t* cnt = (uint32_t*)calloc((size_t)range, sizeof(uint32_t));
+    if (!cnt) return NULL;
+    PHASE_BEGIN(m_hist);
+    for (size_t i = 0; i < n; i++) cnt[(uint32_t)(a[i] - lo)]++;
+    PHASE_END(m_hist, "histogram", n * sizeof(int32_t));
+
+    *out_lo = lo;
+    *out_range = (uint32_t)range;
+    return cnt;
+}
+
+static void emit_hist_i32(FILE* f, const uint32_t* cnt, int32_t lo, uint32_t range, OutMode mode) {
+    for (uint32_t k = 0; k < range; k++) {
+        if (!cnt[k]) continue;
+        int32_t v = (int32_t)((int64_t)lo + k);
+        if (mode == OUT_UNIQUE) write_i32(f, v);
+        else write_i32_count(f, v, cnt[k]);
+    }
+}
+
 // ===================== main =====================
 int main(int argc, char** argv) {
-    if (argc < 2 || argc > 3) return 2;
+    // usage: sort [--unique | --counts] [--report FILE|stderr] [--perf] <input> [output|stdout]
+    OutMode mode = OUT_ALL;
+    const char* in_path = NULL;
+    const char* out_path = NULL;
+    const char* report_path = NULL;
+    int perf = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--unique") == 0) mode = OUT_UNIQUE;
+        else if (strcmp(argv[i], "--counts") == 0) mode = OUT_COUNTS;
+        else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) report_path = argv[++i];
+        else if (strcmp(argv[i], "--perf") == 0) perf = 1;
+        else if (strncmp(argv[i], "--", 2) == 0) return 2;
+        else if (!in_path) in_path = argv[i];
+        else if (!out_path) out_path = argv[i];
+        else return 2;
+    }
+    if (!in_path) return 2;
+    if (perf) inst_perf_init();
 
     // ---- read (not timed) ----
-    FILE* in = fopen(argv[1], "rb");
+    PHASE_BEGIN(m_read);
+    FILE* in = fopen(in_path, "rb");
     if (!in) {
-        fprintf(stderr, "Failed to open input file '%s': %s\n", argv[1], strerror(errno));
+        fprintf(stderr, "Failed to open input file '%s': %s\n", in_path, strerror(errno));
         return 1;
     }
 
@@ -295,17 +461,21 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    PHASE_END(m_read, "read", len);
+
+    PHASE_BEGIN(m_detect);
     NumType type = detect_type(buf);
+    PHASE_END(m_detect, "detect_type", len);
 
     // ---- output handle ----
     FILE* out = NULL;
-    int will_output = (argc == 3);
+    int will_output = (out_path != NULL);
     if (will_output) {
-        if (strcmp(argv[2], "stdout") == 0) out = stdout;
+        if (strcmp(out_path, "stdout") == 0) out = stdout;
         else {
-            out = fopen(argv[2], "wb");
+            out = fopen(out_path, "wb");
             if (!out) {
-                fprintf(stderr, "Failed to open output file '%s': %s\n", argv[2], strerror(errno));
+                fprintf(stderr, "Failed to open output file '%s': %s\n", out_path, strerror(errno));
                 free(buf);
                 return 1;
             }
@@ -315,41 +485,73 @@ int main(int argc, char** argv) {
     // ---- timing: sorting + output ----
     TICK(t_total_start);
     double sort_only = 0.0;
+    size_t n_sorted = 0;
 
     if (type == T_INT32) {
         int32_t* a = (int32_t*)malloc((size_t)N_EXPECTED * sizeof(int32_t));
         if (!a) { fprintf(stderr, "Allocation failed\n"); exit(1); }
+        PHASE_BEGIN(m_parse);
         size_t n = parse_i32_capped(buf, (size_t)N_EXPECTED, a);
+        PHASE_END(m_parse, "parse", len + n * sizeof(int32_t));
+        n_sorted = n;
+
+        int32_t lo = 0;
+        uint32_t range = 0;
+        uint32_t* cnt = NULL;
 
         TICK(t_sort_start);
-        radix_i32(a, n);
+        if (mode != OUT_ALL) cnt = hist_i32(a, n, &lo, &range);
+        if (!cnt) radix_i32(a, n);
         sort_only = TOCK(t_sort_start);
 
-        if (will_output) for (size_t i = 0; i < n; i++) write_i32(out, a[i]);
+        if (will_output) {
+            PHASE_BEGIN(m_out);
+            if (cnt) emit_hist_i32(out, cnt, lo, range, mode);
+            else emit_i32(out, a, n, mode);
+            fflush(out);
+            PHASE_END(m_out, "format_write", ftell(out) > 0 ? (size_t)ftell(out) : 0);
+        }
+        free(cnt);
         free(a);
 
     } else if (type == T_FLOAT32) {
         float* a = (float*)malloc((size_t)N_EXPECTED * sizeof(float));
         if (!a) { fprintf(stderr, "Allocation failed\n"); exit(1); }
+        PHASE_BEGIN(m_parse);
         size_t n = parse_f32_capped(buf, (size_t)N_EXPECTED, a);
+        PHASE_END(m_parse, "parse", len + n * sizeof(float));
+        n_sorted = n;
 
         TICK(t_sort_start);
         radix_f32(a, n);
         sort_only = TOCK(t_sort_start);
 
-        if (will_output) for (size_t i = 0; i < n; i++) write_f32(out, a[i]);
+        if (will_output) {
+            PHASE_BEGIN(m_out);
+            emit_f32(out, a, n, mode);
+            fflush(out);
+            PHASE_END(m_out, "format_write", ftell(out) > 0 ? (size_t)ftell(out) : 0);
+        }
         free(a);
 
     } else {
         double* a = (double*)malloc((size_t)N_EXPECTED * sizeof(double));
         if (!a) { fprintf(stderr, "Allocation failed\n"); exit(1); }
+        PHASE_BEGIN(m_parse);
         size_t n = parse_f64_capped(buf, (size_t)N_EXPECTED, a);
+        PHASE_END(m_parse, "parse", len + n * sizeof(double));
+        n_sorted = n;
 
         TICK(t_sort_start);
         radix_f64(a, n);
         sort_only = TOCK(t_sort_start);
 
-        if (will_output) for (size_t i = 0; i < n; i++) write_f64(out, a[i]);
+        if (will_output) {
+            PHASE_BEGIN(m_out);
+            emit_f64(out, a, n, mode);
+            fflush(out);
+            PHASE_END(m_out, "format_write", ftell(out) > 0 ? (size_t)ftell(out) : 0);
+        }
         free(a);
     }
 
@@ -360,5 +562,8 @@ int main(int argc, char** argv) {
 
     PRINT_TIME("SORT_ONLY", sort_only);
     PRINT_TIME("SORT_PLUS_OUTPUT", sort_plus_output);
+
+    static const char* const type_names[] = {"int32", "float32", "float64"};
+    inst_report(report_path, "sort", type_names[type], n_sorted, 1, sort_only, sort_plus_output);
     return 0;
 }
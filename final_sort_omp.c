@@ -1,18 +1,33 @@
 // Build:
 //   gcc -O3 -march=native -std=c11 -Wall -Wextra -fopenmp -o sort_omp
-//   final_sort_omp.c
+//   final_sort_omp.c sort_dist.c libsort/*.c
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 
 #include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <time.h>
+#include <unistd.h>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
+#include "instrument.h"
+#include "libsort/sort.h"
+#include "sort_dist.h"
+#include "sort_proto.h"
+
 #ifndef N_EXPECTED
 #define N_EXPECTED 1000000u
 #endif
@@ -30,10 +45,16 @@ static inline double now_sec(void) {
   do {                                                   \
     fprintf(stderr, "%s: %.6f s\n", (label), (seconds)); \
   } while (0)
+#define PRINT_PEAK_RSS()                                \
+  do {                                                  \
+    fprintf(stderr, "PEAK_RSS: %.1f MB\n",             \
+            (double)inst_peak_rss_kb() / 1024.0);       \
+  } while (0)
 #else
 #define TICK(var)
 #define TOCK(var) (0.0)
 #define PRINT_TIME(label, sec)
+#define PRINT_PEAK_RSS()
 #endif
 
 // ===================== file read =====================
@@ -61,6 +82,10 @@ static unsigned char* read_all(FILE* f, size_t* out_len) {
 // ===================== type detect =====================
 typedef enum { T_INT32, T_FLOAT32, T_FLOAT64 } NumType;
 
+static const char* const type_names[] = {"int32", "float32", "float64"};
+static const size_t type_sizes[] = {sizeof(int32_t), sizeof(float),
+                                    sizeof(double)};
+
 static NumType detect_type(const unsigned char* b) {
   //   - default float32 for decimal-only (no e/E)
   //   - float64 if e/E exists
@@ -153,25 +178,162 @@ static size_t parse_f64_capped(const unsigned char* buf,
   return n;
 }
 
-// ===================== radix key transforms =====================
+// ===================== libsort glue =====================
+// Sorting goes through libsort with one context for the whole run; its
+// per-phase callbacks feed instrument.h.
+#ifndef NO_TIMING
+static InstMark g_lib_mark;
 
-static inline uint32_t flip_f32(uint32_t x) {
-  return (x & 0x80000000u) ? ~x : (x ^ 0x80000000u);
+static void lib_phase_begin(void* user) {
+  (void)user;
+  g_lib_mark = inst_mark();
 }
-static inline uint32_t unflip_f32(uint32_t k) {
-  return (k & 0x80000000u) ? (k ^ 0x80000000u) : ~k;
+
+static void lib_phase_end(void* user,
+                          const char* name,
+                          int index,
+                          uint64_t bytes) {
+  (void)user;
+  inst_record(name, index, &g_lib_mark, bytes);
 }
+#endif
 
-static inline uint64_t flip_f64(uint64_t x) {
-  return (x & 0x8000000000000000ull) ? ~x : (x ^ 0x8000000000000000ull);
+static void check_sort(int rc) {
+  if (rc != SORT_OK) {
+    fprintf(stderr, "Sort failed (%s)\n",
+            rc == SORT_ENOMEM ? "allocation" : "invalid input");
+    exit(1);
+  }
+}
+
+// One context per run (or per server), loaded with the tuning profile from
+// --profile / $SORT_PROFILE when one is given.
+static sort_ctx* make_ctx(const sort_tuning* tuning, const char* profile) {
+  sort_ctx* ctx = sort_ctx_create(tuning);
+  if (!ctx) {
+    fprintf(stderr, "Allocation failed\n");
+    exit(1);
+  }
+  if (profile && sort_ctx_load_profile(ctx, profile) != SORT_OK) {
+    fprintf(stderr, "Failed to load tuning profile '%s'\n", profile);
+    exit(2);
+  }
+  return ctx;
+}
+
+// ===================== output helpers =====================
+static inline void write_i32(FILE* f, int32_t v) {
+  fprintf(f, "%d\n", v);
+}
+static inline void write_f32(FILE* f, float v) {
+  fprintf(f, "%.9g\n", v);
+}  // enough for float
+static inline void write_f64(FILE* f, double v) {
+  fprintf(f, "%.17g\n", v);
+}  // enough for double
+
+static inline void write_i32_count(FILE* f, int32_t v, size_t c) {
+  fprintf(f, "%d %zu\n", v, c);
+}
+static inline void write_f32_count(FILE* f, float v, size_t c) {
+  fprintf(f, "%.9g %zu\n", v, c);
+}
+static inline void write_f64_count(FILE* f, double v, size_t c) {
+  fprintf(f, "%.17g %zu\n", v, c);
+}
+
+// ===================== output modes =====================
+//   OUT_ALL    - every value, one per line (default)
+//   OUT_UNIQUE - each distinct value once            (--unique)
+//   OUT_COUNTS - each distinct value + multiplicity  (--counts)
+//   OUT_COLUMN - every value, as a compressed sorted column (--column;
+//                sort_col_encode, read back with col_decode)
+typedef enum { OUT_ALL, OUT_UNIQUE, OUT_COUNTS, OUT_COLUMN } OutMode;
+
+// Dedup is fused into the formatter: the array is already sorted, so equal
+// values form runs. Floats compare by bit pattern so -0/+0 and NaN payloads
+// stay distinct, exactly as they print.
+static void emit_i32(FILE* f, const int32_t* a, size_t n, OutMode mode) {
+  if (mode == OUT_ALL) {
+    for (size_t i = 0; i < n; i++)
+      write_i32(f, a[i]);
+    return;
+  }
+  for (size_t i = 0; i < n;) {
+    size_t j = i + 1;
+    while (j < n && a[j] == a[i])
+      j++;
+    if (mode == OUT_UNIQUE)
+      write_i32(f, a[i]);
+    else
+      write_i32_count(f, a[i], j - i);
+    i = j;
+  }
+}
+
+static void emit_f32(FILE* f, const float* a, size_t n, OutMode mode) {
+  if (mode == OUT_ALL) {
+    for (size_t i = 0; i < n; i++)
+      write_f32(f, a[i]);
+    return;
+  }
+  for (size_t i = 0; i < n;) {
+    uint32_t x, y;
+    memcpy(&x, &a[i], sizeof(x));
+    size_t j = i + 1;
+    for (; j < n; j++) {
+      memcpy(&y, &a[j], sizeof(y));
+      if (y != x)
+        break;
+    }
+    if (mode == OUT_UNIQUE)
+      write_f32(f, a[i]);
+    else
+      write_f32_count(f, a[i], j - i);
+    i = j;
+  }
 }
-static inline uint64_t unflip_f64(uint64_t k) {
-  return (k & 0x8000000000000000ull) ? (k ^ 0x8000000000000000ull) : ~k;
+
+static void emit_f64(FILE* f, const double* a, size_t n, OutMode mode) {
+  if (mode == OUT_ALL) {
+    for (size_t i = 0; i < n; i++)
+      write_f64(f, a[i]);
+    return;
+  }
+  for (size_t i = 0; i < n;) {
+    uint64_t x, y;
+    memcpy(&x, &a[i], sizeof(x));
+    size_t j = i + 1;
+    for (; j < n; j++) {
+      memcpy(&y, &a[j], sizeof(y));
+      if (y != x)
+        break;
+    }
+    if (mode == OUT_UNIQUE)
+      write_f64(f, a[i]);
+    else
+      write_f64_count(f, a[i], j - i);
+    i = j;
+  }
 }
 
-// ===================== omp radix internals =====================
-static void radix_u32_omp(uint32_t* src, uint32_t* dst, size_t n, int passes) {
-  const uint32_t buckets = 65536u;
+// ===================== histogram path (int32) =====================
+// When the key range is small, a single counting pass replaces the sort: no
+// src/dst copies and no scatter. Each thread counts into a private table and
+// the tables are reduced in parallel over key ranges.
+#ifndef HIST_MAX_RANGE
+#define HIST_MAX_RANGE (1u << 22)
+#endif
+#ifndef HIST_MAX_CELLS
+#define HIST_MAX_CELLS ((size_t)1 << 24)
+#endif
+
+static uint32_t* hist_i32(const int32_t* a,
+                          size_t n,
+                          int32_t* out_lo,
+                          uint32_t* out_range) {
+  if (n == 0)
+    return NULL;
 #ifdef _OPENMP
   int threads = omp_get_max_threads();
 #else
@@ -180,382 +342,2200 @@ static void radix_u32_omp(uint32_t* src, uint32_t* dst, size_t n, int passes) {
   if (threads < 1)
     threads = 1;
 
-  uint32_t* all_counts =
-      (uint32_t*)calloc((size_t)threads * buckets, sizeof(uint32_t));
-  uint32_t* all_offsets =
-      (uint32_t*)malloc((size_t)threads * buckets * sizeof(uint32_t));
-  uint32_t* global = (uint32_t*)malloc(buckets * sizeof(uint32_t));
-  if (!all_counts || !all_offsets || !global) {
-    fprintf(stderr, "Allocation failed (radix_u32_omp)\n");
-    exit(1);
+  int32_t lo = a[0], hi = a[0];
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) reduction(min : lo) \
+    reduction(max : hi)
+#endif
+  for (size_t i = 0; i < n; i++) {
+    if (a[i] < lo)
+      lo = a[i];
+    if (a[i] > hi)
+      hi = a[i];
   }
+  uint64_t range = (uint64_t)((int64_t)hi - (int64_t)lo) + 1u;
+  if (range > HIST_MAX_RANGE || range > 2u * (uint64_t)n ||
+      (size_t)range * (size_t)threads > HIST_MAX_CELLS)
+    return NULL;
 
-  for (int pass = 0; pass < passes; pass++) {
-    int shift = pass * 16;
-    memset(all_counts, 0, (size_t)threads * buckets * sizeof(uint32_t));
+  uint32_t* all_counts =
+      (uint32_t*)calloc((size_t)threads * range, sizeof(uint32_t));
+  if (!all_counts)
+    return NULL;
 
+  // Sliced by the team that starts, which can be smaller than `threads`
+  // (OMP_THREAD_LIMIT, OMP_DYNAMIC); `threads` only sizes the tables.
+  int team = 1;
+  PHASE_BEGIN(m_hist);
 #ifdef _OPENMP
 #pragma omp parallel num_threads(threads)
 #endif
-    {
+  {
 #ifdef _OPENMP
-      int tid = omp_get_thread_num();
+    int tid = omp_get_thread_num();
+    int nt = omp_get_num_threads();
 #else
-      int tid = 0;
+    int tid = 0;
+    int nt = 1;
 #endif
-      size_t start = (n * (size_t)tid) / (size_t)threads;
-      size_t end = (n * (size_t)(tid + 1)) / (size_t)threads;
-      uint32_t* local = all_counts + (size_t)tid * buckets;
+    if (tid == 0)
+      team = nt;
+    size_t start = (n * (size_t)tid) / (size_t)nt;
+    size_t end = (n * (size_t)(tid + 1)) / (size_t)nt;
+    uint32_t* local = all_counts + (size_t)tid * range;
+
+    for (size_t i = start; i < end; i++)
+      local[(uint32_t)(a[i] - lo)]++;
+  }
 
-      for (size_t i = start; i < end; i++) {
-        uint32_t b = (src[i] >> shift) & 0xFFFFu;
-        local[b]++;
-      }
+  // reduce into table 0
+  if (team > 1) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads)
+#endif
+    for (size_t k = 0; k < (size_t)range; k++) {
+      uint32_t c = all_counts[k];
+      for (int t = 1; t < team; t++)
+        c += all_counts[(size_t)t * range + k];
+      all_counts[k] = c;
     }
+  }
+  PHASE_END(m_hist, "histogram", n * sizeof(int32_t));
+
+  *out_lo = lo;
+  *out_range = (uint32_t)range;
+  return all_counts;
+}
+
+static void emit_hist_i32(FILE* f,
+                          const uint32_t* cnt,
+                          int32_t lo,
+                          uint32_t range,
+                          OutMode mode) {
+  for (uint32_t k = 0; k < range; k++) {
+    if (!cnt[k])
+      continue;
+    int32_t v = (int32_t)((int64_t)lo + k);
+    if (mode == OUT_UNIQUE)
+      write_i32(f, v);
+    else
+      write_i32_count(f, v, cnt[k]);
+  }
+}
+
+// ===================== multi-file mode =====================
+// `-o OUT <input>...` sorts many shards into one output; each input may be
+// a quoted glob. Files are read and parsed concurrently, one file per
+// thread, and all shards are parsed as the widest type any of them has.
+//   combined   (default) sort all shards as one array (an ingest fed by
+//              the shards, so they are never concatenated)
+//   per-file   sort every shard on its own, then k-way merge
+//   merge-only shards are already sorted: only merge (a shard that turns
+//              out unsorted is sorted first, with a warning)
+// Like the single-file path, each shard contributes at most N_EXPECTED
+// values.
+typedef enum { MULTI_COMBINED, MULTI_PER_FILE, MULTI_MERGE_ONLY } MultiMode;
+
+typedef struct {
+  const char* path;
+  unsigned char* buf;
+  size_t len;
+  NumType type;
+  void* vals;
+  size_t vals_bytes;
+  size_t n;
+} Shard;
+
+static size_t parse_any(NumType t,
+                        const unsigned char* buf,
+                        size_t cap,
+                        void* out) {
+  if (t == T_INT32)
+    return parse_i32_capped(buf, cap, (int32_t*)out);
+  if (t == T_FLOAT32)
+    return parse_f32_capped(buf, cap, (float*)out);
+  return parse_f64_capped(buf, cap, (double*)out);
+}
+
+static int sort_any(sort_ctx* ctx, NumType t, void* a, size_t n) {
+  if (t == T_INT32)
+    return sort_i32(ctx, (int32_t*)a, n);
+  if (t == T_FLOAT32)
+    return sort_f32(ctx, (float*)a, n);
+  return sort_f64(ctx, (double*)a, n);
+}
+
+static int merge_any(sort_ctx* ctx,
+                     NumType t,
+                     const void** runs,
+                     const size_t* lens,
+                     int k,
+                     void* out) {
+  if (t == T_INT32)
+    return merge_i32(ctx, (const int32_t* const*)runs, lens, k,
+                     (int32_t*)out);
+  if (t == T_FLOAT32)
+    return merge_f32(ctx, (const float* const*)runs, lens, k, (float*)out);
+  return merge_f64(ctx, (const double* const*)runs, lens, k, (double*)out);
+}
+
+// NumType and SORT_COL_* number the types alike.
+static void emit_column(FILE* f, sort_ctx* ctx, NumType t, const void* a,
+                        size_t n) {
+  size_t bytes = sort_col_bound((int)t, n);
+  void* col = malloc(bytes);
+  if (!col) {
+    fprintf(stderr, "Allocation failed\n");
+    exit(1);
+  }
+  check_sort(sort_col_encode(ctx, (int)t, a, n, col, &bytes));
+  fwrite(col, 1, bytes, f);
+  free(col);
+}
+
+static void emit_any(FILE* f,
+                     sort_ctx* ctx,
+                     NumType t,
+                     const void* a,
+                     size_t n,
+                     OutMode m) {
+  if (m == OUT_COLUMN)
+    emit_column(f, ctx, t, a, n);
+  else if (t == T_INT32)
+    emit_i32(f, (const int32_t*)a, n, m);
+  else if (t == T_FLOAT32)
+    emit_f32(f, (const float*)a, n, m);
+  else
+    emit_f64(f, (const double*)a, n, m);
+}
 
-    uint32_t sum = 0;
-    for (uint32_t b = 0; b < buckets; b++) {
-      uint32_t c = 0;
-      for (int t = 0; t < threads; t++)
-        c += all_counts[(size_t)t * buckets + b];
-      global[b] = sum;
-      sum += c;
+// Sortedness in the order libsort sorts in (floats by IEEE total order).
+static int is_sorted_any(NumType t, const void* a, size_t n) {
+  for (size_t i = 1; i < n; i++) {
+    if (t == T_INT32) {
+      if (((const int32_t*)a)[i - 1] > ((const int32_t*)a)[i])
+        return 0;
+    } else if (t == T_FLOAT32) {
+      uint32_t x, y;
+      memcpy(&x, (const float*)a + i - 1, sizeof(x));
+      memcpy(&y, (const float*)a + i, sizeof(y));
+      x ^= (uint32_t)((int32_t)x >> 31) | 0x80000000u;
+      y ^= (uint32_t)((int32_t)y >> 31) | 0x80000000u;
+      if (x > y)
+        return 0;
+    } else {
+      uint64_t x, y;
+      memcpy(&x, (const double*)a + i - 1, sizeof(x));
+      memcpy(&y, (const double*)a + i, sizeof(y));
+      x ^= (uint64_t)((int64_t)x >> 63) | 0x8000000000000000ull;
+      y ^= (uint64_t)((int64_t)y >> 63) | 0x8000000000000000ull;
+      if (x > y)
+        return 0;
     }
+  }
+  return 1;
+}
 
-    for (uint32_t b = 0; b < buckets; b++) {
-      uint32_t pos = global[b];
-      for (int t = 0; t < threads; t++) {
-        size_t idx = (size_t)t * buckets + b;
-        all_offsets[idx] = pos;
-        pos += all_counts[idx];
+// Expands arguments containing glob characters; others are taken as is.
+static const char** expand_inputs(char** args, int n_args, int* n_out) {
+  size_t cap = 16, n = 0;
+  const char** paths = (const char**)malloc(cap * sizeof(char*));
+  for (int i = 0; paths && i < n_args; i++) {
+    glob_t g;
+    const char* one = args[i];
+    char** list = (char**)&one;
+    size_t count = 1;
+    int globbed = strpbrk(args[i], "*?[") != NULL;
+    if (globbed) {
+      if (glob(args[i], 0, NULL, &g) != 0) {
+        fprintf(stderr, "No input files match '%s'\n", args[i]);
+        free(paths);
+        return NULL;
       }
+      list = g.gl_pathv;
+      count = g.gl_pathc;
     }
-
-#ifdef _OPENMP
-#pragma omp parallel num_threads(threads)
-#endif
-    {
-#ifdef _OPENMP
-      int tid = omp_get_thread_num();
-#else
-      int tid = 0;
-#endif
-      size_t start = (n * (size_t)tid) / (size_t)threads;
-      size_t end = (n * (size_t)(tid + 1)) / (size_t)threads;
-      uint32_t* local_off = all_offsets + (size_t)tid * buckets;
-
-      for (size_t i = start; i < end; i++) {
-        uint32_t x = src[i];
-        uint32_t b = (x >> shift) & 0xFFFFu;
-        dst[local_off[b]++] = x;
+    for (size_t j = 0; j < count; j++) {
+      if (n == cap) {
+        cap *= 2;
+        const char** grown =
+            (const char**)realloc(paths, cap * sizeof(char*));
+        if (!grown) {
+          free(paths);
+          return NULL;
+        }
+        paths = grown;
       }
+      paths[n++] = globbed ? strdup(list[j]) : list[j];
     }
-
-    uint32_t* tmp = src;
-    src = dst;
-    dst = tmp;
+    if (globbed)
+      globfree(&g);
   }
-
-  free(all_counts);
-  free(all_offsets);
-  free(global);
+  *n_out = (int)n;
+  return paths;
 }
 
-static void radix_u64_omp(uint64_t* src, uint64_t* dst, size_t n, int passes) {
-  const uint32_t buckets = 65536u;
+static int run_multi(char** inputs,
+                     int n_inputs,
+                     const char* out_path,
+                     MultiMode multi,
+                     OutMode mode,
+                     const sort_tuning* tuning,
+                     const char* profile,
+                     const char* report_path) {
+  int k = 0;
+  const char** paths = expand_inputs(inputs, n_inputs, &k);
+  if (!paths || k == 0)
+    return 1;
+  Shard* sh = (Shard*)calloc((size_t)k, sizeof(Shard));
+  if (!sh) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
 #ifdef _OPENMP
   int threads = omp_get_max_threads();
 #else
   int threads = 1;
 #endif
-  if (threads < 1)
-    threads = 1;
 
-  uint32_t* all_counts =
-      (uint32_t*)calloc((size_t)threads * buckets, sizeof(uint32_t));
-  uint32_t* all_offsets =
-      (uint32_t*)malloc((size_t)threads * buckets * sizeof(uint32_t));
-  uint32_t* global = (uint32_t*)malloc(buckets * sizeof(uint32_t));
-  if (!all_counts || !all_offsets || !global) {
-    fprintf(stderr, "Allocation failed (radix_u64_omp)\n");
-    exit(1);
+  // ---- read (not timed), one file per thread ----
+  PHASE_BEGIN(m_read);
+  int failed = 0;
+  size_t total_len = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) reduction(+ : total_len) \
+    reduction(|| : failed)
+#endif
+  for (int i = 0; i < k; i++) {
+    sh[i].path = paths[i];
+    FILE* in = fopen(paths[i], "rb");
+    if (in) {
+      sh[i].buf = read_all(in, &sh[i].len);
+      fclose(in);
+    }
+    if (!sh[i].buf) {
+      fprintf(stderr, "Failed to read input file '%s'\n", paths[i]);
+      failed = 1;
+      continue;
+    }
+    sh[i].type = detect_type(sh[i].buf);
+    total_len += sh[i].len;
   }
+  PHASE_END(m_read, "read", total_len);
+  if (failed)
+    return 1;
 
-  for (int pass = 0; pass < passes; pass++) {
-    int shift = pass * 16;
-    memset(all_counts, 0, (size_t)threads * buckets * sizeof(uint32_t));
+  NumType type = T_INT32;
+  for (int i = 0; i < k; i++)
+    if (sh[i].type > type)
+      type = sh[i].type;
+  const size_t esz = type_sizes[type];
 
-#ifdef _OPENMP
-#pragma omp parallel num_threads(threads)
+  FILE* out = NULL;
+  if (out_path) {
+    out = strcmp(out_path, "stdout") == 0 ? stdout : fopen(out_path, "wb");
+    if (!out) {
+      fprintf(stderr, "Failed to open output file '%s': %s\n", out_path,
+              strerror(errno));
+      return 1;
+    }
+  }
+
+  sort_ctx* ctx = make_ctx(tuning, profile);
+#ifndef NO_TIMING
+  sort_hooks hooks = {NULL, lib_phase_begin, lib_phase_end};
+  sort_ctx_set_hooks(ctx, &hooks);
 #endif
-    {
+
+  // ---- timing: parse + sort + output ----
+  // Combined shards are not concatenated: each parsed shard goes into an
+  // ingest as its own producer, counted for the radix passes while hot,
+  // and the sort scatters straight from there (NumType numbers the types
+  // like SORT_TYPE_*).
+  TICK(t_total_start);
+  sort_ingest* ingest = NULL;
+  if (multi == MULTI_COMBINED) {
+    ingest = sort_ingest_create(ctx, (int)type, k);
+    if (!ingest) {
+      fprintf(stderr, "Allocation failed\n");
+      return 1;
+    }
+  }
+  PHASE_BEGIN(m_parse);
+  size_t total = 0;
 #ifdef _OPENMP
-      int tid = omp_get_thread_num();
-#else
-      int tid = 0;
+#pragma omp parallel for schedule(dynamic, 1) reduction(+ : total) \
+    reduction(|| : failed)
 #endif
-      size_t start = (n * (size_t)tid) / (size_t)threads;
-      size_t end = (n * (size_t)(tid + 1)) / (size_t)threads;
-      uint32_t* local = all_counts + (size_t)tid * buckets;
-
-      for (size_t i = start; i < end; i++) {
-        uint32_t b = (uint32_t)((src[i] >> shift) & 0xFFFFull);
-        local[b]++;
-      }
+  for (int i = 0; i < k; i++) {
+    size_t cap = sh[i].len / 2 + 1;  // a value plus a separator per 2 bytes
+    if (cap > (size_t)N_EXPECTED)
+      cap = (size_t)N_EXPECTED;
+    sh[i].vals_bytes = cap * esz;
+    sh[i].vals = sort_alloc(sh[i].vals_bytes, tuning->pages, 0);
+    if (!sh[i].vals) {
+      failed = 1;
+      continue;
     }
-
-    uint32_t sum = 0;
-    for (uint32_t b = 0; b < buckets; b++) {
-      uint32_t c = 0;
-      for (int t = 0; t < threads; t++)
-        c += all_counts[(size_t)t * buckets + b];
-      global[b] = sum;
-      sum += c;
+    sh[i].n = parse_any(type, sh[i].buf, cap, sh[i].vals);
+    free(sh[i].buf);
+    sh[i].buf = NULL;
+    total += sh[i].n;
+    if (ingest) {
+      if (sort_ingest_append(ingest, i, sh[i].vals, sh[i].n) != SORT_OK)
+        failed = 1;
+      sort_free(sh[i].vals, sh[i].vals_bytes);
+      sh[i].vals = NULL;
     }
+  }
+  PHASE_END(m_parse, "parse", total_len + total * esz);
+  if (failed) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
 
-    for (uint32_t b = 0; b < buckets; b++) {
-      uint32_t pos = global[b];
-      for (int t = 0; t < threads; t++) {
-        size_t idx = (size_t)t * buckets + b;
-        all_offsets[idx] = pos;
-        pos += all_counts[idx];
-      }
-    }
+  const size_t res_bytes = total * esz;
+  void* res = sort_alloc(res_bytes, tuning->pages, tuning->prefault);
+  if (!res) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
+  if (multi == MULTI_COMBINED)
+    check_sort(sort_ctx_reserve(ctx, total, esz == 8 ? 8 : 4, 0));
 
+  TICK(t_sort_start);
+  if (multi == MULTI_COMBINED) {
+    check_sort(sort_ingest_finish(ingest, res));
+    sort_ingest_destroy(ingest);
+  } else {
+    // Many shards: one single-threaded sort per thread. Few shards: one
+    // shard at a time with the whole team.
+    int per_thread = k >= threads && threads > 1;
 #ifdef _OPENMP
-#pragma omp parallel num_threads(threads)
+#pragma omp parallel if (per_thread) reduction(|| : failed)
 #endif
     {
+      sort_ctx* local = ctx;
+      if (per_thread) {
+        sort_tuning single = *tuning;
+        single.threads = 1;
+        local = make_ctx(&single, NULL);
+      }
 #ifdef _OPENMP
-      int tid = omp_get_thread_num();
-#else
-      int tid = 0;
+#pragma omp for schedule(dynamic, 1)
 #endif
-      size_t start = (n * (size_t)tid) / (size_t)threads;
-      size_t end = (n * (size_t)(tid + 1)) / (size_t)threads;
-      uint32_t* local_off = all_offsets + (size_t)tid * buckets;
-
-      for (size_t i = start; i < end; i++) {
-        uint64_t x = src[i];
-        uint32_t b = (uint32_t)((x >> shift) & 0xFFFFull);
-        dst[local_off[b]++] = x;
+      for (int i = 0; i < k; i++) {
+        if (multi == MULTI_MERGE_ONLY) {
+          if (is_sorted_any(type, sh[i].vals, sh[i].n))
+            continue;
+          fprintf(stderr, "Input '%s' is not sorted; sorting it\n",
+                  sh[i].path);
+        }
+        if (sort_any(local, type, sh[i].vals, sh[i].n) != SORT_OK)
+          failed = 1;
       }
+      if (local != ctx)
+        sort_ctx_destroy(local);
     }
+    if (failed)
+      check_sort(SORT_ENOMEM);
 
-    uint64_t* tmp = src;
-    src = dst;
-    dst = tmp;
+    const void** runs = (const void**)malloc((size_t)k * sizeof(void*));
+    size_t* lens = (size_t*)malloc((size_t)k * sizeof(size_t));
+    if (!runs || !lens) {
+      fprintf(stderr, "Allocation failed\n");
+      return 1;
+    }
+    for (int i = 0; i < k; i++) {
+      runs[i] = sh[i].vals;
+      lens[i] = sh[i].n;
+    }
+    check_sort(merge_any(ctx, type, runs, lens, k, res));
+    free(runs);
+    free(lens);
   }
+  double sort_only = TOCK(t_sort_start);
 
-  free(all_counts);
-  free(all_offsets);
-  free(global);
-}
-
-// ===================== radix sort int32 (2 passes base 2^16)
-// =====================
-static void radix_i32(int32_t* a, size_t n) {
-  if (n <= 1)
-    return;
+  for (int i = 0; i < k; i++)
+    sort_free(sh[i].vals, sh[i].vals_bytes);
 
-  uint32_t* src = (uint32_t*)malloc(n * sizeof(uint32_t));
-  uint32_t* dst = (uint32_t*)malloc(n * sizeof(uint32_t));
-  if (!src || !dst) {
-    fprintf(stderr, "Allocation failed (radix_i32)\n");
-    exit(1);
+  if (out) {
+    PHASE_BEGIN(m_out);
+    emit_any(out, ctx, type, res, total, mode);
+    fflush(out);
+    PHASE_END(m_out, "format_write", ftell(out) > 0 ? (size_t)ftell(out) : 0);
   }
+  double sort_plus_output = TOCK(t_total_start);
 
-  for (size_t i = 0; i < n; i++)
-    src[i] = ((uint32_t)a[i]) ^ 0x80000000u;
-
-  radix_u32_omp(src, dst, n, 2);
-
-  for (size_t i = 0; i < n; i++)
-    a[i] = (int32_t)(src[i] ^ 0x80000000u);
+  if (out && out != stdout)
+    fclose(out);
+  sort_free(res, res_bytes);
+  sort_ctx_destroy(ctx);
+  free(sh);
 
-  free(src);
-  free(dst);
+  PRINT_TIME("SORT_ONLY", sort_only);
+  PRINT_TIME("SORT_PLUS_OUTPUT", sort_plus_output);
+  PRINT_PEAK_RSS();
+  inst_report(report_path, "sort_omp", type_names[type], total, threads,
+              sort_only, sort_plus_output);
+  return 0;
 }
 
-// ===================== radix sort float32 (2 passes base 2^16)
-// =====================
-static void radix_f32(float* a, size_t n) {
-  if (n <= 1)
-    return;
-
-  uint32_t* src = (uint32_t*)malloc(n * sizeof(uint32_t));
-  uint32_t* dst = (uint32_t*)malloc(n * sizeof(uint32_t));
-  if (!src || !dst) {
-    fprintf(stderr, "Allocation failed (radix_f32)\n");
-    exit(1);
-  }
-
-  for (size_t i = 0; i < n; i++) {
-    uint32_t x;
-    memcpy(&x, &a[i], sizeof(x));
-    src[i] = flip_f32(x);
-  }
-
-  radix_u32_omp(src, dst, n, 2);
-
-  for (size_t i = 0; i < n; i++) {
-    uint32_t x = unflip_f32(src[i]);
-    memcpy(&a[i], &x, sizeof(x));
+// ===================== record mode =====================
+// `--key SPEC` sorts the lines of a CSV/TSV file by numeric columns instead
+// of sorting bare numbers. Lines are indexed by offset and never copied.
+// Each key column is parsed and mapped to an unsigned key whose order is the
+// numeric order (sign flip for int32, flip_f32 / flip_f64 for floats, all
+// bits inverted for a descending key). The keys are packed into as few
+// 32/64-bit words as they fit in, and the line indices are radix-sorted
+// stably one word at a time, least significant word first, so there is no
+// comparator and equal keys keep input order.
+//
+// SPEC is a comma list of COL[:int|:float|:double][:desc], 1-based columns,
+// most significant first. Without a type a column is int32 when every value
+// is an integer in range, else double. A missing or non-numeric field reads
+// as 0, like `sort -n`. Fields are split on one delimiter character (tab if
+// the first line has one, else comma; or --delim), without quoting.
+#define REC_MAX_KEYS 8
+
+typedef struct {
+  int col;   // 0-based
+  int type;  // NumType, or -1 to detect
+  int desc;
+} RecKey;
+
+static int parse_key_spec(const char* spec, RecKey* keys, int* n_keys) {
+  int n = 0;
+  const char* p = spec;
+  while (*p) {
+    char* end;
+    long col = strtol(p, &end, 10);
+    if (end == p || col < 1 || col > 1 << 20 || n == REC_MAX_KEYS)
+      return -1;
+    RecKey k = {(int)col - 1, -1, 0};
+    p = end;
+    while (*p == ':') {
+      p++;
+      size_t len = strcspn(p, ":,");
+      if (len == 3 && strncmp(p, "int", 3) == 0)
+        k.type = T_INT32;
+      else if (len == 5 && strncmp(p, "float", 5) == 0)
+        k.type = T_FLOAT32;
+      else if (len == 6 && strncmp(p, "double", 6) == 0)
+        k.type = T_FLOAT64;
+      else if (len == 4 && strncmp(p, "desc", 4) == 0)
+        k.desc = 1;
+      else
+        return -1;
+      p += len;
+    }
+    keys[n++] = k;
+    if (*p == ',')
+      p++;
+    else if (*p)
+      return -1;
   }
+  *n_keys = n;
+  return n > 0 ? 0 : -1;
+}
 
-  free(src);
-  free(dst);
+static inline uint32_t flip_f32(uint32_t x) {
+  return x ^ ((uint32_t)((int32_t)x >> 31) | 0x80000000u);
 }
 
-// ===================== radix sort float64 (4 passes base 2^16)
-// =====================
-static void radix_f64(double* a, size_t n) {
-  if (n <= 1)
-    return;
+static inline uint64_t flip_f64(uint64_t x) {
+  return x ^ ((uint64_t)((int64_t)x >> 63) | 0x8000000000000000ull);
+}
 
-  uint64_t* src = (uint64_t*)malloc(n * sizeof(uint64_t));
-  uint64_t* dst = (uint64_t*)malloc(n * sizeof(uint64_t));
-  if (!src || !dst) {
-    fprintf(stderr, "Allocation failed (radix_f64)\n");
-    exit(1);
+// Parses [p, end) as one number; anything unparsable is 0.
+static double rec_value(const char* p, const char* end, int type) {
+  char tmp[64];
+  size_t len = (size_t)(end - p);
+  if (len >= sizeof(tmp))
+    len = sizeof(tmp) - 1;
+  memcpy(tmp, p, len);
+  tmp[len] = 0;
+  if (type == T_INT32) {
+    long v = strtol(tmp, NULL, 10);
+    return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (double)v;
   }
+  if (type == T_FLOAT32)
+    return strtof(tmp, NULL);
+  return strtod(tmp, NULL);
+}
 
-  for (size_t i = 0; i < n; i++) {
+// Unsigned key of `width` bits for v under key k.
+static uint64_t rec_key(double v, const RecKey* k) {
+  uint64_t key;
+  if (k->type == T_INT32) {
+    key = (uint32_t)(int32_t)v ^ 0x80000000u;
+  } else if (k->type == T_FLOAT32) {
+    float f = (float)v;
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    key = flip_f32(x);
+  } else {
     uint64_t x;
-    memcpy(&x, &a[i], sizeof(x));
-    src[i] = flip_f64(x);
-  }
-
-  radix_u64_omp(src, dst, n, 4);
-
-  for (size_t i = 0; i < n; i++) {
-    uint64_t x = unflip_f64(src[i]);
-    memcpy(&a[i], &x, sizeof(x));
+    memcpy(&x, &v, sizeof(x));
+    key = flip_f64(x);
   }
-
-  free(src);
-  free(dst);
-}
-
-// ===================== output helpers =====================
-static inline void write_i32(FILE* f, int32_t v) {
-  fprintf(f, "%d\n", v);
+  if (k->desc)
+    key = k->type == T_FLOAT64 ? ~key : (uint32_t)~key;
+  return key;
 }
-static inline void write_f32(FILE* f, float v) {
-  fprintf(f, "%.9g\n", v);
-}  // enough for float
-static inline void write_f64(FILE* f, double v) {
-  fprintf(f, "%.17g\n", v);
-}  // enough for double
-
-// ===================== main =====================
-int main(int argc, char** argv) {
-  if (argc < 2 || argc > 3)
-    return 2;
 
+static int run_records(const char* in_path,
+                       const char* out_path,
+                       const RecKey* spec,
+                       int n_keys,
+                       int delim,
+                       int header,
+                       const sort_tuning* tuning,
+                       const char* profile,
+                       const char* report_path) {
+  RecKey keys[REC_MAX_KEYS];
+  memcpy(keys, spec, (size_t)n_keys * sizeof(RecKey));
 #ifdef _OPENMP
-  omp_set_dynamic(0);
-  omp_set_num_threads(omp_get_num_procs());
+  int threads = omp_get_max_threads();
+#else
+  int threads = 1;
 #endif
 
   // ---- read (not timed) ----
-  FILE* in = fopen(argv[1], "rb");
+  PHASE_BEGIN(m_read);
+  FILE* in = fopen(in_path, "rb");
   if (!in) {
-    fprintf(stderr, "Failed to open input file '%s': %s\n", argv[1],
+    fprintf(stderr, "Failed to open input file '%s': %s\n", in_path,
             strerror(errno));
     return 1;
   }
-
   size_t len = 0;
-  unsigned char* buf = read_all(in, &len);
+  char* buf = (char*)read_all(in, &len);
   fclose(in);
   if (!buf) {
     fprintf(stderr, "Failed to read input file.\n");
     return 1;
   }
+  PHASE_END(m_read, "read", len);
 
-  NumType type = detect_type(buf);
-
-  // ---- output handle ----
   FILE* out = NULL;
-  int will_output = (argc == 3);
-  if (will_output) {
-    if (strcmp(argv[2], "stdout") == 0)
-      out = stdout;
-    else {
-      out = fopen(argv[2], "wb");
-      if (!out) {
-        fprintf(stderr, "Failed to open output file '%s': %s\n", argv[2],
-                strerror(errno));
-        free(buf);
-        return 1;
-      }
+  if (out_path) {
+    out = strcmp(out_path, "stdout") == 0 ? stdout : fopen(out_path, "wb");
+    if (!out) {
+      fprintf(stderr, "Failed to open output file '%s': %s\n", out_path,
+              strerror(errno));
+      return 1;
     }
   }
+  if (delim < 0) {
+    const char* nl = memchr(buf, '\n', len);
+    delim = memchr(buf, '\t', nl ? (size_t)(nl - buf) : len) ? '\t' : ',';
+  }
 
-  // ---- timing: sorting + output ----
-  TICK(t_total_start);
-  double sort_only = 0.0;
+  sort_ctx* ctx = make_ctx(tuning, profile);
+#ifndef NO_TIMING
+  sort_hooks hooks = {NULL, lib_phase_begin, lib_phase_end};
+  sort_ctx_set_hooks(ctx, &hooks);
+#endif
 
-  if (type == T_INT32) {
-    int32_t* a = (int32_t*)malloc((size_t)N_EXPECTED * sizeof(int32_t));
-    if (!a) {
-      fprintf(stderr, "Allocation failed\n");
-      exit(1);
+  // ---- timing: index + keys + sort + output ----
+  TICK(t_total_start);
+  PHASE_BEGIN(m_index);
+  size_t body = 0;
+  if (header) {
+    const char* nl = memchr(buf, '\n', len);
+    body = nl ? (size_t)(nl - buf) + 1 : len;
+  }
+  size_t cap = 1024, n = 0;
+  uint64_t* off = (uint64_t*)malloc(cap * sizeof(uint64_t));
+  for (size_t pos = body; off && pos < len; n++) {
+    if (n + 1 == cap) {
+      cap *= 2;
+      uint64_t* grown = (uint64_t*)realloc(off, cap * sizeof(uint64_t));
+      if (!grown)
+        free(off);
+      off = grown;
+      if (!off)
+        break;
     }
-    size_t n = parse_i32_capped(buf, (size_t)N_EXPECTED, a);
-
-    TICK(t_sort_start);
-    radix_i32(a, n);
-    sort_only = TOCK(t_sort_start);
+    off[n] = pos;
+    const char* nl = memchr(buf + pos, '\n', len - pos);
+    pos = nl ? (size_t)(nl - buf) + 1 : len;
+  }
+  if (!off || n > UINT32_MAX) {
+    fprintf(stderr, off ? "Too many lines\n" : "Allocation failed\n");
+    return 1;
+  }
+  off[n] = len;
+  PHASE_END(m_index, "index_lines", len);
+
+  // ---- key columns ----
+  PHASE_BEGIN(m_parse);
+  int max_col = 0;
+  for (int j = 0; j < n_keys; j++)
+    if (keys[j].col > max_col)
+      max_col = keys[j].col;
+  double* vals =
+      (double*)malloc((n ? n : 1) * (size_t)n_keys * sizeof(double));
+  if (!vals) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (size_t i = 0; i < n; i++) {
+    const char* p = buf + off[i];
+    const char* eol = buf + off[i + 1];
+    if (eol > p && eol[-1] == '\n')
+      eol--;
+    double* row = vals + i * (size_t)n_keys;
+    for (int j = 0; j < n_keys; j++)
+      row[j] = 0.0;
+    for (int col = 0; col <= max_col && p <= eol; col++) {
+      const char* fe = memchr(p, delim, (size_t)(eol - p));
+      if (!fe)
+        fe = eol;
+      for (int j = 0; j < n_keys; j++)
+        if (keys[j].col == col)
+          row[j] = rec_value(p, fe, keys[j].type < 0 ? T_FLOAT64
+                                                     : keys[j].type);
+      p = fe + 1;
+    }
+  }
+  for (int j = 0; j < n_keys; j++) {
+    if (keys[j].type >= 0)
+      continue;
+    int frac = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(| : frac)
+#endif
+    for (size_t i = 0; i < n; i++) {
+      double v = vals[i * (size_t)n_keys + j];
+      frac |= !(v >= INT32_MIN && v <= INT32_MAX && v == (double)(int32_t)v);
+    }
+    keys[j].type = frac ? T_FLOAT64 : T_INT32;
+  }
+  PHASE_END(m_parse, "parse_keys", len + n * (size_t)n_keys * sizeof(double));
+
+  // Pack from the least significant key up; a key that does not fit the
+  // current word starts the next one.
+  int word_of[REC_MAX_KEYS], shift_of[REC_MAX_KEYS], word_bits[REC_MAX_KEYS];
+  int n_words = 0, bits = 64;
+  for (int j = n_keys - 1; j >= 0; j--) {
+    int width = keys[j].type == T_FLOAT64 ? 64 : 32;
+    if (bits + width > 64) {
+      word_bits[n_words++] = 0;
+      bits = 0;
+    }
+    word_of[j] = n_words - 1;
+    shift_of[j] = bits;
+    bits += width;
+    word_bits[n_words - 1] = bits;
+  }
 
-    if (will_output)
-      for (size_t i = 0; i < n; i++)
-        write_i32(out, a[i]);
-    free(a);
+  uint32_t* idx = (uint32_t*)malloc((n ? n : 1) * sizeof(uint32_t));
+  uint64_t* words = (uint64_t*)malloc((n ? n : 1) * sizeof(uint64_t));
+  if (!idx || !words) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
+  check_sort(sort_ctx_reserve(ctx, n, sizeof(uint64_t), 1));
 
-  } else if (type == T_FLOAT32) {
-    float* a = (float*)malloc((size_t)N_EXPECTED * sizeof(float));
+  TICK(t_sort_start);
+  for (size_t i = 0; i < n; i++)
+    idx[i] = (uint32_t)i;
+  for (int w = 0; w < n_words; w++) {
+    uint32_t* words32 = (uint32_t*)words;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (size_t i = 0; i < n; i++) {
+      uint64_t key = 0;
+      for (int j = 0; j < n_keys; j++)
+        if (word_of[j] == w)
+          key |= rec_key(vals[i * (size_t)n_keys + j], &keys[j])
+                 << shift_of[j];
+      if (word_bits[w] <= 32)
+        words32[i] = (uint32_t)key;
+      else
+        words[i] = key;
+    }
+    if (word_bits[w] <= 32)
+      check_sort(argsort_refine_u32(ctx, words32, n, idx));
+    else
+      check_sort(argsort_refine_u64(ctx, words, n, idx));
+  }
+  double sort_only = TOCK(t_sort_start);
+  free(words);
+  free(vals);
+
+  if (out) {
+    PHASE_BEGIN(m_out);
+    fwrite(buf, 1, body, out);
+    for (size_t i = 0; i < n; i++) {
+      size_t s = off[idx[i]], e = off[idx[i] + 1];
+      fwrite(buf + s, 1, e - s, out);
+      if (e == len && buf[e - 1] != '\n')
+        fputc('\n', out);
+    }
+    fflush(out);
+    PHASE_END(m_out, "write_lines", ftell(out) > 0 ? (size_t)ftell(out) : 0);
+  }
+  double sort_plus_output = TOCK(t_total_start);
+
+  if (out && out != stdout)
+    fclose(out);
+  free(idx);
+  free(off);
+  free(buf);
+  sort_ctx_destroy(ctx);
+
+  PRINT_TIME("SORT_ONLY", sort_only);
+  PRINT_TIME("SORT_PLUS_OUTPUT", sort_plus_output);
+  PRINT_PEAK_RSS();
+  inst_report(report_path, "sort_omp", "records", n, threads, sort_only,
+              sort_plus_output);
+  return 0;
+}
+
+// ===================== line mode =====================
+// `--lines` sorts the input's lines as byte strings, in the order of
+// `LC_ALL=C sort`, instead of parsing numbers. Lines stay in the input
+// buffer as (pointer, length) references without their '\n' and are found
+// by every thread scanning its own share of the buffer. Output goes out in
+// large writev calls: short lines are copied into a staging buffer (one
+// iovec per typical line would cost more in the kernel than the copy),
+// long ones are referenced in place. With --unique only the first of equal
+// lines is kept.
+#define LINE_IOV 1024
+#define LINE_STAGE ((size_t)1 << 20)
+#define LINE_COPY_MAX 256  // longer lines are written from the input buffer
+
+// Start of the first line that begins at or after pos.
+static size_t line_start_at(const char* buf, size_t len, size_t pos) {
+  if (pos == 0)
+    return 0;
+  const char* nl = memchr(buf + pos - 1, '\n', len - pos + 1);
+  return nl ? (size_t)(nl - buf) + 1 : len;
+}
+
+// Builds references to every line of buf[0..len); *out is malloc'd.
+static size_t index_lines(const char* buf, size_t len, sort_str** out) {
+#ifdef _OPENMP
+  int threads = omp_get_max_threads();
+#else
+  int threads = 1;
+#endif
+  size_t* first = (size_t*)calloc((size_t)threads + 1, sizeof(size_t));
+  sort_str* lines = NULL;
+  int team = 1;  // the team that starts may be smaller than `threads`
+  if (!first)
+    return SIZE_MAX;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+  {
+#ifdef _OPENMP
+    size_t tid = (size_t)omp_get_thread_num();
+    size_t nt = (size_t)omp_get_num_threads();
+#else
+    size_t tid = 0;
+    size_t nt = 1;
+#endif
+    const size_t hi = len * (tid + 1) / nt;
+    const size_t lo = line_start_at(buf, len, len * tid / nt);
+    size_t count = 0;
+    for (size_t q = lo; q < hi; count++) {
+      const char* nl = memchr(buf + q, '\n', len - q);
+      q = nl ? (size_t)(nl - buf) + 1 : len;
+    }
+    first[tid + 1] = count;
+#ifdef _OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+    {
+      team = (int)nt;
+      for (int t = 0; t < team; t++)
+        first[t + 1] += first[t];
+      lines = (sort_str*)malloc((first[team] ? first[team] : 1) *
+                                sizeof(sort_str));
+    }
+    if (lines) {
+      sort_str* l = lines + first[tid];
+      for (size_t q = lo; q < hi; l++) {
+        const char* nl = memchr(buf + q, '\n', len - q);
+        size_t end = nl ? (size_t)(nl - buf) : len;
+        l->ptr = buf + q;
+        l->len = end - q;
+        q = nl ? end + 1 : len;
+      }
+    }
+  }
+  size_t n = first[team];
+  free(first);
+  *out = lines;
+  return lines ? n : SIZE_MAX;
+}
+
+// Writes all of iov[0..cnt) to fd. Returns 0 or -1.
+static int writev_all(int fd, struct iovec* iov, int cnt) {
+  while (cnt > 0) {
+    ssize_t w = writev(fd, iov, cnt);
+    if (w < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    while (cnt > 0 && (size_t)w >= iov->iov_len) {
+      w -= (ssize_t)iov->iov_len;
+      iov++;
+      cnt--;
+    }
+    if (cnt > 0) {
+      iov->iov_base = (char*)iov->iov_base + w;
+      iov->iov_len -= (size_t)w;
+    }
+  }
+  return 0;
+}
+
+// Appends [p, p + l) to iov[0..*cnt), extending the last entry when the
+// bytes follow it directly.
+static void iov_add(struct iovec* iov, int* cnt, const char* p, size_t l) {
+  if (*cnt > 0 && (char*)iov[*cnt - 1].iov_base + iov[*cnt - 1].iov_len == p) {
+    iov[*cnt - 1].iov_len += l;
+  } else {
+    iov[*cnt].iov_base = (void*)p;
+    iov[(*cnt)++].iov_len = l;
+  }
+}
+
+static int write_lines(int fd, const sort_str* lines, size_t n,
+                       const char* buf, size_t len, OutMode mode) {
+  struct iovec iov[LINE_IOV];
+  char* stage = (char*)malloc(LINE_STAGE);
+  if (!stage)
+    return -1;
+  size_t used = 0;
+  int cnt = 0;
+  for (size_t i = 0; i < n; i++) {
+    const char* p = lines[i].ptr;
+    size_t l = lines[i].len;
+    if (mode == OUT_UNIQUE && i > 0 && l == lines[i - 1].len &&
+        memcmp(p, lines[i - 1].ptr, l) == 0)
+      continue;
+    if (cnt + 2 > LINE_IOV || used + LINE_COPY_MAX + 1 > LINE_STAGE) {
+      if (writev_all(fd, iov, cnt) != 0) {
+        free(stage);
+        return -1;
+      }
+      cnt = 0;
+      used = 0;
+    }
+    int has_nl = p + l < buf + len;  // only the last line may lack one
+    if (l < LINE_COPY_MAX) {
+      memcpy(stage + used, p, l);
+      stage[used + l] = '\n';
+      iov_add(iov, &cnt, stage + used, l + 1);
+      used += l + 1;
+    } else {
+      iov_add(iov, &cnt, p, l + (size_t)has_nl);
+      if (!has_nl) {
+        stage[used] = '\n';
+        iov_add(iov, &cnt, stage + used++, 1);
+      }
+    }
+  }
+  int rc = writev_all(fd, iov, cnt);
+  free(stage);
+  return rc;
+}
+
+static int run_lines(const char* in_path,
+                     const char* out_path,
+                     OutMode mode,
+                     const sort_tuning* tuning,
+                     const char* profile,
+                     const char* report_path) {
+#ifdef _OPENMP
+  int threads = omp_get_max_threads();
+#else
+  int threads = 1;
+#endif
+
+  // ---- read (not timed) ----
+  PHASE_BEGIN(m_read);
+  FILE* in = fopen(in_path, "rb");
+  if (!in) {
+    fprintf(stderr, "Failed to open input file '%s': %s\n", in_path,
+            strerror(errno));
+    return 1;
+  }
+  size_t len = 0;
+  char* buf = (char*)read_all(in, &len);
+  fclose(in);
+  if (!buf) {
+    fprintf(stderr, "Failed to read input file.\n");
+    return 1;
+  }
+  PHASE_END(m_read, "read", len);
+
+  FILE* out = NULL;
+  if (out_path) {
+    out = strcmp(out_path, "stdout") == 0 ? stdout : fopen(out_path, "wb");
+    if (!out) {
+      fprintf(stderr, "Failed to open output file '%s': %s\n", out_path,
+              strerror(errno));
+      return 1;
+    }
+  }
+
+  sort_ctx* ctx = make_ctx(tuning, profile);
+#ifndef NO_TIMING
+  sort_hooks hooks = {NULL, lib_phase_begin, lib_phase_end};
+  sort_ctx_set_hooks(ctx, &hooks);
+#endif
+
+  // ---- timing: index + sort + output ----
+  TICK(t_total_start);
+  PHASE_BEGIN(m_index);
+  sort_str* lines = NULL;
+  size_t n = index_lines(buf, len, &lines);
+  if (n == SIZE_MAX) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
+  PHASE_END(m_index, "index_lines", len + n * sizeof(sort_str));
+
+  TICK(t_sort_start);
+  check_sort(sort_strings(ctx, lines, n));
+  double sort_only = TOCK(t_sort_start);
+
+  if (out) {
+    PHASE_BEGIN(m_out);
+    fflush(out);
+    if (write_lines(fileno(out), lines, n, buf, len, mode) != 0) {
+      fprintf(stderr, "Write failed: %s\n", strerror(errno));
+      return 1;
+    }
+    PHASE_END(m_out, "write_lines", len);
+  }
+  double sort_plus_output = TOCK(t_total_start);
+
+  if (out && out != stdout)
+    fclose(out);
+  free(lines);
+  free(buf);
+  sort_ctx_destroy(ctx);
+
+  PRINT_TIME("SORT_ONLY", sort_only);
+  PRINT_TIME("SORT_PLUS_OUTPUT", sort_plus_output);
+  PRINT_PEAK_RSS();
+  inst_report(report_path, "sort_omp", "lines", n, threads, sort_only,
+              sort_plus_output);
+  return 0;
+}
+
+// ===================== decimal mode =====================
+// `--decimal N` reads fixed-point decimals with at most N fractional digits
+// (prices such as 123.45) exactly: each token is parsed straight into an
+// int64 scaled by 10^N, so 123.45 at N = 2 is 12345, the integers are
+// radix-sorted by sort_i64, and the formatter prints them back with exactly
+// N fractional digits. Nothing goes through float, which detect_type would
+// pick for such input and which loses digits beyond about 7. A token that
+// is not [+-]digits[.digits], has more than N non-zero fractional digits or
+// does not fit in int64 at that scale is an error, not a rounded value.
+#define DEC_MAX_DIGITS 18
+#define DEC_STAGE (1u << 20)  // output staging buffer
+#define DEC_TOKEN_MAX 64      // longest formatted value, count included
+
+// Parses up to cap tokens of buf into scaled integers. Returns the count,
+// or SIZE_MAX with *bad at the offending token.
+static size_t parse_dec_capped(const unsigned char* buf,
+                               size_t cap,
+                               int digits,
+                               int64_t* out,
+                               const unsigned char** bad) {
+  const unsigned char* p = buf;
+  size_t n = 0;
+  while (*p && n < cap) {
+    while (*p && is_ws(*p))
+      p++;
+    if (!*p)
+      break;
+    const unsigned char* tok = p;
+    int neg = *p == '-';
+    if (*p == '-' || *p == '+')
+      p++;
+    uint64_t v = 0;
+    int seen = 0, ok = 1;
+    for (; *p >= '0' && *p <= '9'; p++, seen = 1)
+      ok &= !__builtin_mul_overflow(v, 10, &v) &&
+            !__builtin_add_overflow(v, (uint64_t)(*p - '0'), &v);
+    int frac = 0;
+    if (*p == '.') {
+      for (p++; *p >= '0' && *p <= '9'; p++, seen = 1) {
+        if (frac < digits) {
+          ok &= !__builtin_mul_overflow(v, 10, &v) &&
+                !__builtin_add_overflow(v, (uint64_t)(*p - '0'), &v);
+          frac++;
+        } else {
+          ok &= *p == '0';  // trailing zeros past N digits are exact
+        }
+      }
+    }
+    for (; frac < digits; frac++)
+      ok &= !__builtin_mul_overflow(v, 10, &v);
+    if (!seen || !ok || (*p && !is_ws(*p)) ||
+        v > (uint64_t)INT64_MAX + (uint64_t)neg) {
+      *bad = tok;
+      return SIZE_MAX;
+    }
+    out[n++] = neg ? (int64_t)(0 - v) : (int64_t)v;
+  }
+  return n;
+}
+
+// Formats v / 10^digits at p; returns the end.
+static inline char* format_dec(char* p, int64_t v, int digits) {
+  uint64_t m = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+  char tmp[24];
+  char* q = tmp + sizeof(tmp);
+  for (int i = 0; i < digits; i++, m /= 10)
+    *--q = (char)('0' + m % 10);
+  if (digits)
+    *--q = '.';
+  do
+    *--q = (char)('0' + m % 10);
+  while (m /= 10);
+  if (v < 0)
+    *--q = '-';
+  size_t len = (size_t)(tmp + sizeof(tmp) - q);
+  memcpy(p, q, len);
+  return p + len;
+}
+
+// Same modes as emit_i32, through a staging buffer instead of stdio.
+static int emit_dec(FILE* f, const int64_t* a, size_t n, int digits,
+                    OutMode mode) {
+  char* stage = (char*)malloc(DEC_STAGE);
+  if (!stage)
+    return -1;
+  char* p = stage;
+  for (size_t i = 0; i < n;) {
+    size_t j = i + 1;
+    if (mode != OUT_ALL)
+      while (j < n && a[j] == a[i])
+        j++;
+    p = format_dec(p, a[i], digits);
+    if (mode == OUT_COUNTS)
+      p += sprintf(p, " %zu", j - i);
+    *p++ = '\n';
+    if (p - stage > DEC_STAGE - DEC_TOKEN_MAX) {
+      fwrite(stage, 1, (size_t)(p - stage), f);
+      p = stage;
+    }
+    i = j;
+  }
+  fwrite(stage, 1, (size_t)(p - stage), f);
+  free(stage);
+  return ferror(f) ? -1 : 0;
+}
+
+static int run_decimal(const char* in_path,
+                       const char* out_path,
+                       int digits,
+                       OutMode mode,
+                       const sort_tuning* tuning,
+                       const char* profile,
+                       const char* report_path) {
+#ifdef _OPENMP
+  int threads = omp_get_max_threads();
+#else
+  int threads = 1;
+#endif
+
+  // ---- read (not timed) ----
+  PHASE_BEGIN(m_read);
+  FILE* in = fopen(in_path, "rb");
+  if (!in) {
+    fprintf(stderr, "Failed to open input file '%s': %s\n", in_path,
+            strerror(errno));
+    return 1;
+  }
+  size_t len = 0;
+  unsigned char* buf = read_all(in, &len);
+  fclose(in);
+  if (!buf) {
+    fprintf(stderr, "Failed to read input file.\n");
+    return 1;
+  }
+  PHASE_END(m_read, "read", len);
+
+  FILE* out = NULL;
+  if (out_path) {
+    out = strcmp(out_path, "stdout") == 0 ? stdout : fopen(out_path, "wb");
+    if (!out) {
+      fprintf(stderr, "Failed to open output file '%s': %s\n", out_path,
+              strerror(errno));
+      return 1;
+    }
+  }
+
+  sort_ctx* ctx = make_ctx(tuning, profile);
+#ifndef NO_TIMING
+  sort_hooks hooks = {NULL, lib_phase_begin, lib_phase_end};
+  sort_ctx_set_hooks(ctx, &hooks);
+#endif
+
+  // ---- timing: parse + sort + output ----
+  TICK(t_total_start);
+  const size_t a_bytes = (size_t)N_EXPECTED * sizeof(int64_t);
+  int64_t* a = (int64_t*)sort_alloc(a_bytes, tuning->pages, tuning->prefault);
+  if (!a) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
+  PHASE_BEGIN(m_parse);
+  const unsigned char* bad = NULL;
+  size_t n = parse_dec_capped(buf, (size_t)N_EXPECTED, digits, a, &bad);
+  if (n == SIZE_MAX) {
+    int l = (int)strcspn((const char*)bad, " \t\r\n");
+    fprintf(stderr, "Not an int64 decimal with at most %d fractional digits: "
+                    "'%.*s'\n",
+            digits, l < 40 ? l : 40, (const char*)bad);
+    return 1;
+  }
+  PHASE_END(m_parse, "parse", len + n * sizeof(int64_t));
+  free(buf);
+
+  TICK(t_sort_start);
+  check_sort(sort_i64(ctx, a, n));
+  double sort_only = TOCK(t_sort_start);
+
+  if (out) {
+    PHASE_BEGIN(m_out);
+    if (emit_dec(out, a, n, digits, mode) != 0) {
+      fprintf(stderr, "Write failed\n");
+      return 1;
+    }
+    fflush(out);
+    PHASE_END(m_out, "format_write", ftell(out) > 0 ? (size_t)ftell(out) : 0);
+  }
+  double sort_plus_output = TOCK(t_total_start);
+
+  if (out && out != stdout)
+    fclose(out);
+  sort_free(a, a_bytes);
+  sort_ctx_destroy(ctx);
+
+  PRINT_TIME("SORT_ONLY", sort_only);
+  PRINT_TIME("SORT_PLUS_OUTPUT", sort_plus_output);
+  PRINT_PEAK_RSS();
+  inst_report(report_path, "sort_omp", "decimal64", n, threads, sort_only,
+              sort_plus_output);
+  return 0;
+}
+
+// ===================== incremental update =====================
+// `--update DATA --type int|float|double [--levels N] [batch]` keeps DATA,
+// a raw native-endian sorted array (the gen_input --binary / sort_client
+// format), sorted as batches of new text values arrive. Only the batch is
+// radix-sorted; it is then merged with the existing data by merge_* (the
+// output split into one key range per thread), reading the runs through
+// read-only mappings and writing a mapped temporary file that replaces
+// DATA by rename. A day's batch costs its own sort plus one streaming pass
+// over the data instead of a full re-sort.
+//
+// With --levels N the data is kept as up to N sorted runs, DATA (oldest,
+// largest), DATA.1, DATA.2, ..., and merges are lazy: a new batch absorbs
+// the newest runs only while the next older run is smaller than
+// UPDATE_RATIO times what it has absorbed so far, or while there would be
+// more than N runs. Run sizes therefore grow geometrically and a value is
+// rewritten about log(n / batch) times in total. Without a batch, the runs
+// are compacted down to N (one by default).
+#define UPDATE_RATIO 4
+#define UPDATE_MAX_RUNS 64  // also the largest --levels
+
+typedef struct {
+  char* path;
+  const void* map;  // sorted values; the in-memory batch for the last run
+  size_t n;
+  int owned;  // map is an mmap of path
+} UpdateRun;
+
+static char* run_path(const char* data, int level) {
+  size_t len = strlen(data) + 16;
+  char* p = (char*)malloc(len);
+  if (p && level == 0)
+    snprintf(p, len, "%s", data);
+  else if (p)
+    snprintf(p, len, "%s.%d", data, level);
+  return p;
+}
+
+// Maps the existing runs DATA, DATA.1, ... into runs[0..); returns their
+// count or -1.
+static int map_runs(const char* data, size_t esz, UpdateRun* runs,
+                    int max_runs) {
+  int k = 0;
+  for (; k < max_runs; k++) {
+    char* path = run_path(data, k);
+    struct stat st;
+    if (!path)
+      return -1;
+    if (stat(path, &st) != 0) {
+      free(path);
+      break;
+    }
+    if ((size_t)st.st_size % esz != 0) {
+      fprintf(stderr, "'%s' is not an array of %zu-byte values\n", path,
+              esz);
+      free(path);
+      return -1;
+    }
+    runs[k].path = path;
+    runs[k].n = (size_t)st.st_size / esz;
+    runs[k].map = NULL;
+    runs[k].owned = 0;
+    if (runs[k].n == 0)
+      continue;
+    int fd = open(path, O_RDONLY);
+    void* m = fd < 0 ? MAP_FAILED
+                     : mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED,
+                            fd, 0);
+    if (fd >= 0)
+      close(fd);
+    if (m == MAP_FAILED) {
+      fprintf(stderr, "Failed to map '%s': %s\n", path, strerror(errno));
+      return -1;
+    }
+    madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+    runs[k].map = m;
+    runs[k].owned = 1;
+  }
+  return k;
+}
+
+// Fsyncs the directory holding `path`, so renames and unlinks in it are
+// durable.
+static int sync_dir(const char* path) {
+  const char* slash = strrchr(path, '/');
+  char* dir = slash ? strndup(path, slash == path ? 1 : (size_t)(slash - path))
+                    : strdup(".");
+  int fd = dir ? open(dir, O_RDONLY | O_DIRECTORY) : -1;
+  free(dir);
+  int rc = fd >= 0 && fsync(fd) == 0 ? 0 : -1;
+  if (fd >= 0)
+    close(fd);
+  return rc;
+}
+
+static char* suffixed_path(const char* path, const char* suffix) {
+  size_t len = strlen(path) + strlen(suffix) + 1;
+  char* p = (char*)malloc(len);
+  if (p)
+    snprintf(p, len, "%s%s", path, suffix);
+  return p;
+}
+
+// A merge of runs first..k-1 renames its output over run `first` and then
+// deletes the newer runs it absorbed. A crash between the two would leave
+// their values in both places, so the merge is journaled: DATA.merge holds
+// "first k" and is made durable before the rename, and removed once the
+// deletes are. update_recover() settles a journal left by a crash: if the
+// merged DATA[.first].tmp is still there the rename never happened and the
+// merge is dropped, otherwise the deletes are finished.
+static int journal_write(const char* data, int first, int k) {
+  char* path = suffixed_path(data, ".merge");
+  char* tmp = suffixed_path(data, ".merge.tmp");
+  int rc = -1;
+  FILE* f = tmp ? fopen(tmp, "w") : NULL;
+  if (f) {
+    int ok = fprintf(f, "%d %d\n", first, k) > 0 && fflush(f) == 0 &&
+             fsync(fileno(f)) == 0;
+    if (fclose(f) == 0 && ok && rename(tmp, path) == 0 &&
+        sync_dir(path) == 0)
+      rc = 0;
+  }
+  free(path);
+  free(tmp);
+  return rc;
+}
+
+// Deletes runs first+1..k-1, then the journal.
+static int journal_finish(const char* data, int first, int k) {
+  for (int i = first + 1; i < k; i++) {
+    char* path = run_path(data, i);
+    if (!path || (unlink(path) != 0 && errno != ENOENT)) {
+      free(path);
+      return -1;
+    }
+    free(path);
+  }
+  char* journal = suffixed_path(data, ".merge");
+  int rc = journal && sync_dir(data) == 0 &&
+                   (unlink(journal) == 0 || errno == ENOENT) &&
+                   sync_dir(data) == 0
+               ? 0
+               : -1;
+  free(journal);
+  return rc;
+}
+
+static int update_recover(const char* data) {
+  char* journal = suffixed_path(data, ".merge");
+  FILE* f = journal ? fopen(journal, "r") : NULL;
+  free(journal);
+  if (!f)
+    return 0;
+  int first = -1, k = -1;
+  int ok = fscanf(f, "%d %d", &first, &k) == 2 && first >= 0 && k > first &&
+           k <= UPDATE_MAX_RUNS + 1;
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "Unreadable merge journal '%s.merge'\n", data);
+    return -1;
+  }
+  char* dst = run_path(data, first);
+  char* tmp = dst ? suffixed_path(dst, ".tmp") : NULL;
+  struct stat st;
+  int rc = -1;
+  if (tmp && stat(tmp, &st) == 0) {
+    fprintf(stderr, "Dropping the interrupted merge into '%s'\n", dst);
+    if (unlink(tmp) == 0)
+      rc = journal_finish(data, k, k);  // removes only the journal
+  } else if (tmp) {
+    fprintf(stderr, "Finishing the interrupted merge into '%s'\n", dst);
+    rc = journal_finish(data, first, k);
+  }
+  free(dst);
+  free(tmp);
+  return rc;
+}
+
+// Merges runs[first..k) into a new file that replaces runs[first], then
+// deletes the newer runs, journaled as above.
+static int merge_runs_to_file(sort_ctx* ctx, NumType type, const char* data,
+                              const UpdateRun* runs, int first, int k) {
+  const size_t esz = type_sizes[type];
+  const char* dst = runs[first].path;
+  const int m = k - first;
+  size_t total = 0;
+  for (int i = first; i < k; i++)
+    total += runs[i].n;
+  char* tmp = suffixed_path(dst, ".tmp");
+  const void** maps = (const void**)malloc((size_t)m * sizeof(void*));
+  size_t* lens = (size_t*)malloc((size_t)m * sizeof(size_t));
+  int fd = -1, rc = -1;
+  void* out = MAP_FAILED;
+  if (!tmp || !maps || !lens)
+    goto done;
+  for (int i = 0; i < m; i++) {
+    maps[i] = runs[first + i].map;
+    lens[i] = runs[first + i].n;
+  }
+  fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0 || ftruncate(fd, (off_t)(total * esz)) != 0)
+    goto done;
+  if (total) {
+    out = mmap(NULL, total * esz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (out == MAP_FAILED)
+      goto done;
+    check_sort(merge_any(ctx, type, maps, lens, m, out));
+    munmap(out, total * esz);
+  }
+  if (fsync(fd) != 0 || (m > 1 && journal_write(data, first, k) != 0) ||
+      rename(tmp, dst) != 0 || sync_dir(dst) != 0)
+    goto done;
+  if (m > 1 && journal_finish(data, first, k) != 0)
+    goto done;
+  rc = 0;
+done:
+  if (rc != 0)
+    fprintf(stderr, "Failed to write '%s': %s\n", dst, strerror(errno));
+  if (fd >= 0)
+    close(fd);
+  free(tmp);
+  free(maps);
+  free(lens);
+  return rc;
+}
+
+static int run_update(const char* data,
+                      NumType type,
+                      int levels,
+                      const char* batch_path,
+                      const sort_tuning* tuning,
+                      const char* profile,
+                      const char* report_path) {
+#ifdef _OPENMP
+  int threads = omp_get_max_threads();
+#else
+  int threads = 1;
+#endif
+  const size_t esz = type_sizes[type];
+  const int max_runs = UPDATE_MAX_RUNS;
+  UpdateRun* runs = (UpdateRun*)calloc((size_t)max_runs + 1,
+                                       sizeof(UpdateRun));
+  if (!runs)
+    return 1;
+
+  // ---- read (not timed) ----
+  PHASE_BEGIN(m_read);
+  unsigned char* buf = NULL;
+  size_t len = 0;
+  if (batch_path) {
+    FILE* in = fopen(batch_path, "rb");
+    if (!in) {
+      fprintf(stderr, "Failed to open input file '%s': %s\n", batch_path,
+              strerror(errno));
+      return 1;
+    }
+    buf = read_all(in, &len);
+    fclose(in);
+    if (!buf) {
+      fprintf(stderr, "Failed to read input file.\n");
+      return 1;
+    }
+  }
+  PHASE_END(m_read, "read", len);
+
+  sort_ctx* ctx = make_ctx(tuning, profile);
+#ifndef NO_TIMING
+  sort_hooks hooks = {NULL, lib_phase_begin, lib_phase_end};
+  sort_ctx_set_hooks(ctx, &hooks);
+#endif
+
+  // ---- timing: parse + sort batch + merge ----
+  TICK(t_total_start);
+  void* vals = NULL;
+  size_t vals_bytes = 0, n_batch = 0;
+  double sort_only = 0.0;
+  if (buf) {
+    PHASE_BEGIN(m_parse);
+    size_t cap = len / 2 + 1;  // a value plus a separator per 2 bytes
+    vals_bytes = cap * esz;
+    vals = sort_alloc(vals_bytes, tuning->pages, 0);
+    if (!vals) {
+      fprintf(stderr, "Allocation failed\n");
+      return 1;
+    }
+    n_batch = parse_any(type, buf, cap, vals);
+    free(buf);
+    PHASE_END(m_parse, "parse", len + n_batch * esz);
+    TICK(t_sort_start);
+    check_sort(sort_any(ctx, type, vals, n_batch));
+    sort_only += TOCK(t_sort_start);
+  }
+
+  PHASE_BEGIN(m_map);
+  if (update_recover(data) != 0)
+    return 1;
+  int k = map_runs(data, esz, runs, max_runs);
+  if (k < 0)
+    return 1;
+  PHASE_END(m_map, "map_runs", 0);
+  if (n_batch) {
+    runs[k].path = run_path(data, k);
+    runs[k].map = vals;
+    runs[k].n = n_batch;
+    k++;
+  }
+
+  // Oldest run that takes part in the merge: everything newer is merged
+  // into it.
+  int first = k - 1;
+  if (first >= 0) {
+    size_t newer = runs[first].n;
+    while (first > 0 && (first >= levels ||
+                         runs[first - 1].n < UPDATE_RATIO * newer)) {
+      first--;
+      newer += runs[first].n;
+    }
+  }
+
+  size_t total = 0;
+  for (int i = 0; i < k; i++)
+    total += runs[i].n;
+  TICK(t_merge_start);
+  if (first >= 0 && (first < k - 1 || runs[first].owned == 0)) {
+    if (merge_runs_to_file(ctx, type, data, runs, first, k) != 0)
+      return 1;
+  }
+  sort_only += TOCK(t_merge_start);
+  double sort_plus_output = TOCK(t_total_start);
+
+  int left = first < 0 ? 0 : first + 1;
+  for (int i = 0; i < k; i++) {
+    if (runs[i].owned)
+      munmap((void*)runs[i].map, runs[i].n * esz);
+    free(runs[i].path);
+  }
+  free(runs);
+  if (vals)
+    sort_free(vals, vals_bytes);
+  sort_ctx_destroy(ctx);
+
+  fprintf(stderr, "%zu values in %d sorted run%s\n", total, left,
+          left == 1 ? "" : "s");
+  PRINT_TIME("SORT_ONLY", sort_only);
+  PRINT_TIME("SORT_PLUS_OUTPUT", sort_plus_output);
+  PRINT_PEAK_RSS();
+  inst_report(report_path, "sort_omp", type_names[type], total, threads,
+              sort_only, sort_plus_output);
+  return 0;
+}
+
+// ===================== distributed mode =====================
+// `--dist RANK --peers ADDR0,ADDR1,...` runs this process as worker RANK of
+// a sample sort over all listed workers (sort_dist.h). Each worker reads its
+// own input shard and writes its slice of the global order; the workers
+// agree on the widest element type before parsing.
+static int run_dist(int rank,
+                    char* peers,
+                    const char* in_path,
+                    const char* out_path,
+                    OutMode mode,
+                    const sort_tuning* tuning,
+                    const char* profile,
+                    const char* report_path) {
+  char* addrs[256];
+  int size = 0;
+  for (char* tok = strtok(peers, ","); tok; tok = strtok(NULL, ",")) {
+    if (size == 256)
+      return 2;
+    addrs[size++] = tok;
+  }
+  if (rank < 0 || rank >= size)
+    return 2;
+#ifdef _OPENMP
+  int threads = omp_get_max_threads();
+#else
+  int threads = 1;
+#endif
+
+  PHASE_BEGIN(m_read);
+  FILE* in = fopen(in_path, "rb");
+  if (!in) {
+    fprintf(stderr, "Failed to open input file '%s': %s\n", in_path,
+            strerror(errno));
+    return 1;
+  }
+  size_t len = 0;
+  unsigned char* buf = read_all(in, &len);
+  fclose(in);
+  if (!buf) {
+    fprintf(stderr, "Failed to read input file.\n");
+    return 1;
+  }
+  PHASE_END(m_read, "read", len);
+
+  dist_comm comm;
+  if (dist_open(&comm, rank, addrs, size, 60) != 0)
+    return 1;
+  uint32_t* types = (uint32_t*)malloc((size_t)size * sizeof(uint32_t));
+  uint32_t mine = (uint32_t)detect_type(buf);
+  if (!types || dist_allgather(&comm, &mine, sizeof(mine), types) != 0) {
+    fprintf(stderr, "Worker exchange failed\n");
+    return 1;
+  }
+  NumType type = T_INT32;
+  for (int r = 0; r < size; r++)
+    if (types[r] > (uint32_t)type && types[r] <= T_FLOAT64)
+      type = (NumType)types[r];
+  free(types);
+  const size_t esz = type_sizes[type];
+
+  FILE* out = NULL;
+  if (out_path) {
+    out = strcmp(out_path, "stdout") == 0 ? stdout : fopen(out_path, "wb");
+    if (!out) {
+      fprintf(stderr, "Failed to open output file '%s': %s\n", out_path,
+              strerror(errno));
+      return 1;
+    }
+  }
+
+  sort_ctx* ctx = make_ctx(tuning, profile);
+#ifndef NO_TIMING
+  sort_hooks hooks = {NULL, lib_phase_begin, lib_phase_end};
+  sort_ctx_set_hooks(ctx, &hooks);
+#endif
+
+  // ---- timing: parse + local sort + exchange + merge + output ----
+  TICK(t_total_start);
+  const size_t a_bytes = (size_t)N_EXPECTED * esz;
+  void* a = sort_alloc(a_bytes, tuning->pages, tuning->prefault);
+  if (!a) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
+  PHASE_BEGIN(m_parse);
+  size_t n = parse_any(type, buf, (size_t)N_EXPECTED, a);
+  PHASE_END(m_parse, "parse", len + n * esz);
+  free(buf);
+
+  TICK(t_sort_start);
+  void* res = NULL;
+  size_t n_res = 0;
+  int rc = dist_sort(&comm, ctx, (int)type, a, n, &res, &n_res);
+  if (rc == SORT_EINVAL) {
+    fprintf(stderr, "Worker exchange failed\n");
+    return 1;
+  }
+  check_sort(rc);
+  double sort_only = TOCK(t_sort_start);
+  dist_close(&comm);
+  sort_free(a, a_bytes);
+
+  if (out) {
+    PHASE_BEGIN(m_out);
+    emit_any(out, ctx, type, res, n_res, mode);
+    fflush(out);
+    PHASE_END(m_out, "format_write", ftell(out) > 0 ? (size_t)ftell(out) : 0);
+  }
+  double sort_plus_output = TOCK(t_total_start);
+
+  if (out && out != stdout)
+    fclose(out);
+  sort_free(res, n_res * esz);
+  sort_ctx_destroy(ctx);
+
+  PRINT_TIME("SORT_ONLY", sort_only);
+  PRINT_TIME("SORT_PLUS_OUTPUT", sort_plus_output);
+  PRINT_PEAK_RSS();
+  inst_report(report_path, "sort_omp", type_names[type], n_res, threads,
+              sort_only, sort_plus_output);
+  return 0;
+}
+
+// ===================== sort server =====================
+// `--serve SOCKET` keeps one process, one sort_ctx and one OpenMP team alive
+// across jobs, so a job costs a socket round trip and the sort itself rather
+// than exec, dynamic linking, runtime startup and cold page faults. Jobs are
+// served one at a time; payloads arrive as memfds (see sort_proto.h).
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_stop_signal(int sig) {
+  (void)sig;
+  g_stop = 1;
+}
+
+static int recv_request(int conn, sort_request* req, int* fd) {
+  char cbuf[CMSG_SPACE(sizeof(int))];
+  struct iovec iov = {req, sizeof(*req)};
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cbuf;
+  msg.msg_controllen = sizeof(cbuf);
+
+  *fd = -1;
+  ssize_t got;
+  do
+    got = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+  while (got < 0 && errno == EINTR && !g_stop);
+  for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS)
+      memcpy(fd, CMSG_DATA(c), sizeof(int));
+  if (got == (ssize_t)sizeof(*req))
+    return 0;
+  if (*fd >= 0)
+    close(*fd);
+  return -1;  // EOF, error or short message: drop the connection
+}
+
+static int serve_sort(sort_ctx* ctx,
+                      const sort_request* req,
+                      int fd,
+                      uint64_t* sort_ns) {
+  static const size_t elem_size[] = {4, 4, 8};
+  if (fd < 0 || req->elem > SORT_ELEM_F64)
+    return SORT_PROTO_EBADREQ;
+  if (req->n == 0)
+    return SORT_OK;
+  size_t bytes = (size_t)req->n * elem_size[req->elem];
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < bytes)
+    return SORT_PROTO_EPAYLOAD;
+
+  // MAP_POPULATE faults the client's pages in with one call instead of one
+  // fault per page inside the sort.
+  void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 fd, 0);
+  if (p == MAP_FAILED)
+    return SORT_PROTO_EPAYLOAD;
+
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  int rc;
+  if (req->elem == SORT_ELEM_I32)
+    rc = sort_i32(ctx, (int32_t*)p, (size_t)req->n);
+  else if (req->elem == SORT_ELEM_F32)
+    rc = sort_f32(ctx, (float*)p, (size_t)req->n);
+  else
+    rc = sort_f64(ctx, (double*)p, (size_t)req->n);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  *sort_ns = (uint64_t)(t1.tv_sec - t0.tv_sec) * 1000000000u +
+             (uint64_t)(t1.tv_nsec - t0.tv_nsec);
+
+  munmap(p, bytes);
+  return rc;
+}
+
+static int serve(const char* sock_path,
+                 const sort_tuning* tuning,
+                 const char* profile) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(sock_path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Socket path too long: '%s'\n", sock_path);
+    return 2;
+  }
+  strcpy(addr.sun_path, sock_path);
+
+  sort_ctx* ctx = make_ctx(tuning, profile);
+  double* warm = (double*)malloc((size_t)N_EXPECTED * sizeof(double));
+  if (!warm) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
+  // One throwaway sort at the expected size faults in the arenas and starts
+  // the thread team before the first job arrives. The keys are a counter
+  // hash: presorted input would take the fast path and skip the radix
+  // passes, leaving the key arena and count tables untouched.
+  for (size_t i = 0; i < (size_t)N_EXPECTED; i++)
+    warm[i] = (double)(int64_t)((uint64_t)i * 0x9e3779b97f4a7c15ull);
+  check_sort(sort_f64(ctx, warm, (size_t)N_EXPECTED));
+  free(warm);
+
+  int lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  unlink(sock_path);
+  if (lfd < 0 || bind(lfd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+      listen(lfd, 16) != 0) {
+    fprintf(stderr, "Failed to listen on '%s': %s\n", sock_path,
+            strerror(errno));
+    return 1;
+  }
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_stop_signal;  // no SA_RESTART: accept() must return
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  fprintf(stderr, "Serving on %s (%s kernels)\n", sock_path, sort_isa());
+  while (!g_stop) {
+    int conn = accept(lfd, NULL, NULL);
+    if (conn < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "accept failed: %s\n", strerror(errno));
+      break;
+    }
+
+    sort_request req;
+    int fd;
+    while (!g_stop && recv_request(conn, &req, &fd) == 0) {
+      sort_reply rep = {SORT_PROTO_MAGIC, SORT_OK, 0};
+      if (req.magic != SORT_PROTO_MAGIC)
+        rep.status = SORT_PROTO_EBADREQ;
+      else if (req.op == SORT_OP_SORT)
+        rep.status = serve_sort(ctx, &req, fd, &rep.sort_ns);
+      else if (req.op == SORT_OP_SHUTDOWN)
+        g_stop = 1;
+      else if (req.op != SORT_OP_PING)
+        rep.status = SORT_PROTO_EBADREQ;
+      if (fd >= 0)
+        close(fd);
+      if (send(conn, &rep, sizeof(rep), 0) != (ssize_t)sizeof(rep))
+        break;
+    }
+    close(conn);
+  }
+
+  close(lfd);
+  unlink(sock_path);
+  sort_ctx_destroy(ctx);
+  return 0;
+}
+
+// ===================== main =====================
+// Parses a whole decimal argument in [lo, hi]; -1 on anything else.
+static int parse_int_arg(const char* s, int lo, int hi, int* out) {
+  char* end;
+  long v = strtol(s, &end, 10);
+  if (end == s || *end != '\0' || v < lo || v > hi)
+    return -1;
+  *out = (int)v;
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  // usage: sort_omp [--unique | --counts] [--report FILE|stderr] [--perf]
+  //                 [--column] <input> [output|stdout]
+  //        sort_omp [--combined | --per-file | --merge-only]
+  //                 -o output|stdout <input|'glob'>...
+  //        sort_omp --key COL[:int|:float|:double][:desc][,...]
+  //                 [--delim C|tab] [--header] <input> [output|stdout]
+  //        sort_omp --lines [--unique] <input> [output|stdout]
+  //        sort_omp --decimal N [--unique | --counts] <input>
+  //                 [output|stdout]
+  //        sort_omp --update DATA --type int|float|double [--levels N]
+  //                 [batch]
+  //        sort_omp --dist RANK --peers ADDR,ADDR,... <input> [output]
+  //        sort_omp --serve SOCKET
+  //        sort_omp --calibrate PROFILE
+  // both:  [--pages default|small|thp|hugetlb] [--prefault] [--threads N]
+  //        [--profile PROFILE] [--no-presort-check]
+  //
+  // Threads default to the CPUs this process may use (affinity mask and
+  // cgroup quota), reduced per sort so that small inputs run sequentially.
+  // A profile from --calibrate (or $SORT_PROFILE) replaces those defaults
+  // with the measured best engine, threads and digit width per (type, n).
+  OutMode mode = OUT_ALL;
+  const char* in_path = NULL;
+  const char* out_path = NULL;
+  char** inputs = (char**)calloc((size_t)argc, sizeof(char*));
+  int n_inputs = 0;
+  int output_flag = 0;
+  int multi = -1;
+  RecKey keys[REC_MAX_KEYS];
+  int n_keys = 0;
+  int delim = -1;
+  int header = 0;
+  int lines = 0;
+  int decimal = -1;
+  const char* update_path = NULL;
+  int update_type = -1;
+  int levels = 1;
+  int dist_rank = -1;
+  char* peers = NULL;
+  const char* report_path = NULL;
+  const char* serve_path = NULL;
+  const char* calibrate_path = NULL;
+  const char* profile_path = getenv("SORT_PROFILE");
+  int perf = 0;
+  sort_tuning tuning;
+  sort_tuning_default(&tuning);
+  tuning.pages = SORT_PAGES_THP;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--unique") == 0)
+      mode = OUT_UNIQUE;
+    else if (strcmp(argv[i], "--counts") == 0)
+      mode = OUT_COUNTS;
+    else if (strcmp(argv[i], "--column") == 0)
+      mode = OUT_COLUMN;
+    else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc)
+      report_path = argv[++i];
+    else if (strcmp(argv[i], "--perf") == 0)
+      perf = 1;
+    else if (strcmp(argv[i], "--pages") == 0 && i + 1 < argc) {
+      tuning.pages = sort_pages_parse(argv[++i]);
+      if (tuning.pages < 0)
+        return 2;
+    } else if (strcmp(argv[i], "--prefault") == 0)
+      tuning.prefault = 1;
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      tuning.threads = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--no-presort-check") == 0)
+      tuning.no_presort_check = 1;
+    else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc)
+      serve_path = argv[++i];
+    else if (strcmp(argv[i], "--calibrate") == 0 && i + 1 < argc)
+      calibrate_path = argv[++i];
+    else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+      profile_path = argv[++i];
+    else if ((strcmp(argv[i], "-o") == 0 ||
+              strcmp(argv[i], "--output") == 0) &&
+             i + 1 < argc) {
+      out_path = argv[++i];
+      output_flag = 1;
+    } else if (strcmp(argv[i], "--key") == 0 && i + 1 < argc) {
+      if (parse_key_spec(argv[++i], keys, &n_keys) != 0)
+        return 2;
+    } else if (strcmp(argv[i], "--delim") == 0 && i + 1 < argc) {
+      const char* d = argv[++i];
+      if (strcmp(d, "tab") == 0)
+        delim = '\t';
+      else if (strlen(d) == 1)
+        delim = (unsigned char)d[0];
+      else
+        return 2;
+    } else if (strcmp(argv[i], "--dist") == 0 && i + 1 < argc)
+      dist_rank = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--peers") == 0 && i + 1 < argc)
+      peers = argv[++i];
+    else if (strcmp(argv[i], "--header") == 0)
+      header = 1;
+    else if (strcmp(argv[i], "--lines") == 0)
+      lines = 1;
+    else if (strcmp(argv[i], "--decimal") == 0 && i + 1 < argc) {
+      if (parse_int_arg(argv[++i], 0, DEC_MAX_DIGITS, &decimal) < 0)
+        return 2;
+    } else if (strcmp(argv[i], "--update") == 0 && i + 1 < argc)
+      update_path = argv[++i];
+    else if (strcmp(argv[i], "--type") == 0 && i + 1 < argc) {
+      const char* t = argv[++i];
+      update_type = strcmp(t, "int") == 0      ? T_INT32
+                    : strcmp(t, "float") == 0  ? T_FLOAT32
+                    : strcmp(t, "double") == 0 ? T_FLOAT64
+                                               : -1;
+      if (update_type < 0)
+        return 2;
+    } else if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc) {
+      if (parse_int_arg(argv[++i], 1, UPDATE_MAX_RUNS, &levels) < 0)
+        return 2;
+    } else if (strcmp(argv[i], "--combined") == 0)
+      multi = MULTI_COMBINED;
+    else if (strcmp(argv[i], "--per-file") == 0)
+      multi = MULTI_PER_FILE;
+    else if (strcmp(argv[i], "--merge-only") == 0)
+      multi = MULTI_MERGE_ONLY;
+    else if (strncmp(argv[i], "--", 2) == 0)
+      return 2;
+    else if (inputs)
+      inputs[n_inputs++] = argv[i];
+  }
+  if (!inputs)
+    return 1;
+  // Without -o the second positional is the output (original interface).
+  if (!output_flag && n_inputs == 2)
+    out_path = inputs[--n_inputs];
+  if (n_inputs > 1 && !output_flag)
+    return 2;
+  if (n_inputs == 1 && multi < 0 && !strpbrk(inputs[0], "*?["))
+    in_path = inputs[0];
+  if (!n_inputs && !serve_path && !calibrate_path && !update_path)
+    return 2;
+  if (profile_path && !*profile_path)
+    profile_path = NULL;
+
+#ifdef _OPENMP
+  omp_set_dynamic(0);
+  omp_set_num_threads(tuning.threads > 0 ? tuning.threads
+                                         : sort_available_cpus());
+#endif
+  if (calibrate_path) {
+    int rc = sort_calibrate(calibrate_path, (size_t)N_EXPECTED, stderr);
+    if (rc != SORT_OK) {
+      fprintf(stderr, "Calibration failed (%s)\n",
+              rc == SORT_ENOMEM ? "allocation" : "cannot write profile");
+      return 1;
+    }
+    fprintf(stderr, "Profile written to %s\n", calibrate_path);
+    return 0;
+  }
+  if (serve_path)
+    return serve(serve_path, &tuning, profile_path);
+  if (perf)
+    inst_perf_init();
+  if (dist_rank >= 0 || peers) {
+    if (!in_path || !peers || dist_rank < 0)
+      return 2;
+    return run_dist(dist_rank, peers, in_path, out_path, mode, &tuning,
+                    profile_path, report_path);
+  }
+  if (update_path) {
+    if (update_type < 0 || n_inputs > 1 || out_path)
+      return 2;
+    return run_update(update_path, (NumType)update_type, levels,
+                      n_inputs ? inputs[0] : NULL, &tuning, profile_path,
+                      report_path);
+  }
+  if (lines) {
+    if (!in_path || n_keys || mode == OUT_COUNTS || mode == OUT_COLUMN)
+      return 2;
+    return run_lines(in_path, out_path, mode, &tuning, profile_path,
+                     report_path);
+  }
+  if (decimal >= 0) {
+    if (!in_path || n_keys || lines || mode == OUT_COLUMN)
+      return 2;
+    return run_decimal(in_path, out_path, decimal, mode, &tuning,
+                       profile_path, report_path);
+  }
+  if (n_keys) {
+    if (!in_path || mode != OUT_ALL)
+      return 2;
+    return run_records(in_path, out_path, keys, n_keys, delim, header,
+                       &tuning, profile_path, report_path);
+  }
+  if (!in_path)
+    return run_multi(inputs, n_inputs, out_path,
+                     multi < 0 ? MULTI_COMBINED : (MultiMode)multi, mode,
+                     &tuning, profile_path, report_path);
+
+  // ---- read (not timed) ----
+  PHASE_BEGIN(m_read);
+  FILE* in = fopen(in_path, "rb");
+  if (!in) {
+    fprintf(stderr, "Failed to open input file '%s': %s\n", in_path,
+            strerror(errno));
+    return 1;
+  }
+
+  size_t len = 0;
+  unsigned char* buf = read_all(in, &len);
+  fclose(in);
+  if (!buf) {
+    fprintf(stderr, "Failed to read input file.\n");
+    return 1;
+  }
+
+  PHASE_END(m_read, "read", len);
+
+  PHASE_BEGIN(m_detect);
+  NumType type = detect_type(buf);
+  PHASE_END(m_detect, "detect_type", len);
+
+  // ---- output handle ----
+  FILE* out = NULL;
+  int will_output = (out_path != NULL);
+  if (will_output) {
+    if (strcmp(out_path, "stdout") == 0)
+      out = stdout;
+    else {
+      out = fopen(out_path, "wb");
+      if (!out) {
+        fprintf(stderr, "Failed to open output file '%s': %s\n", out_path,
+                strerror(errno));
+        free(buf);
+        return 1;
+      }
+    }
+  }
+
+  sort_ctx* ctx = make_ctx(&tuning, profile_path);
+#ifndef NO_TIMING
+  sort_hooks hooks = {NULL, lib_phase_begin, lib_phase_end};
+  sort_ctx_set_hooks(ctx, &hooks);
+#endif
+
+  // ---- timing: sorting + output ----
+  TICK(t_total_start);
+  double sort_only = 0.0;
+  size_t n_sorted = 0;
+
+  if (type == T_INT32) {
+    const size_t a_bytes = (size_t)N_EXPECTED * sizeof(int32_t);
+    int32_t* a = (int32_t*)sort_alloc(a_bytes, tuning.pages, tuning.prefault);
+    if (!a) {
+      fprintf(stderr, "Allocation failed\n");
+      exit(1);
+    }
+    PHASE_BEGIN(m_parse);
+    size_t n = parse_i32_capped(buf, (size_t)N_EXPECTED, a);
+    PHASE_END(m_parse, "parse", len + n * sizeof(int32_t));
+    free(buf);  // the text is dead once parsed; drop it before sorting
+    buf = NULL;
+    n_sorted = n;
+    const int dedup = mode == OUT_UNIQUE || mode == OUT_COUNTS;
+    // Reserved for dedup too: whether the histogram applies is only known
+    // inside the timed phase, and its radix fallback must not grow arenas
+    // there.
+    check_sort(sort_ctx_reserve(ctx, n, sizeof(uint32_t), 0));
+
+    int32_t lo = 0;
+    uint32_t range = 0;
+    uint32_t* cnt = NULL;
+
+    TICK(t_sort_start);
+    if (dedup)
+      cnt = hist_i32(a, n, &lo, &range);
+    if (!cnt)
+      check_sort(sort_i32(ctx, a, n));
+    sort_only = TOCK(t_sort_start);
+
+    if (will_output) {
+      PHASE_BEGIN(m_out);
+      if (cnt)
+        emit_hist_i32(out, cnt, lo, range, mode);
+      else
+        emit_any(out, ctx, type, a, n, mode);
+      fflush(out);
+      PHASE_END(m_out, "format_write", ftell(out) > 0 ? (size_t)ftell(out) : 0);
+    }
+    free(cnt);
+    sort_free(a, a_bytes);
+
+  } else if (type == T_FLOAT32) {
+    const size_t a_bytes = (size_t)N_EXPECTED * sizeof(float);
+    float* a = (float*)sort_alloc(a_bytes, tuning.pages, tuning.prefault);
     if (!a) {
       fprintf(stderr, "Allocation failed\n");
       exit(1);
     }
+    PHASE_BEGIN(m_parse);
     size_t n = parse_f32_capped(buf, (size_t)N_EXPECTED, a);
+    PHASE_END(m_parse, "parse", len + n * sizeof(float));
+    free(buf);
+    buf = NULL;
+    n_sorted = n;
+    check_sort(sort_ctx_reserve(ctx, n, sizeof(uint32_t), 0));
 
     TICK(t_sort_start);
-    radix_f32(a, n);
+    check_sort(sort_f32(ctx, a, n));
     sort_only = TOCK(t_sort_start);
 
-    if (will_output)
-      for (size_t i = 0; i < n; i++)
-        write_f32(out, a[i]);
-    free(a);
+    if (will_output) {
+      PHASE_BEGIN(m_out);
+      emit_any(out, ctx, type, a, n, mode);
+      fflush(out);
+      PHASE_END(m_out, "format_write", ftell(out) > 0 ? (size_t)ftell(out) : 0);
+    }
+    sort_free(a, a_bytes);
 
   } else {
-    double* a = (double*)malloc((size_t)N_EXPECTED * sizeof(double));
+    const size_t a_bytes = (size_t)N_EXPECTED * sizeof(double);
+    double* a = (double*)sort_alloc(a_bytes, tuning.pages, tuning.prefault);
     if (!a) {
       fprintf(stderr, "Allocation failed\n");
       exit(1);
     }
+    PHASE_BEGIN(m_parse);
     size_t n = parse_f64_capped(buf, (size_t)N_EXPECTED, a);
+    PHASE_END(m_parse, "parse", len + n * sizeof(double));
+    free(buf);
+    buf = NULL;
+    n_sorted = n;
+    check_sort(sort_ctx_reserve(ctx, n, sizeof(uint64_t), 0));
 
     TICK(t_sort_start);
-    radix_f64(a, n);
+    check_sort(sort_f64(ctx, a, n));
     sort_only = TOCK(t_sort_start);
 
-    if (will_output)
-      for (size_t i = 0; i < n; i++)
-        write_f64(out, a[i]);
-    free(a);
+    if (will_output) {
+      PHASE_BEGIN(m_out);
+      emit_any(out, ctx, type, a, n, mode);
+      fflush(out);
+      PHASE_END(m_out, "format_write", ftell(out) > 0 ? (size_t)ftell(out) : 0);
+    }
+    sort_free(a, a_bytes);
   }
 
   double sort_plus_output = TOCK(t_total_start);
 
   if (out && out != stdout)
     fclose(out);
-  free(buf);
+  sort_ctx_destroy(ctx);
 
   PRINT_TIME("SORT_ONLY", sort_only);
   PRINT_TIME("SORT_PLUS_OUTPUT", sort_plus_output);
+  PRINT_PEAK_RSS();
+
+#ifdef _OPENMP
+  int report_threads = omp_get_max_threads();
+#else
+  int report_threads = 1;
+#endif
+  inst_report(report_path, "sort_omp", type_names[type], n_sorted,
+              report_threads, sort_only, sort_plus_output);
   return 0;
 }
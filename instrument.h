@@ -0,0 +1,220 @@
+// Per-phase instrumentation for final_sort.c / final_sort_omp.c.
+//
+//   PHASE_BEGIN(m);  ...work...;  PHASE_END(m, "parse", bytes_touched);
+//   PHASE_END_IDX(m, "radix_pass", pass, bytes_touched);
+//
+// Each phase records wall time, bytes touched (for GB/s) and, when enabled
+// with inst_perf_init(), hardware counters read via perf_event_open:
+// cycles, LLC misses, dTLB load misses and branch misses. Under OpenMP the
+// counters are opened once per team thread and summed, so parallel phases
+// are attributed in full. inst_report() writes everything as JSON, along
+// with the process's peak resident set size (inst_peak_rss_kb()).
+//
+// With NO_TIMING every macro expands to nothing and the functions are empty
+// inlines, so the instrumented code compiles to the uninstrumented one.
+//
+// Includers must define _DEFAULT_SOURCE (for syscall()) before any system
+// header when building on Linux.
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef NO_TIMING
+
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define INST_MAX_PHASES  64
+#define INST_MAX_THREADS 256
+
+enum { INST_HW_CYCLES, INST_HW_LLC_MISSES, INST_HW_DTLB_MISSES, INST_HW_BRANCH_MISSES, INST_HW_N };
+
+static const char* const inst_hw_names[INST_HW_N] = {
+    "cycles", "llc_misses", "dtlb_misses", "branch_misses"
+};
+
+typedef struct {
+    double   t;
+    uint64_t hw[INST_HW_N];
+} InstMark;
+
+typedef struct {
+    const char* name;
+    int         index;      // pass number, -1 if none
+    double      seconds;
+    uint64_t    bytes;
+    uint64_t    hw[INST_HW_N];
+} InstPhase;
+
+static struct {
+    InstPhase phases[INST_MAX_PHASES];
+    int       n_phases;
+    int       perf;                                // counters open
+    int       hw_ok[INST_HW_N];                    // counter available on every thread
+    int       n_slots;                             // threads with counters
+    int       fds[INST_MAX_THREADS][INST_HW_N];
+} g_inst;
+
+static inline double inst_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// High-water mark of the resident set in KB (Linux reports ru_maxrss in KB).
+static inline long inst_peak_rss_kb(void) {
+    struct rusage ru;
+    return getrusage(RUSAGE_SELF, &ru) == 0 ? (long)ru.ru_maxrss : 0;
+}
+
+// ===================== hardware counters =====================
+#ifdef __linux__
+static int inst_perf_open(uint32_t type, uint64_t config) {
+    struct perf_event_attr pe;
+    memset(&pe, 0, sizeof(pe));
+    pe.size = sizeof(pe);
+    pe.type = type;
+    pe.config = config;
+    pe.exclude_kernel = 1;
+    pe.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+static void inst_perf_open_slot(int slot) {
+    static const uint64_t dtlb_miss =
+        PERF_COUNT_HW_CACHE_DTLB |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    int* fd = g_inst.fds[slot];
+    fd[INST_HW_CYCLES]        = inst_perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fd[INST_HW_LLC_MISSES]    = inst_perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    fd[INST_HW_DTLB_MISSES]   = inst_perf_open(PERF_TYPE_HW_CACHE, dtlb_miss);
+    fd[INST_HW_BRANCH_MISSES] = inst_perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+}
+#endif
+
+// Opens counters for the calling thread, or for every thread of the OpenMP
+// team. Call after the thread count is fixed. Silently leaves counters off
+// when perf_event_open is unavailable (e.g. perf_event_paranoid, containers).
+static void inst_perf_init(void) {
+#ifdef __linux__
+    for (int s = 0; s < INST_MAX_THREADS; s++)
+        for (int k = 0; k < INST_HW_N; k++) g_inst.fds[s][k] = -1;
+    // Slots follow the team that starts, which can be smaller than asked for.
+#ifdef _OPENMP
+    int threads = omp_get_max_threads();
+    if (threads > INST_MAX_THREADS) threads = INST_MAX_THREADS;
+#pragma omp parallel num_threads(threads)
+    {
+        inst_perf_open_slot(omp_get_thread_num());
+        if (omp_get_thread_num() == 0) threads = omp_get_num_threads();
+    }
+#else
+    int threads = 1;
+    inst_perf_open_slot(0);
+#endif
+    g_inst.n_slots = threads;
+    for (int k = 0; k < INST_HW_N; k++) {
+        g_inst.hw_ok[k] = 1;
+        for (int s = 0; s < threads; s++)
+            if (g_inst.fds[s][k] < 0) g_inst.hw_ok[k] = 0;
+        if (g_inst.hw_ok[k]) g_inst.perf = 1;
+    }
+#endif
+}
+
+static inline InstMark inst_mark(void) {
+    InstMark m;
+    memset(&m, 0, sizeof(m));
+#ifdef __linux__
+    if (g_inst.perf) {
+        for (int k = 0; k < INST_HW_N; k++) {
+            if (!g_inst.hw_ok[k]) continue;
+            for (int s = 0; s < g_inst.n_slots; s++) {
+                uint64_t v = 0;
+                if (read(g_inst.fds[s][k], &v, sizeof(v)) == (ssize_t)sizeof(v)) m.hw[k] += v;
+            }
+        }
+    }
+#endif
+    m.t = inst_now();
+    return m;
+}
+
+static inline void inst_record(const char* name, int index, const InstMark* begin, uint64_t bytes) {
+    InstMark end = inst_mark();
+    if (g_inst.n_phases >= INST_MAX_PHASES) return;
+    InstPhase* p = &g_inst.phases[g_inst.n_phases++];
+    p->name = name;
+    p->index = index;
+    p->seconds = end.t - begin->t;
+    p->bytes = bytes;
+    for (int k = 0; k < INST_HW_N; k++) p->hw[k] = end.hw[k] - begin->hw[k];
+}
+
+// ===================== JSON report =====================
+static void inst_report(const char* path, const char* binary, const char* type,
+                        size_t n, int threads, double sort_only, double sort_plus_output) {
+    if (!path) return;
+    FILE* f = (strcmp(path, "stderr") == 0) ? stderr : fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open report file '%s'\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n  \"binary\": \"%s\",\n  \"type\": \"%s\",\n  \"n\": %zu,\n  \"threads\": %d,\n",
+            binary, type, n, threads);
+    fprintf(f, "  \"sort_only_s\": %.9f,\n  \"sort_plus_output_s\": %.9f,\n", sort_only, sort_plus_output);
+    fprintf(f, "  \"peak_rss_kb\": %ld,\n", inst_peak_rss_kb());
+    fprintf(f, "  \"hw_counters\": %s,\n  \"phases\": [", g_inst.perf ? "true" : "false");
+    for (int i = 0; i < g_inst.n_phases; i++) {
+        const InstPhase* p = &g_inst.phases[i];
+        double gbps = p->seconds > 0.0 ? (double)p->bytes / p->seconds * 1e-9 : 0.0;
+        fprintf(f, "%s\n    {\"name\": \"%s\"", i ? "," : "", p->name);
+        if (p->index >= 0) fprintf(f, ", \"index\": %d", p->index);
+        fprintf(f, ", \"seconds\": %.9f, \"bytes\": %llu, \"gbps\": %.3f",
+                p->seconds, (unsigned long long)p->bytes, gbps);
+        for (int k = 0; k < INST_HW_N; k++)
+            if (g_inst.perf && g_inst.hw_ok[k])
+                fprintf(f, ", \"%s\": %llu", inst_hw_names[k], (unsigned long long)p->hw[k]);
+        fputc('}', f);
+    }
+    fprintf(f, "\n  ]\n}\n");
+
+    if (f != stderr) fclose(f);
+}
+
+#define PHASE_BEGIN(var)                       InstMark var = inst_mark()
+#define PHASE_END(var, name, bytes)            inst_record((name), -1, &(var), (uint64_t)(bytes))
+#define PHASE_END_IDX(var, name, idx, bytes)   inst_record((name), (idx), &(var), (uint64_t)(bytes))
+
+#else // NO_TIMING
+
+static inline void inst_perf_init(void) {}
+static inline long inst_peak_rss_kb(void) { return 0; }
+static inline void inst_report(const char* path, const char* binary, const char* type,
+                               size_t n, int threads, double sort_only, double sort_plus_output) {
+    (void)path; (void)binary; (void)type; (void)n; (void)threads;
+    (void)sort_only; (void)sort_plus_output;
+}
+
+#define PHASE_BEGIN(var)
+#define PHASE_END(var, name, bytes)
+#define PHASE_END_IDX(var, name, idx, bytes)
+
+#endif // NO_TIMING
+
+#endif // INSTRUMENT_H
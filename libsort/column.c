@@ -0,0 +1,282 @@
+// Sorted-column format (sort_col_*).
+//
+// Layout, native-endian:
+//   header   "SCOL", version, type, block length, n, block count
+//   index    one uint64 file offset per block
+//   blocks   first key (uint64), delta width w (uint8, padded to 16 bytes),
+//            then the SORT_COL_BLOCK deltas between neighbouring keys (the
+//            first 0, a short last block padded with 0s) at w bits each
+//
+// The deltas are packed in LS_COL_LANES interleaved lanes: delta j belongs
+// to lane j % LANES, and word k of every lane's bit stream is stored next
+// to word k of the others. Unpacking then applies one shift and mask to a
+// row of LANES words at a time, which the compiler maps onto whole vector
+// registers; only the final running sum is sequential.
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sort_internal.h"
+
+#define LS_COL_MAGIC 0x4c4f4353u  // "SCOL" read as a little-endian uint32
+#define LS_COL_VERSION 1
+#define LS_COL_LANES 8
+#define LS_COL_ROWS (SORT_COL_BLOCK / LS_COL_LANES)  // deltas per lane
+#define LS_COL_BLOCK_HEADER 16
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t type;
+  uint32_t block;
+  uint64_t n;
+  uint64_t blocks;
+} ls_col_header;
+
+static inline uint64_t col_key(int type, const void* a, size_t i) {
+  if (type == SORT_COL_I32)
+    return ls_key_i32(((const int32_t*)a)[i]);
+  if (type == SORT_COL_F32)
+    return ls_key_f32(((const float*)a)[i]);
+  return ls_key_f64(((const double*)a)[i]);
+}
+
+static inline size_t col_value_size(int type) {
+  return type == SORT_COL_F64 ? sizeof(double) : sizeof(uint32_t);
+}
+
+static inline size_t col_block_bytes(int width) {
+  return LS_COL_BLOCK_HEADER + (size_t)LS_COL_ROWS * (size_t)width;
+}
+
+static size_t col_blocks(size_t n) {
+  return (n + SORT_COL_BLOCK - 1) / SORT_COL_BLOCK;
+}
+
+size_t sort_col_bound(int type, size_t n) {
+  const int max_width = type == SORT_COL_F64 ? 64 : 32;
+  return sizeof(ls_col_header) +
+         col_blocks(n) * (sizeof(uint64_t) + col_block_bytes(max_width));
+}
+
+// Keys of block b into k[0..SORT_COL_BLOCK), padded with the last key.
+// Returns the width of the widest delta, or -1 if the keys descend.
+static int col_block_keys(int type, const void* a, size_t n, size_t b,
+                          uint64_t* k) {
+  const size_t first = b * SORT_COL_BLOCK;
+  const size_t len = n - first < SORT_COL_BLOCK ? n - first : SORT_COL_BLOCK;
+  uint64_t or_deltas = 0;
+  k[0] = col_key(type, a, first);
+  for (size_t j = 1; j < len; j++) {
+    k[j] = col_key(type, a, first + j);
+    if (k[j] < k[j - 1])
+      return -1;
+    or_deltas |= k[j] - k[j - 1];
+  }
+  for (size_t j = len; j < SORT_COL_BLOCK; j++)
+    k[j] = k[len - 1];
+  return or_deltas ? 64 - __builtin_clzll(or_deltas) : 0;
+}
+
+static void col_pack(const uint64_t* k, int width, unsigned char* out) {
+  memcpy(out, &k[0], sizeof(uint64_t));
+  memset(out + sizeof(uint64_t), 0, LS_COL_BLOCK_HEADER - sizeof(uint64_t));
+  out[sizeof(uint64_t)] = (unsigned char)width;
+  uint64_t* words = (uint64_t*)(void*)(out + LS_COL_BLOCK_HEADER);
+  memset(words, 0, (size_t)LS_COL_ROWS * (size_t)width);
+  for (size_t j = 1; j < SORT_COL_BLOCK && width; j++) {
+    const uint64_t d = k[j] - k[j - 1];
+    const size_t lane = j % LS_COL_LANES;
+    const size_t bit = (j / LS_COL_LANES) * (size_t)width;
+    const size_t w = bit / 64, sh = bit % 64;
+    words[w * LS_COL_LANES + lane] |= d << sh;
+    if (sh + (size_t)width > 64)
+      words[(w + 1) * LS_COL_LANES + lane] |= d >> (64 - sh);
+  }
+}
+
+int sort_col_encode(sort_ctx* ctx, int type, const void* a, size_t n,
+                    void* out, size_t* bytes) {
+  if (!ctx || type < 0 || type >= LS_T_COUNT || (!a && n) || !out || !bytes)
+    return SORT_EINVAL;
+  const size_t blocks = col_blocks(n);
+  const int threads = ls_threads(ctx, n);
+  unsigned char* base = (unsigned char*)out;
+  uint64_t* index = (uint64_t*)(void*)(base + sizeof(ls_col_header));
+  int bad = 0;
+
+  // Widths first (stored in the index for now), then offsets, then the
+  // blocks themselves, each block on its own.
+  LS_PHASE_BEGIN(ctx);
+  long long count = (long long)blocks;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads) if (threads > 1)
+#endif
+  {
+    uint64_t k[SORT_COL_BLOCK];
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (long long b = 0; b < count; b++) {
+      int width = col_block_keys(type, a, n, (size_t)b, k);
+      if (width < 0) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+        bad = 1;
+        width = 0;
+      }
+      index[b] = (uint64_t)width;
+    }
+  }
+  if (bad)
+    return SORT_EINVAL;
+  size_t pos = sizeof(ls_col_header) + blocks * sizeof(uint64_t);
+  for (size_t b = 0; b < blocks; b++) {
+    size_t width = (size_t)index[b];
+    index[b] = pos;
+    pos += col_block_bytes((int)width);
+  }
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads) if (threads > 1)
+#endif
+  {
+    uint64_t k[SORT_COL_BLOCK];
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (long long b = 0; b < count; b++) {
+      int width = col_block_keys(type, a, n, (size_t)b, k);
+      col_pack(k, width, base + index[b]);
+    }
+  }
+  LS_PHASE_END(ctx, "column_encode", -1,
+               n * col_value_size(type) + pos);
+
+  ls_col_header h = {LS_COL_MAGIC, LS_COL_VERSION, (uint32_t)type,
+                     SORT_COL_BLOCK, (uint64_t)n, (uint64_t)blocks};
+  memcpy(base, &h, sizeof(h));
+  *bytes = pos;
+  return SORT_OK;
+}
+
+int sort_col_open(sort_col* c, const void* buf, size_t bytes) {
+  ls_col_header h;
+  if (!c || !buf || bytes < sizeof(h))
+    return SORT_EINVAL;
+  memcpy(&h, buf, sizeof(h));
+  if (h.magic != LS_COL_MAGIC || h.version != LS_COL_VERSION ||
+      h.type >= LS_T_COUNT || h.block != SORT_COL_BLOCK ||
+      h.blocks != col_blocks((size_t)h.n) ||
+      h.blocks > (bytes - sizeof(h)) / sizeof(uint64_t))
+    return SORT_EINVAL;
+  const unsigned char* base = (const unsigned char*)buf;
+  const uint64_t* index = (const uint64_t*)(const void*)(base + sizeof(h));
+  for (uint64_t b = 0; b < h.blocks; b++) {
+    if (index[b] > bytes - LS_COL_BLOCK_HEADER)
+      return SORT_EINVAL;
+    int width = base[index[b] + sizeof(uint64_t)];
+    if (width > 64 || index[b] + col_block_bytes(width) > bytes)
+      return SORT_EINVAL;
+  }
+  c->base = base;
+  c->bytes = bytes;
+  c->type = (int)h.type;
+  c->n = (size_t)h.n;
+  c->blocks = (size_t)h.blocks;
+  return SORT_OK;
+}
+
+// Deltas of one block, lane rows at a time.
+LS_DISPATCH static void col_unpack(const uint64_t* restrict words, int width,
+                                   uint64_t* restrict d) {
+  const uint64_t mask = width == 64 ? ~0ull : (1ull << width) - 1;
+  for (size_t r = 0; r < LS_COL_ROWS; r++) {
+    const size_t bit = r * (size_t)width;
+    const size_t w = bit / 64, sh = bit % 64;
+    const uint64_t* lo = words + w * LS_COL_LANES;
+    uint64_t* row = d + r * LS_COL_LANES;
+    if (sh + (size_t)width > 64) {
+      const uint64_t* hi = lo + LS_COL_LANES;
+      for (size_t l = 0; l < LS_COL_LANES; l++)
+        row[l] = ((lo[l] >> sh) | (hi[l] << (64 - sh))) & mask;
+    } else {
+      for (size_t l = 0; l < LS_COL_LANES; l++)
+        row[l] = (lo[l] >> sh) & mask;
+    }
+  }
+}
+
+// Keys k[0..SORT_COL_BLOCK) of block b.
+static void col_block_decode(const sort_col* c, size_t b, uint64_t* k) {
+  const uint64_t* index =
+      (const uint64_t*)(const void*)(c->base + sizeof(ls_col_header));
+  const unsigned char* blk = c->base + index[b];
+  const int width = blk[sizeof(uint64_t)];
+  uint64_t key;
+  memcpy(&key, blk, sizeof(key));
+  if (width == 0) {
+    for (size_t j = 0; j < SORT_COL_BLOCK; j++)
+      k[j] = key;
+    return;
+  }
+  col_unpack((const uint64_t*)(const void*)(blk + LS_COL_BLOCK_HEADER), width,
+             k);
+  k[0] = key;
+  for (size_t j = 1; j < SORT_COL_BLOCK; j++)
+    k[j] += k[j - 1];
+}
+
+static void col_store(int type, const uint64_t* k, size_t n, void* out) {
+  if (type == SORT_COL_I32) {
+    int32_t* o = (int32_t*)out;
+    for (size_t j = 0; j < n; j++)
+      o[j] = ls_from_key_i32((uint32_t)k[j]);
+  } else if (type == SORT_COL_F32) {
+    float* o = (float*)out;
+    for (size_t j = 0; j < n; j++)
+      o[j] = ls_from_key_f32((uint32_t)k[j]);
+  } else {
+    double* o = (double*)out;
+    for (size_t j = 0; j < n; j++)
+      o[j] = ls_from_key_f64(k[j]);
+  }
+}
+
+int sort_col_decode(sort_ctx* ctx, const sort_col* c, size_t first,
+                    size_t count, void* out) {
+  if (!ctx || !c || first > c->n || count > c->n - first || (!out && count))
+    return SORT_EINVAL;
+  if (count == 0)
+    return SORT_OK;
+  const size_t esz = col_value_size(c->type);
+  const size_t b0 = first / SORT_COL_BLOCK;
+  const size_t b1 = (first + count - 1) / SORT_COL_BLOCK;
+  const int threads = ls_threads(ctx, count);
+
+  LS_PHASE_BEGIN(ctx);
+  long long blocks = (long long)(b1 - b0 + 1);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads) if (threads > 1)
+#endif
+  {
+    uint64_t k[SORT_COL_BLOCK];
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (long long i = 0; i < blocks; i++) {
+      const size_t b = b0 + (size_t)i;
+      const size_t start = b * SORT_COL_BLOCK;
+      const size_t lo = start > first ? start : first;
+      size_t hi = start + SORT_COL_BLOCK;
+      if (hi > first + count)
+        hi = first + count;
+      col_block_decode(c, b, k);
+      col_store(c->type, k + (lo - start), hi - lo,
+                (char*)out + (lo - first) * esz);
+    }
+  }
+  LS_PHASE_END(ctx, "column_decode", -1, count * esz);
+  return SORT_OK;
+}
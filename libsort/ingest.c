@@ -0,0 +1,361 @@
+// Concurrent ingestion (sort_ingest_*).
+//
+// Every producer owns a slot, padded to its own cache lines, with a list of
+// LS_INGEST_BLOCK-key blocks and one LS_DIGIT_BITS digit histogram per
+// radix pass. Appending transforms the values into radix keys, stores them
+// in the producer's current block and counts every digit of every key while
+// it is in registers, so producers never share a written line and need no
+// lock. At finish the global histograms are the sums of the producers'.
+// The first pass that moves anything reads the blocks directly, split into
+// one element range per thread across producer boundaries, so a single
+// producer is scattered by the whole team; the blocks are never gathered
+// into one array. Passes whose digit is the same for every key are known
+// from the histograms and skipped without counting; the remaining passes
+// run on the contiguous result like sort_*.
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <stdlib.h>
+
+#include "sort_internal.h"
+
+#define LS_INGEST_BLOCK ((size_t)1 << 16)  // keys per block
+#define LS_INGEST_MAX_PASSES (64 / LS_DIGIT_BITS)
+
+typedef struct {
+  _Alignas(64) void** blocks;
+  size_t n_blocks;
+  size_t cap_blocks;
+  size_t fill;     // keys in the last block
+  size_t n;        // keys in all blocks
+  uint32_t* hist;  // passes x LS_BUCKETS digit counts, from the first append
+} ls_producer;
+
+struct sort_ingest {
+  sort_ctx* ctx;
+  int type;      // SORT_TYPE_*
+  int key_size;  // 4 or 8
+  int passes;
+  int producers;
+  ls_producer* p;
+};
+
+sort_ingest* sort_ingest_create(sort_ctx* ctx, int type, int producers) {
+  if (!ctx || type < 0 || type >= LS_T_COUNT || producers < 1)
+    return NULL;
+  sort_ingest* g = (sort_ingest*)calloc(1, sizeof(sort_ingest));
+  ls_producer* p = (ls_producer*)aligned_alloc(
+      _Alignof(ls_producer), (size_t)producers * sizeof(ls_producer));
+  if (!g || !p) {
+    free(g);
+    free(p);
+    return NULL;
+  }
+  memset(p, 0, (size_t)producers * sizeof(ls_producer));
+  g->ctx = ctx;
+  g->type = type;
+  g->key_size = type == LS_T_F64 ? 8 : 4;
+  g->passes = g->key_size * 8 / LS_DIGIT_BITS;
+  g->producers = producers;
+  g->p = p;
+  return g;
+}
+
+static void producer_reset(ls_producer* p) {
+  for (size_t b = 0; b < p->n_blocks; b++)
+    free(p->blocks[b]);
+  free(p->blocks);
+  free(p->hist);
+  memset(p, 0, sizeof(*p));
+}
+
+void sort_ingest_destroy(sort_ingest* g) {
+  if (!g)
+    return;
+  for (int i = 0; i < g->producers; i++)
+    producer_reset(&g->p[i]);
+  free(g->p);
+  free(g);
+}
+
+size_t sort_ingest_count(const sort_ingest* g) {
+  size_t n = 0;
+  for (int i = 0; g && i < g->producers; i++)
+    n += g->p[i].n;
+  return n;
+}
+
+// Keys and digit counts of v[0..n) into k and hist.
+static void append_u32(int type, const void* v, size_t n, uint32_t* k,
+                       uint32_t* hist) {
+  uint32_t* h0 = hist;
+  uint32_t* h1 = hist + LS_BUCKETS;
+  for (size_t i = 0; i < n; i++) {
+    uint32_t x = type == LS_T_I32 ? (uint32_t)ls_key_i32(((const int32_t*)v)[i])
+                                  : (uint32_t)ls_key_f32(((const float*)v)[i]);
+    k[i] = x;
+    h0[x & (LS_BUCKETS - 1)]++;
+    h1[x >> LS_DIGIT_BITS]++;
+  }
+}
+
+static void append_u64(const double* v, size_t n, uint64_t* k,
+                       uint32_t* hist) {
+  for (size_t i = 0; i < n; i++) {
+    uint64_t x = ls_key_f64(v[i]);
+    k[i] = x;
+    for (int d = 0; d < LS_INGEST_MAX_PASSES; d++) {
+      uint32_t digit = (uint32_t)(x >> (LS_DIGIT_BITS * d)) & (LS_BUCKETS - 1);
+      hist[(size_t)d * LS_BUCKETS + digit]++;
+    }
+  }
+}
+
+int sort_ingest_append(sort_ingest* g, int producer, const void* v,
+                       size_t n) {
+  if (!g || producer < 0 || producer >= g->producers || (!v && n))
+    return SORT_EINVAL;
+  ls_producer* p = &g->p[producer];
+  if (!p->hist) {
+    p->hist = (uint32_t*)calloc((size_t)g->passes * LS_BUCKETS,
+                                sizeof(uint32_t));
+    if (!p->hist)
+      return SORT_ENOMEM;
+  }
+  const char* src = (const char*)v;
+  while (n) {
+    if (p->n_blocks == 0 || p->fill == LS_INGEST_BLOCK) {
+      if (p->n_blocks == p->cap_blocks) {
+        size_t cap = p->cap_blocks ? 2 * p->cap_blocks : 16;
+        void** b = (void**)realloc(p->blocks, cap * sizeof(void*));
+        if (!b)
+          return SORT_ENOMEM;
+        p->blocks = b;
+        p->cap_blocks = cap;
+      }
+      void* blk = malloc(LS_INGEST_BLOCK * (size_t)g->key_size);
+      if (!blk)
+        return SORT_ENOMEM;
+      p->blocks[p->n_blocks++] = blk;
+      p->fill = 0;
+    }
+    size_t m = LS_INGEST_BLOCK - p->fill;
+    m = m < n ? m : n;
+    void* blk = p->blocks[p->n_blocks - 1];
+    if (g->key_size == 4)
+      append_u32(g->type, src, m, (uint32_t*)blk + p->fill, p->hist);
+    else
+      append_u64((const double*)(const void*)src, m,
+                 (uint64_t*)blk + p->fill, p->hist);
+    p->fill += m;
+    p->n += m;
+    src += m * (size_t)g->key_size;
+    n -= m;
+  }
+  return SORT_OK;
+}
+
+// Sums the producers' histograms into total (passes x LS_BUCKETS) and marks
+// the passes whose digit is the same for every key.
+static void ingest_totals(const sort_ingest* g, size_t n, uint32_t* total,
+                          int* trivial, int threads) {
+  long long cells = (long long)g->passes * LS_BUCKETS;
+  int single[LS_INGEST_MAX_PASSES] = {0};
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) if (threads > 1) \
+    schedule(static)
+#endif
+  for (long long c = 0; c < cells; c++) {
+    uint32_t sum = 0;
+    for (int i = 0; i < g->producers; i++)
+      if (g->p[i].hist)
+        sum += g->p[i].hist[c];
+    total[c] = sum;
+    if ((size_t)sum == n) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      single[c / LS_BUCKETS] = 1;
+    }
+  }
+  for (int d = 0; d < g->passes; d++)
+    trivial[d] = single[d];
+}
+
+// Counts (dst NULL) or scatters into dst the keys [first, last) of the
+// producers' blocks taken in order, by the digit at `shift`; row holds the
+// counts or the scatter offsets. Every block but a producer's last is full.
+static void ingest_range(const sort_ingest* g, size_t first, size_t last,
+                         int shift, uint32_t* row, void* dst) {
+  size_t left = last - first;
+  int i = 0;
+  while (left && first >= g->p[i].n)
+    first -= g->p[i++].n;
+  size_t b = first / LS_INGEST_BLOCK;
+  size_t j = first % LS_INGEST_BLOCK;
+  for (; left; i++, b = 0) {
+    const ls_producer* p = &g->p[i];
+    for (; b < p->n_blocks && left; b++, j = 0) {
+      size_t len = (b + 1 == p->n_blocks ? p->fill : LS_INGEST_BLOCK) - j;
+      len = len < left ? len : left;
+      left -= len;
+      if (g->key_size == 4) {
+        const uint32_t* k = (const uint32_t*)p->blocks[b] + j;
+        uint32_t* d = (uint32_t*)dst;
+        if (!d)
+          for (size_t x = 0; x < len; x++)
+            row[(k[x] >> shift) & (LS_BUCKETS - 1)]++;
+        else
+          for (size_t x = 0; x < len; x++)
+            d[row[(k[x] >> shift) & (LS_BUCKETS - 1)]++] = k[x];
+      } else {
+        const uint64_t* k = (const uint64_t*)p->blocks[b] + j;
+        uint64_t* d = (uint64_t*)dst;
+        if (!d)
+          for (size_t x = 0; x < len; x++)
+            row[(k[x] >> shift) & (LS_BUCKETS - 1)]++;
+        else
+          for (size_t x = 0; x < len; x++)
+            d[row[(k[x] >> shift) & (LS_BUCKETS - 1)]++] = k[x];
+      }
+    }
+  }
+}
+
+// First pass: scatters the keys of all producers' blocks into dst by the
+// digit of `pass`, one contiguous range of the blocks per thread, however
+// many producers filled them. Every range but the last counts its digits
+// into its row of the context's count tables; the last range's offsets are
+// what the totals leave, so a team of one counts nothing. total's row of
+// `pass` becomes the bucket starts.
+static void ingest_scatter(sort_ingest* g, uint32_t* total, int pass,
+                           size_t n, void* dst, int threads) {
+  uint32_t* start = total + (size_t)pass * LS_BUCKETS;
+  uint32_t pos = 0;
+  for (size_t d = 0; d < LS_BUCKETS; d++) {
+    uint32_t c = start[d];
+    start[d] = pos;
+    pos += c;
+  }
+
+  uint32_t* counts = (uint32_t*)g->ctx->counts;
+  const int shift = pass * LS_DIGIT_BITS;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads) if (threads > 1)
+#endif
+  {
+    const size_t tid = (size_t)ls_tid();
+    const size_t team = (size_t)ls_team();
+    const size_t first = n * tid / team;
+    const size_t last = n * (tid + 1) / team;
+    uint32_t* row = counts + tid * LS_BUCKETS;
+    if (tid + 1 < team) {
+      memset(row, 0, LS_BUCKETS * sizeof(uint32_t));
+      ingest_range(g, first, last, shift, row, NULL);
+    }
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+    // Row t of a bucket starts where rows 0..t-1 end.
+    const size_t b0 = LS_BUCKETS * tid / team;
+    const size_t b1 = LS_BUCKETS * (tid + 1) / team;
+    for (size_t d = b0; d < b1; d++) {
+      uint32_t at = start[d];
+      for (size_t t = 0; t + 1 < team; t++) {
+        uint32_t c = counts[t * LS_BUCKETS + d];
+        counts[t * LS_BUCKETS + d] = at;
+        at += c;
+      }
+      counts[(team - 1) * LS_BUCKETS + d] = at;
+    }
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+    ingest_range(g, first, last, shift, row, dst);
+  }
+}
+
+// All keys equal: the blocks are only concatenated.
+static void ingest_concat(const sort_ingest* g, void* dst) {
+  char* d = (char*)dst;
+  for (int i = 0; i < g->producers; i++) {
+    const ls_producer* p = &g->p[i];
+    for (size_t b = 0; b < p->n_blocks; b++) {
+      size_t len = b + 1 == p->n_blocks ? p->fill : LS_INGEST_BLOCK;
+      memcpy(d, p->blocks[b], len * (size_t)g->key_size);
+      d += len * (size_t)g->key_size;
+    }
+  }
+}
+
+int sort_ingest_finish(sort_ingest* g, void* out) {
+  if (!g)
+    return SORT_EINVAL;
+  sort_ctx* ctx = g->ctx;
+  const size_t n = sort_ingest_count(g);
+  if (n == 0)
+    return SORT_OK;
+  if (!out)
+    return SORT_EINVAL;
+  ls_plan plan;
+  ls_plan_for(ctx, g->type, n, 1, &plan);
+  int rc = ls_reserve(ctx, n, (size_t)g->key_size, 0, plan.threads);
+  uint32_t* total =
+      (uint32_t*)malloc((size_t)g->passes * LS_BUCKETS * sizeof(uint32_t));
+  if (rc != SORT_OK || !total) {
+    free(total);
+    return rc != SORT_OK ? rc : SORT_ENOMEM;
+  }
+
+  int trivial[LS_INGEST_MAX_PASSES];
+  LS_PHASE_BEGIN(ctx);
+  ingest_totals(g, n, total, trivial, plan.threads);
+  LS_PHASE_END(ctx, "ingest_histogram", -1,
+               (size_t)g->producers * (size_t)g->passes * LS_BUCKETS *
+                   sizeof(uint32_t));
+
+  // The passes that move keys alternate between out and the scratch
+  // buffer; the first one writes where an odd count ends up in out.
+  int moving = 0, first = -1;
+  for (int d = 0; d < g->passes; d++)
+    if (!trivial[d]) {
+      moving++;
+      first = first < 0 ? d : first;
+    }
+  void* src = moving % 2 ? out : ctx->keys[1];
+  void* dst = moving % 2 ? ctx->keys[1] : out;
+  const uint64_t key_bytes = n * (size_t)g->key_size;
+
+  LS_PHASE_BEGIN(ctx);
+  if (first < 0)
+    ingest_concat(g, out);
+  else
+    ingest_scatter(g, total, first, n, src, plan.threads);
+  LS_PHASE_END(ctx, "ingest_scatter", first, 2 * key_bytes);
+
+  for (int d = first + 1; first >= 0 && d < g->passes; d++) {
+    if (trivial[d])
+      continue;
+    LS_PHASE_BEGIN(ctx);
+    if (g->key_size == 4)
+      ls_radix_pass_u32(ctx, (const uint32_t*)src, (uint32_t*)dst, n,
+                        d * LS_DIGIT_BITS, LS_DIGIT_BITS, plan.threads);
+    else
+      ls_radix_pass_u64(ctx, (const uint64_t*)src, (uint64_t*)dst, n,
+                        d * LS_DIGIT_BITS, LS_DIGIT_BITS, plan.threads);
+    void* t = src;
+    src = dst;
+    dst = t;
+    LS_PHASE_END(ctx, "radix_pass", d, 3 * key_bytes);
+  }
+  free(total);
+
+  LS_PHASE_BEGIN(ctx);
+  ls_keys_to(g->type, out, n, plan.threads);
+  LS_PHASE_END(ctx, "key_untransform", -1, 2 * key_bytes);
+
+  for (int i = 0; i < g->producers; i++)
+    producer_reset(&g->p[i]);
+  return SORT_OK;
+}
@@ -0,0 +1,153 @@
+// k-way merge of sorted runs with a loser tree.
+//
+// tree[1..k-1] hold the loser of each internal match and tree[0] the
+// overall winner; run i is leaf k + i, so its parent is (k + i) / 2. After
+// the winner emits an element only its leaf-to-root path is replayed, one
+// key compare per level. Keys are the uint64 radix keys of the run heads,
+// so every element type compares as plain integers. Exhausted runs lose
+// every match; ties go to the lower run index, which keeps the merge
+// stable.
+//
+// With several threads the output is first cut into equal key ranges (a
+// binary search over the key space finds where each range starts in every
+// run), and each thread merges its range with its own loser tree.
+
+#include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sort_internal.h"
+
+typedef struct {
+  int k;
+  int* tree;
+  uint64_t* key;        // current head key per run
+  unsigned char* done;  // run exhausted
+} ls_loser_tree;
+
+static int lt_alloc(ls_loser_tree* t, int k) {
+  t->k = k;
+  t->tree = (int*)malloc((size_t)k * sizeof(int));
+  t->key = (uint64_t*)malloc((size_t)k * sizeof(uint64_t));
+  t->done = (unsigned char*)malloc((size_t)k);
+  if (t->tree && t->key && t->done)
+    return SORT_OK;
+  free(t->tree);
+  free(t->key);
+  free(t->done);
+  return SORT_ENOMEM;
+}
+
+static void lt_free(ls_loser_tree* t) {
+  free(t->tree);
+  free(t->key);
+  free(t->done);
+}
+
+// Exhausted runs also hold key UINT64_MAX, so the first compare almost
+// always decides and the done flags only break ties at the top key.
+static inline int lt_beats(const ls_loser_tree* t, int a, int b) {
+  if (t->key[a] != t->key[b])
+    return t->key[a] < t->key[b];
+  if (t->done[a] != t->done[b])
+    return t->done[b];
+  return a < b;
+}
+
+static int lt_build(ls_loser_tree* t, int node) {
+  if (node >= t->k)
+    return node - t->k;
+  int l = lt_build(t, 2 * node);
+  int r = lt_build(t, 2 * node + 1);
+  if (lt_beats(t, l, r)) {
+    t->tree[node] = r;
+    return l;
+  }
+  t->tree[node] = l;
+  return r;
+}
+
+static void lt_init(ls_loser_tree* t) {
+  t->tree[0] = lt_build(t, 1);
+}
+
+// The swap is written as selects so it compiles to conditional moves: the
+// outcome of each match is data dependent and would mispredict often.
+static inline void lt_replay(ls_loser_tree* t) {
+  int w = t->tree[0];
+  for (int node = (w + t->k) >> 1; node > 0; node >>= 1) {
+    int x = t->tree[node];
+    int swap = lt_beats(t, x, w);
+    t->tree[node] = swap ? w : x;
+    w = swap ? x : w;
+  }
+  t->tree[0] = w;
+}
+
+#define MERGE_PUBLIC
+
+#define MERGE_T int32_t
+#define MERGE_KEY(v) ls_key_i32(v)
+#define MERGE_FN(x) x##_i32
+#include "merge_impl.h"
+#undef MERGE_T
+#undef MERGE_KEY
+#undef MERGE_FN
+
+#define MERGE_T float
+#define MERGE_KEY(v) ls_key_f32(v)
+#define MERGE_FN(x) x##_f32
+#include "merge_impl.h"
+#undef MERGE_T
+#undef MERGE_KEY
+#undef MERGE_FN
+
+#define MERGE_T double
+#define MERGE_KEY(v) ls_key_f64(v)
+#define MERGE_FN(x) x##_f64
+#include "merge_impl.h"
+#undef MERGE_T
+#undef MERGE_KEY
+#undef MERGE_FN
+
+#undef MERGE_PUBLIC
+
+// Radix keys are already unsigned-ordered: the presorted-run path of
+// sort_* merges them directly.
+#define MERGE_T uint32_t
+#define MERGE_KEY(v) ((uint64_t)(v))
+#define MERGE_FN(x) x##_u32
+#include "merge_impl.h"
+#undef MERGE_T
+#undef MERGE_KEY
+#undef MERGE_FN
+
+#define MERGE_T uint64_t
+#define MERGE_KEY(v) (v)
+#define MERGE_FN(x) x##_u64
+#include "merge_impl.h"
+#undef MERGE_T
+#undef MERGE_KEY
+#undef MERGE_FN
+
+#define LS_DEFINE_MERGE_RUNS(key_t, sfx)                                  \
+  int ls_merge_runs_##sfx(const key_t* src, key_t* dst, size_t n,         \
+                          const size_t* starts, int k, int threads) {     \
+    const key_t** runs = (const key_t**)malloc((size_t)k * sizeof(void*)); \
+    size_t* lens = (size_t*)malloc((size_t)k * sizeof(size_t));           \
+    int rc = SORT_ENOMEM;                                                 \
+    if (runs && lens) {                                                   \
+      for (int i = 0; i < k; i++) {                                       \
+        runs[i] = src + starts[i];                                        \
+        lens[i] = (i + 1 < k ? starts[i + 1] : n) - starts[i];            \
+      }                                                                   \
+      rc = ls_merge_##sfx(runs, lens, k, dst, threads);                   \
+    }                                                                     \
+    free(runs);                                                           \
+    free(lens);                                                           \
+    return rc;                                                            \
+  }
+
+LS_DEFINE_MERGE_RUNS(uint32_t, u32)
+LS_DEFINE_MERGE_RUNS(uint64_t, u64)
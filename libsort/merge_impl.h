@@ -0,0 +1,144 @@
+// k-way merge bodies, included by merge.c once per element type with:
+//   MERGE_T       element type
+//   MERGE_KEY(v)  order-preserving uint64 key of an element (ls_key_*)
+//   MERGE_FN(x)   name mangler
+//   MERGE_PUBLIC  defined to also emit the public merge_* entry point
+
+// First index in run[0..n) whose key is >= key.
+static size_t MERGE_FN(lower_bound)(const MERGE_T* run, size_t n,
+                                    uint64_t key) {
+  size_t lo = 0, hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (MERGE_KEY(run[mid]) < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// cut[i] = number of elements of run i with keys below the largest key v
+// such that no more than `rank` elements overall lie below v. Cutting every
+// run there splits the merged output at (about) `rank`; all copies of one
+// key fall on the same side, so partitions merged independently are still
+// stable.
+static void MERGE_FN(split)(const MERGE_T* const* runs, const size_t* lens,
+                            int k, size_t rank, size_t* cut) {
+  uint64_t lo = 0, hi = UINT64_MAX;
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2 + 1;
+    size_t below = 0;
+    for (int i = 0; i < k; i++)
+      below += MERGE_FN(lower_bound)(runs[i], lens[i], mid);
+    if (below <= rank)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  for (int i = 0; i < k; i++)
+    cut[i] = MERGE_FN(lower_bound)(runs[i], lens[i], lo);
+}
+
+// Sequential loser-tree merge of runs[i][first[i] .. last[i]) into out.
+static int MERGE_FN(kway)(const MERGE_T* const* runs, const size_t* first,
+                          const size_t* last, int k, MERGE_T* out) {
+  ls_loser_tree t;
+  size_t* pos = (size_t*)malloc((size_t)k * sizeof(size_t));
+  if (!pos || lt_alloc(&t, k) != SORT_OK) {
+    free(pos);
+    return SORT_ENOMEM;
+  }
+  size_t total = 0;
+  for (int i = 0; i < k; i++) {
+    pos[i] = first[i];
+    t.done[i] = first[i] == last[i];
+    t.key[i] = t.done[i] ? UINT64_MAX : MERGE_KEY(runs[i][first[i]]);
+    total += last[i] - first[i];
+  }
+  lt_init(&t);
+
+  for (size_t o = 0; o < total; o++) {
+    int w = t.tree[0];
+    size_t i = pos[w];
+    out[o] = runs[w][i];
+    if (++i == last[w]) {
+      t.done[w] = 1;
+      t.key[w] = UINT64_MAX;
+    } else {
+      t.key[w] = MERGE_KEY(runs[w][i]);
+    }
+    pos[w] = i;
+    lt_replay(&t);
+  }
+  lt_free(&t);
+  free(pos);
+  return SORT_OK;
+}
+
+// Splits the output into one key range per thread of the team that starts
+// (at most `threads`) and merges each range on its own thread.
+static int MERGE_FN(ls_merge)(const MERGE_T* const* runs, const size_t* lens,
+                              int k, MERGE_T* out, int threads) {
+  size_t total = 0;
+  for (int i = 0; i < k; i++)
+    total += lens[i];
+  // cuts[t * k + i]: start of thread t's part of run i
+  size_t* cuts = (size_t*)malloc((size_t)(threads + 1) * (size_t)k *
+                                 sizeof(size_t));
+  if (!cuts)
+    return SORT_ENOMEM;
+  for (int i = 0; i < k; i++)
+    cuts[i] = 0;
+  int rc = SORT_OK;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads) if (threads > 1)
+#endif
+  {
+    const int tid = ls_tid();
+    const int team = ls_team();
+    if (tid > 0)
+      MERGE_FN(split)(runs, lens, k, (total * (size_t)tid) / (size_t)team,
+                      cuts + (size_t)tid * (size_t)k);
+    if (tid == team - 1)
+      for (int i = 0; i < k; i++)
+        cuts[(size_t)team * (size_t)k + (size_t)i] = lens[i];
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+    const size_t* first = cuts + (size_t)tid * (size_t)k;
+    const size_t* last = first + k;
+    size_t o = 0;
+    for (int i = 0; i < k; i++)
+      o += first[i];
+    if (MERGE_FN(kway)(runs, first, last, k, out + o) != SORT_OK) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      rc = SORT_ENOMEM;
+    }
+  }
+  free(cuts);
+  return rc;
+}
+
+#ifdef MERGE_PUBLIC
+int MERGE_FN(merge)(sort_ctx* ctx,
+                    const MERGE_T* const* runs,
+                    const size_t* lens,
+                    int k,
+                    MERGE_T* out) {
+  if (!ctx || k < 0)
+    return SORT_EINVAL;
+  if (k == 0)
+    return SORT_OK;
+  size_t total = 0;
+  for (int i = 0; i < k; i++)
+    total += lens[i];
+
+  LS_PHASE_BEGIN(ctx);
+  int rc = MERGE_FN(ls_merge)(runs, lens, k, out, ls_threads(ctx, total));
+  LS_PHASE_END(ctx, "merge", -1, 2 * total * sizeof(MERGE_T));
+  return rc;
+}
+#endif
@@ -0,0 +1,102 @@
+// Page-size aware allocation for sort buffers.
+//
+// Every buffer is an anonymous mapping rounded up to, and aligned on, 2 MB
+// so that transparent huge pages can back all of it. Buffers smaller than a
+// huge page never get huge pages: faulting a full 2 MB page to hold a few KB
+// would cost more than the TLB misses it saves.
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "sort_internal.h"
+
+#define LS_HUGE_PAGE ((size_t)2 << 20)
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23  // Linux 5.14+
+#endif
+#ifndef MADV_HUGEPAGE  // not Linux: advice becomes a no-op
+#define MADV_HUGEPAGE 0
+#define MADV_NOHUGEPAGE 0
+#endif
+
+size_t sort_alloc_size(size_t bytes) {
+  return (bytes + LS_HUGE_PAGE - 1) & ~(LS_HUGE_PAGE - 1);
+}
+
+static void* map_aligned(size_t len) {
+  // Over-map by one huge page and trim both ends to get 2 MB alignment.
+  size_t span = len + LS_HUGE_PAGE;
+  char* raw = (char*)mmap(NULL, span, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED)
+    return NULL;
+  uintptr_t base = (uintptr_t)raw;
+  uintptr_t aligned = (base + LS_HUGE_PAGE - 1) & ~(uintptr_t)(LS_HUGE_PAGE - 1);
+  size_t head = (size_t)(aligned - base);
+  if (head)
+    munmap(raw, head);
+  if (span - head > len)
+    munmap((char*)aligned + len, span - head - len);
+  return (void*)aligned;
+}
+
+static void prefault(void* p, size_t len) {
+  if (madvise(p, len, MADV_POPULATE_WRITE) == 0)
+    return;
+  // Older kernels: touch one byte per small page; the kernel maps whatever
+  // page size the region's advice allows.
+  size_t step = (size_t)sysconf(_SC_PAGESIZE);
+  for (size_t off = 0; off < len; off += step)
+    ((volatile char*)p)[off] = 0;
+}
+
+void* sort_alloc(size_t bytes, int pages, int populate) {
+  size_t len = sort_alloc_size(bytes ? bytes : 1);
+  void* p = NULL;
+
+#ifdef MAP_HUGETLB
+  if (pages == SORT_PAGES_HUGETLB && bytes >= LS_HUGE_PAGE) {
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p == MAP_FAILED) {
+      p = NULL;
+      pages = SORT_PAGES_THP;  // no reserved pool: fall back to THP
+    }
+  }
+#endif
+  if (!p) {
+    p = map_aligned(len);
+    if (!p)
+      return NULL;
+    if (pages == SORT_PAGES_SMALL || bytes < LS_HUGE_PAGE)
+      madvise(p, len, MADV_NOHUGEPAGE);
+    else if (pages == SORT_PAGES_THP || pages == SORT_PAGES_HUGETLB)
+      madvise(p, len, MADV_HUGEPAGE);
+  }
+
+  if (populate)
+    prefault(p, len);
+  return p;
+}
+
+void sort_free(void* p, size_t bytes) {
+  if (p)
+    munmap(p, sort_alloc_size(bytes ? bytes : 1));
+}
+
+int sort_pages_parse(const char* s) {
+  if (strcmp(s, "default") == 0)
+    return SORT_PAGES_DEFAULT;
+  if (strcmp(s, "small") == 0)
+    return SORT_PAGES_SMALL;
+  if (strcmp(s, "thp") == 0)
+    return SORT_PAGES_THP;
+  if (strcmp(s, "hugetlb") == 0)
+    return SORT_PAGES_HUGETLB;
+  return -1;
+}
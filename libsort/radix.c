@@ -0,0 +1,698 @@
+// Public sort / argsort entry points: key transform, LSD (or hybrid MSD + LSD)
+// radix, untransform.
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sort_internal.h"
+
+#define RADIX_KEY uint32_t
+#define RADIX_FN(x) x##_u32
+#include "radix_impl.h"
+#undef RADIX_KEY
+#undef RADIX_FN
+
+#define RADIX_KEY uint64_t
+#define RADIX_FN(x) x##_u64
+#include "radix_impl.h"
+#undef RADIX_KEY
+#undef RADIX_FN
+
+// ===================== ISA dispatch =====================
+// The streaming kernels below are compiled for AVX-512, AVX2 and baseline
+// x86-64 and picked at load time from CPUID (GCC/Clang target_clones), so a
+// portable build still runs the widest variant the host supports. The
+// transforms are written branch-free so every variant vectorizes.
+
+const char* sort_isa(void) {
+#if LS_HAVE_CLONES
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+    return "avx512";
+  if (__builtin_cpu_supports("avx2"))
+    return "avx2";
+#endif
+  return "scalar";
+}
+
+// The calling thread's contiguous slice of n items, as used by every
+// parallel loop in libsort: one of ls_team() equal parts.
+static void ls_slice(size_t n, size_t* start, size_t* len) {
+  size_t tid = (size_t)ls_tid();
+  size_t team = (size_t)ls_team();
+  size_t s = (n * tid) / team;
+  size_t e = (n * (tid + 1)) / team;
+  *start = s;
+  *len = e - s;
+}
+
+// ===================== radix key transforms =====================
+// flip: negative floats invert all bits, positives flip the sign bit, which
+// turns IEEE order into unsigned order; unflip is the inverse. Every
+// transform is elementwise, so source and destination may be one array.
+
+LS_DISPATCH static void from_i32_range(const int32_t* a, uint32_t* k,
+                                       size_t n) {
+  for (size_t i = 0; i < n; i++)
+    k[i] = ((uint32_t)a[i]) ^ 0x80000000u;
+}
+
+LS_DISPATCH static void to_i32_range(const uint32_t* k, int32_t* a, size_t n) {
+  for (size_t i = 0; i < n; i++)
+    a[i] = (int32_t)(k[i] ^ 0x80000000u);
+}
+
+LS_DISPATCH static void from_f32_range(const float* a, uint32_t* k, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    uint32_t x;
+    memcpy(&x, &a[i], sizeof(x));
+    k[i] = x ^ ((uint32_t)((int32_t)x >> 31) | 0x80000000u);
+  }
+}
+
+LS_DISPATCH static void to_f32_range(const uint32_t* k, float* a, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    uint32_t x = k[i] ^ ((uint32_t)((int32_t)~k[i] >> 31) | 0x80000000u);
+    memcpy(&a[i], &x, sizeof(x));
+  }
+}
+
+LS_DISPATCH static void from_i64_range(const int64_t* a, uint64_t* k,
+                                       size_t n) {
+  for (size_t i = 0; i < n; i++)
+    k[i] = ((uint64_t)a[i]) ^ 0x8000000000000000ull;
+}
+
+LS_DISPATCH static void to_i64_range(const uint64_t* k, int64_t* a, size_t n) {
+  for (size_t i = 0; i < n; i++)
+    a[i] = (int64_t)(k[i] ^ 0x8000000000000000ull);
+}
+
+LS_DISPATCH static void from_f64_range(const double* a, uint64_t* k,
+                                       size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    uint64_t x;
+    memcpy(&x, &a[i], sizeof(x));
+    k[i] = x ^ ((uint64_t)((int64_t)x >> 63) | 0x8000000000000000ull);
+  }
+}
+
+LS_DISPATCH static void to_f64_range(const uint64_t* k, double* a, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    uint64_t x =
+        k[i] ^ ((uint64_t)((int64_t)~k[i] >> 63) | 0x8000000000000000ull);
+    memcpy(&a[i], &x, sizeof(x));
+  }
+}
+
+// Transforms fused with the presortedness scan: count[0] receives the
+// descents and count[1] the ascents between neighbours of the slice. The
+// transform may run in place, so the slice is done in L1-sized chunks: the
+// neighbours of a chunk are compared while it still holds the input (a
+// read-only loop that vectorizes), then the chunk is transformed from L1.
+// Only the key before each chunk, already overwritten, is carried over.
+#define LS_SCAN_CHUNK 2048
+
+#define LS_DEFINE_SCAN_KERNEL(name, src_t, key_t, key_of)               \
+  LS_DISPATCH static void name(const src_t* a, key_t* k, size_t n,      \
+                               size_t* count) {                         \
+    size_t down = 0, up = 0;                                            \
+    key_t prev = n ? (key_t)key_of(a[0]) : 0;                           \
+    for (size_t s = 0; s < n; s += LS_SCAN_CHUNK) {                     \
+      const src_t* p = a + s;                                           \
+      size_t m = n - s < LS_SCAN_CHUNK ? n - s : LS_SCAN_CHUNK;         \
+      key_t x = (key_t)key_of(p[0]);                                    \
+      down += x < prev;                                                 \
+      up += x > prev;                                                   \
+      for (size_t i = 1; i < m; i++) {                                  \
+        key_t cur = (key_t)key_of(p[i]);                                \
+        key_t before = (key_t)key_of(p[i - 1]);                         \
+        down += cur < before;                                           \
+        up += cur > before;                                             \
+      }                                                                 \
+      prev = (key_t)key_of(p[m - 1]);                                   \
+      for (size_t i = 0; i < m; i++)                                    \
+        k[s + i] = (key_t)key_of(p[i]);                                 \
+    }                                                                   \
+    count[0] = down;                                                    \
+    count[1] = up;                                                      \
+  }
+
+LS_DEFINE_SCAN_KERNEL(from_i32_scan_range, int32_t, uint32_t, ls_key_i32)
+LS_DEFINE_SCAN_KERNEL(from_f32_scan_range, float, uint32_t, ls_key_f32)
+LS_DEFINE_SCAN_KERNEL(from_i64_scan_range, int64_t, uint64_t, ls_key_i64)
+LS_DEFINE_SCAN_KERNEL(from_f64_scan_range, double, uint64_t, ls_key_f64)
+
+LS_DISPATCH static void iota_range(uint32_t* idx, size_t first, size_t n) {
+  for (size_t i = 0; i < n; i++)
+    idx[i] = (uint32_t)(first + i);
+}
+
+LS_DISPATCH static void gather32_range(const uint32_t* keys,
+                                      const uint32_t* idx,
+                                      uint32_t* k,
+                                      size_t n) {
+  for (size_t i = 0; i < n; i++)
+    k[i] = keys[idx[i]];
+}
+
+LS_DISPATCH static void gather64_range(const uint64_t* keys,
+                                      const uint32_t* idx,
+                                      uint64_t* k,
+                                      size_t n) {
+  for (size_t i = 0; i < n; i++)
+    k[i] = keys[idx[i]];
+}
+
+// Parallel drivers: each thread runs the dispatched kernel on its slice.
+#ifdef _OPENMP
+#define LS_PARALLEL(threads) \
+  _Pragma("omp parallel num_threads(threads) if (threads > 1)")
+#define LS_ATOMIC _Pragma("omp atomic")
+#else
+#define LS_PARALLEL(threads) (void)(threads);
+#define LS_ATOMIC
+#endif
+
+#define LS_DEFINE_XFORM(name, kernel, src_t, dst_t)                   \
+  static void name(const src_t* src, dst_t* dst, size_t n, int threads) { \
+    LS_PARALLEL(threads) {                                            \
+      size_t s, len;                                                  \
+      ls_slice(n, &s, &len);                                          \
+      kernel(src + s, dst + s, len);                                  \
+    }                                                                 \
+  }
+
+LS_DEFINE_XFORM(keys_from_i32, from_i32_range, int32_t, uint32_t)
+LS_DEFINE_XFORM(keys_to_i32, to_i32_range, uint32_t, int32_t)
+LS_DEFINE_XFORM(keys_from_f32, from_f32_range, float, uint32_t)
+LS_DEFINE_XFORM(keys_to_f32, to_f32_range, uint32_t, float)
+LS_DEFINE_XFORM(keys_from_i64, from_i64_range, int64_t, uint64_t)
+LS_DEFINE_XFORM(keys_to_i64, to_i64_range, uint64_t, int64_t)
+LS_DEFINE_XFORM(keys_from_f64, from_f64_range, double, uint64_t)
+LS_DEFINE_XFORM(keys_to_f64, to_f64_range, uint64_t, double)
+
+#define LS_DEFINE_GATHER(name, kernel, key_t)                            \
+  static void name(const key_t* keys, const uint32_t* idx, key_t* dst,  \
+                   size_t n, int threads) {                             \
+    LS_PARALLEL(threads) {                                              \
+      size_t s, len;                                                    \
+      ls_slice(n, &s, &len);                                            \
+      kernel(keys, idx + s, dst + s, len);                              \
+    }                                                                   \
+  }
+
+LS_DEFINE_GATHER(keys_gather_u32, gather32_range, uint32_t)
+LS_DEFINE_GATHER(keys_gather_u64, gather64_range, uint64_t)
+
+// Scan drivers also count the neighbours across slice boundaries, so
+// count[0..1] cover the whole array.
+#define LS_DEFINE_XFORM_SCAN(name, kernel, src_t, dst_t)                  \
+  static void name(const src_t* src, dst_t* dst, size_t n, int threads,   \
+                   size_t* count) {                                       \
+    size_t down = 0, up = 0;                                              \
+    int team = 1;                                                         \
+    LS_PARALLEL(threads) {                                                \
+      size_t s, len, c[2];                                                \
+      ls_slice(n, &s, &len);                                              \
+      kernel(src + s, dst + s, len, c);                                   \
+      if (ls_tid() == 0)                                                  \
+        team = ls_team();                                                 \
+      LS_ATOMIC                                                           \
+      down += c[0];                                                       \
+      LS_ATOMIC                                                           \
+      up += c[1];                                                         \
+    }                                                                     \
+    for (int t = 1; t < team; t++) {                                      \
+      size_t s = (n * (size_t)t) / (size_t)team;                          \
+      if (s > 0 && s < n) {                                               \
+        down += dst[s] < dst[s - 1];                                      \
+        up += dst[s] > dst[s - 1];                                        \
+      }                                                                   \
+    }                                                                     \
+    count[0] = down;                                                      \
+    count[1] = up;                                                        \
+  }
+
+LS_DEFINE_XFORM_SCAN(keys_from_i32_scan, from_i32_scan_range, int32_t,
+                     uint32_t)
+LS_DEFINE_XFORM_SCAN(keys_from_f32_scan, from_f32_scan_range, float, uint32_t)
+LS_DEFINE_XFORM_SCAN(keys_from_i64_scan, from_i64_scan_range, int64_t,
+                     uint64_t)
+LS_DEFINE_XFORM_SCAN(keys_from_f64_scan, from_f64_scan_range, double,
+                     uint64_t)
+
+static void iota_u32(uint32_t* idx, size_t n, int threads) {
+  LS_PARALLEL(threads) {
+    size_t s, len;
+    ls_slice(n, &s, &len);
+    iota_range(idx + s, s, len);
+  }
+}
+
+// A merge of k runs costs about log2(k) unpredictable compares per element,
+// a radix sort one scatter per pass. Measured, the merge wins while
+// log2(k) <= passes: up to 4 runs for 32-bit keys with 16-bit digits, 16
+// runs for 64-bit keys.
+static int ls_merge_pays(size_t runs, int key_bits, int digit_bits) {
+  int passes = (key_bits + digit_bits - 1) / digit_bits;
+  return runs <= ((size_t)1 << (passes < 4 ? passes : 4));
+}
+
+// Merges the `runs` ascending runs of src into dst; returns dst, or NULL
+// when out of memory.
+#define LS_DEFINE_PRESORTED(key_t, sfx)                                   \
+  static key_t* ls_presorted_##sfx(sort_ctx* ctx, key_t* src, key_t* dst, \
+                                   size_t n, int runs, int threads) {     \
+    size_t starts[LS_MAX_MERGE_RUNS];                                     \
+    LS_PHASE_BEGIN(ctx);                                                  \
+    runs = ls_run_starts_##sfx(src, n, starts, runs, threads);            \
+    int rc = ls_merge_runs_##sfx(src, dst, n, starts, runs, threads);     \
+    LS_PHASE_END(ctx, "run_merge", runs, 3 * n * sizeof(key_t));          \
+    return rc == SORT_OK ? dst : NULL;                                    \
+  }
+
+LS_DEFINE_PRESORTED(uint32_t, u32)
+LS_DEFINE_PRESORTED(uint64_t, u64)
+
+// ===================== hybrid MSD + LSD (64-bit keys) =====================
+// One parallel MSD pass on the top digit, starting at the highest bit that
+// differs between the smallest and largest key, cuts src into buckets in
+// dst, with the digit wide enough that an average bucket and its scratch
+// fit in L2. Each bucket is then finished by LSD passes on the bits below
+// that digit inside its own region, with the same region of src as
+// scratch; buckets are handed out to threads dynamically. While buckets
+// stay cache resident the keys cross DRAM twice (range scan, MSD scatter)
+// instead of once per LSD pass. Buckets too large for that (skewed keys,
+// such as doubles sharing an exponent) are split again the same way.
+#define LS_HYBRID_BUCKET_KEYS ((size_t)1 << 15)  // average bucket target
+#define LS_HYBRID_LOCAL_MAX ((size_t)1 << 16)    // larger: split again
+#define LS_HYBRID_LOCAL_BITS 11                  // bucket LSD digit width
+
+LS_DISPATCH static void minmax_range(const uint64_t* k, size_t n,
+                                     uint64_t* lo, uint64_t* hi) {
+  uint64_t a = UINT64_MAX, b = 0;
+  for (size_t i = 0; i < n; i++) {
+    a = k[i] < a ? k[i] : a;
+    b = k[i] > b ? k[i] : b;
+  }
+  *lo = a;
+  *hi = b;
+}
+
+static void keys_minmax_u64(const uint64_t* k, size_t n, int threads,
+                            uint64_t* lo, uint64_t* hi) {
+  uint64_t mn = UINT64_MAX, mx = 0;
+  LS_PARALLEL(threads) {
+    size_t s, len;
+    uint64_t a, b;
+    ls_slice(n, &s, &len);
+    minmax_range(k + s, len, &a, &b);
+#ifdef _OPENMP
+#pragma omp critical(ls_minmax)
+#endif
+    {
+      mn = a < mn ? a : mn;
+      mx = b > mx ? b : mx;
+    }
+  }
+  *lo = mn;
+  *hi = mx;
+}
+
+// Sequential LSD of k[0..n) with tmp as scratch, over the bits that differ
+// between the keys; the counts of every pass come from one read. table
+// holds at least 6 << LS_HYBRID_LOCAL_BITS entries.
+static void ls_local_lsd_u64(uint64_t* k, uint64_t* tmp, size_t n,
+                             uint32_t* table) {
+  uint64_t diff = 0;
+  for (size_t i = 0; i < n; i++)
+    diff |= k[i] ^ k[0];
+  if (!diff)
+    return;
+  const int low = __builtin_ctzll(diff);
+  const int bits = 64 - __builtin_clzll(diff) - low;
+  const int passes = (bits + LS_HYBRID_LOCAL_BITS - 1) / LS_HYBRID_LOCAL_BITS;
+  const int digit = (bits + passes - 1) / passes;
+  const size_t buckets = (size_t)1 << digit;
+  const uint64_t mask = buckets - 1;
+  memset(table, 0, (size_t)passes * buckets * sizeof(uint32_t));
+  for (size_t i = 0; i < n; i++) {
+    uint64_t x = k[i] >> low;
+    for (int p = 0; p < passes; p++)
+      table[(size_t)p * buckets + ((x >> (p * digit)) & mask)]++;
+  }
+
+  uint64_t* src = k;
+  uint64_t* dst = tmp;
+  for (int p = 0; p < passes; p++) {
+    uint32_t* c = table + (size_t)p * buckets;
+    int shift = low + p * digit;
+    if (c[(src[0] >> shift) & mask] == n)
+      continue;
+    uint32_t pos = 0;
+    for (size_t d = 0; d < buckets; d++) {
+      uint32_t v = c[d];
+      c[d] = pos;
+      pos += v;
+    }
+    for (size_t i = 0; i < n; i++) {
+      uint64_t x = src[i];
+      dst[c[(x >> shift) & mask]++] = x;
+    }
+    uint64_t* t = src;
+    src = dst;
+    dst = t;
+  }
+  if (src != k)
+    memcpy(k, src, n * sizeof(uint64_t));
+}
+
+// Sorts src[0..n) and returns the buffer holding the result (src or dst),
+// or NULL when out of memory.
+static uint64_t* ls_hybrid_u64(sort_ctx* ctx, uint64_t* src, uint64_t* dst,
+                               size_t n, int threads) {
+  uint64_t lo, hi;
+  LS_PHASE_BEGIN(ctx);
+  keys_minmax_u64(src, n, threads, &lo, &hi);
+  LS_PHASE_END(ctx, "key_range", -1, n * sizeof(uint64_t));
+  if (lo == hi)
+    return src;
+  const int top = 63 - __builtin_clzll(lo ^ hi);  // highest differing bit
+  int bits = 8;
+  while (bits < LS_DIGIT_BITS && (n >> bits) > LS_HYBRID_BUCKET_KEYS)
+    bits++;
+  if (bits > top + 1)
+    bits = top + 1;
+  const int shift = top + 1 - bits;
+  const size_t buckets = (size_t)1 << bits;
+
+  // Bit `top` differs between two keys, so this pass always moves them.
+  LS_PHASE_BEGIN(ctx);
+  const int team = ls_pass_u64(ctx, src, dst, NULL, NULL, n, shift, bits,
+                               threads);
+  LS_PHASE_END(ctx, "msd_pass", -1, 3 * n * sizeof(uint64_t));
+  if (shift == 0)
+    return dst;  // the MSD digit was the whole remaining key
+
+  // Bucket ends from the last thread's offsets; the oversized buckets are
+  // noted now because splitting them reuses the offset tables.
+  const uint32_t* ends =
+      (const uint32_t*)ctx->offsets + (size_t)(team - 1) * buckets;
+  size_t* large = (size_t*)malloc(2 * (n / LS_HYBRID_LOCAL_MAX + 1) *
+                                  sizeof(size_t));
+  if (!large)
+    return NULL;
+  size_t n_large = 0;
+  for (size_t b = 0; b < buckets; b++) {
+    size_t s = b ? ends[b - 1] : 0;
+    if (ends[b] - s > LS_HYBRID_LOCAL_MAX) {
+      large[2 * n_large] = s;
+      large[2 * n_large + 1] = ends[b] - s;
+      n_large++;
+    }
+  }
+
+  LS_PHASE_BEGIN(ctx);
+  uint32_t* tables = (uint32_t*)ctx->counts;
+  long long count = (long long)buckets;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) if (threads > 1) \
+    schedule(dynamic, 1)
+#endif
+  for (long long b = 0; b < count; b++) {
+    size_t s = b ? ends[b - 1] : 0;
+    size_t len = ends[b] - s;
+    if (len < 2 || len > LS_HYBRID_LOCAL_MAX)
+      continue;
+    if (len < LS_INTROSORT_MAX_N) {
+      ls_introsort_u64(dst + s, len);
+    } else {
+#ifdef _OPENMP
+      size_t tid = (size_t)omp_get_thread_num();
+#else
+      size_t tid = 0;
+#endif
+      ls_local_lsd_u64(dst + s, src + s, len, tables + tid * LS_BUCKETS);
+    }
+  }
+  LS_PHASE_END(ctx, "bucket_lsd", (int)buckets, 2 * n * sizeof(uint64_t));
+
+  for (size_t i = 0; i < n_large; i++) {
+    uint64_t* r = dst + large[2 * i];
+    size_t len = large[2 * i + 1];
+    uint64_t* res =
+        ls_hybrid_u64(ctx, r, src + large[2 * i], len, threads);
+    if (!res) {
+      free(large);
+      return NULL;
+    }
+    if (res != r)
+      memcpy(r, res, len * sizeof(uint64_t));
+  }
+  free(large);
+  return dst;
+}
+
+// ===================== single passes =====================
+// For engines outside this file (ingest.c) that bring their own first pass
+// and need the inverse transform afterwards.
+
+int ls_radix_pass_u32(sort_ctx* ctx, const uint32_t* src, uint32_t* dst,
+                      size_t n, int shift, int bits, int threads) {
+  return ls_pass_u32(ctx, src, dst, NULL, NULL, n, shift, bits, threads);
+}
+
+int ls_radix_pass_u64(sort_ctx* ctx, const uint64_t* src, uint64_t* dst,
+                      size_t n, int shift, int bits, int threads) {
+  return ls_pass_u64(ctx, src, dst, NULL, NULL, n, shift, bits, threads);
+}
+
+void ls_keys_to(int type, void* a, size_t n, int threads) {
+  if (type == LS_T_I32)
+    keys_to_i32((const uint32_t*)a, (int32_t*)a, n, threads);
+  else if (type == LS_T_F32)
+    keys_to_f32((const uint32_t*)a, (float*)a, n, threads);
+  else
+    keys_to_f64((const uint64_t*)a, (double*)a, n, threads);
+}
+
+// ===================== sort =====================
+// Keys are transformed in place in the caller's array, which then serves as
+// the first LSD ping-pong buffer with arena buffer 1 as the only scratch:
+// an even pass count ends back in the array, an odd one (or the run merge)
+// in the scratch buffer, and the inverse transform writes the result into
+// the array either way. The transform also counts descents and ascents, so
+// sorted input skips straight to the inverse transform and reversed input
+// is reversed in place.
+
+// One entry point per element type: elem_t elements, keys_{from,to}_xform
+// transforms to W-bit keys, planned as plan_type. hybrid_fn is the hybrid
+// MSD + LSD engine for the key width, or NULL where there is none (32-bit
+// keys run SORT_ENGINE_HYBRID as LSD).
+#define LS_DEFINE_SORT(name, elem_t, xform, W, plan_type, hybrid_fn)         \
+  int name(sort_ctx* ctx, elem_t* a, size_t n) {                             \
+    if (!ctx)                                                                \
+      return SORT_EINVAL;                                                    \
+    if (n <= 1)                                                              \
+      return SORT_OK;                                                        \
+    uint##W##_t* (*const hybrid)(sort_ctx*, uint##W##_t*, uint##W##_t*,      \
+                                 size_t, int) = hybrid_fn;                   \
+    ls_plan plan;                                                            \
+    ls_plan_for(ctx, plan_type, n, 0, &plan);                                \
+    int rc = ls_reserve(ctx, n, sizeof(uint##W##_t), 0, plan.threads);       \
+    if (rc != SORT_OK)                                                       \
+      return rc;                                                             \
+    uint##W##_t* keys = (uint##W##_t*)(void*)a;                              \
+    uint##W##_t* src = keys;                                                 \
+    uint##W##_t* dst = (uint##W##_t*)ctx->keys[1];                           \
+                                                                             \
+    size_t count[2] = {SIZE_MAX, SIZE_MAX}; /* descents, ascents; unknown */ \
+    LS_PHASE_BEGIN(ctx);                                                     \
+    if (ctx->tuning.no_presort_check)                                        \
+      keys_from_##xform(a, keys, n, plan.threads);                           \
+    else                                                                     \
+      keys_from_##xform##_scan(a, keys, n, plan.threads, count);             \
+    LS_PHASE_END(ctx, "key_transform", -1, 2 * n * sizeof(uint##W##_t));     \
+                                                                             \
+    if (count[0] == 0) {                                                     \
+      /* already in order: only the transform is undone */                   \
+    } else if (count[1] == 0) {                                              \
+      LS_PHASE_BEGIN(ctx);                                                   \
+      ls_reverse_u##W(keys, n, plan.threads);                                \
+      LS_PHASE_END(ctx, "reverse", -1, 2 * n * sizeof(uint##W##_t));         \
+    } else if (count[0] < LS_MAX_MERGE_RUNS &&                               \
+               ls_merge_pays(count[0] + 1, W, plan.digit_bits)) {            \
+      src = ls_presorted_u##W(ctx, keys, dst, n, (int)count[0] + 1,          \
+                              plan.threads);                                 \
+      if (!src)                                                              \
+        return SORT_ENOMEM;                                                  \
+    } else if (plan.engine == SORT_ENGINE_INTROSORT) {                       \
+      ls_introsort_u##W(src, n);                                             \
+    } else if (hybrid && plan.engine == SORT_ENGINE_HYBRID) {                \
+      src = hybrid(ctx, src, dst, n, plan.threads);                          \
+      if (!src)                                                              \
+        return SORT_ENOMEM;                                                  \
+    } else {                                                                 \
+      src = ls_lsd_u##W(ctx, src, dst, NULL, NULL, n, plan.digit_bits,       \
+                        plan.threads);                                       \
+    }                                                                        \
+                                                                             \
+    LS_PHASE_BEGIN(ctx);                                                     \
+    keys_to_##xform(src, a, n, plan.threads);                                \
+    LS_PHASE_END(ctx, "key_untransform", -1, 2 * n * sizeof(uint##W##_t));   \
+    return SORT_OK;                                                          \
+  }
+
+LS_DEFINE_SORT(sort_i32, int32_t, i32, 32, LS_T_I32, NULL)
+LS_DEFINE_SORT(sort_f32, float, f32, 32, LS_T_F32, NULL)
+LS_DEFINE_SORT(sort_f64, double, f64, 64, LS_T_F64, ls_hybrid_u64)
+// Planned as sort_f64: same key width, and profiles have no int64 entries.
+LS_DEFINE_SORT(sort_i64, int64_t, i64, 64, LS_T_F64, ls_hybrid_u64)
+
+// ===================== argsort =====================
+// The caller's idx array is one of the two index ping-pong buffers, so only
+// one index scratch buffer is needed and an even pass count needs no copy.
+
+int argsort_i32(sort_ctx* ctx, const int32_t* a, size_t n, uint32_t* idx) {
+  if (!ctx)
+    return SORT_EINVAL;
+  if (n == 0)
+    return SORT_OK;
+  ls_plan plan;
+  ls_plan_for(ctx, LS_T_I32, n, 1, &plan);
+  int rc = ls_reserve(ctx, n, sizeof(uint32_t), 1, plan.threads);
+  if (rc != SORT_OK)
+    return rc;
+  uint32_t* src = (uint32_t*)ctx->keys[0];
+  uint32_t* dst = (uint32_t*)ctx->keys[1];
+
+  LS_PHASE_BEGIN(ctx);
+  keys_from_i32(a, src, n, plan.threads);
+  iota_u32(idx, n, plan.threads);
+  LS_PHASE_END(ctx, "key_transform", -1,
+               n * (2 * sizeof(uint32_t) + sizeof(uint32_t)));
+
+  uint32_t* res = idx;
+  ls_lsd_u32(ctx, src, dst, &res, (uint32_t*)ctx->idx, n, plan.digit_bits,
+             plan.threads);
+  if (res != idx)
+    memcpy(idx, res, n * sizeof(uint32_t));
+  return SORT_OK;
+}
+
+int argsort_f32(sort_ctx* ctx, const float* a, size_t n, uint32_t* idx) {
+  if (!ctx)
+    return SORT_EINVAL;
+  if (n == 0)
+    return SORT_OK;
+  ls_plan plan;
+  ls_plan_for(ctx, LS_T_F32, n, 1, &plan);
+  int rc = ls_reserve(ctx, n, sizeof(uint32_t), 1, plan.threads);
+  if (rc != SORT_OK)
+    return rc;
+  uint32_t* src = (uint32_t*)ctx->keys[0];
+  uint32_t* dst = (uint32_t*)ctx->keys[1];
+
+  LS_PHASE_BEGIN(ctx);
+  keys_from_f32(a, src, n, plan.threads);
+  iota_u32(idx, n, plan.threads);
+  LS_PHASE_END(ctx, "key_transform", -1,
+               n * (2 * sizeof(uint32_t) + sizeof(uint32_t)));
+
+  uint32_t* res = idx;
+  ls_lsd_u32(ctx, src, dst, &res, (uint32_t*)ctx->idx, n, plan.digit_bits,
+             plan.threads);
+  if (res != idx)
+    memcpy(idx, res, n * sizeof(uint32_t));
+  return SORT_OK;
+}
+
+int argsort_f64(sort_ctx* ctx, const double* a, size_t n, uint32_t* idx) {
+  if (!ctx)
+    return SORT_EINVAL;
+  if (n == 0)
+    return SORT_OK;
+  ls_plan plan;
+  ls_plan_for(ctx, LS_T_F64, n, 1, &plan);
+  int rc = ls_reserve(ctx, n, sizeof(uint64_t), 1, plan.threads);
+  if (rc != SORT_OK)
+    return rc;
+  uint64_t* src = (uint64_t*)ctx->keys[0];
+  uint64_t* dst = (uint64_t*)ctx->keys[1];
+
+  LS_PHASE_BEGIN(ctx);
+  keys_from_f64(a, src, n, plan.threads);
+  iota_u32(idx, n, plan.threads);
+  LS_PHASE_END(ctx, "key_transform", -1,
+               n * (2 * sizeof(uint64_t) + sizeof(uint32_t)));
+
+  uint32_t* res = idx;
+  ls_lsd_u64(ctx, src, dst, &res, (uint32_t*)ctx->idx, n, plan.digit_bits,
+             plan.threads);
+  if (res != idx)
+    memcpy(idx, res, n * sizeof(uint32_t));
+  return SORT_OK;
+}
+
+// ===================== argsort refine =====================
+// Keys are gathered into the current order, then LSD-sorted with idx as the
+// payload; LSD is stable, so ties keep the incoming order.
+
+int argsort_refine_u32(sort_ctx* ctx, const uint32_t* keys, size_t n,
+                       uint32_t* idx) {
+  if (!ctx)
+    return SORT_EINVAL;
+  if (n <= 1)
+    return SORT_OK;
+  ls_plan plan;
+  ls_plan_for(ctx, LS_T_I32, n, 1, &plan);
+  int rc = ls_reserve(ctx, n, sizeof(uint32_t), 1, plan.threads);
+  if (rc != SORT_OK)
+    return rc;
+  uint32_t* src = (uint32_t*)ctx->keys[0];
+  uint32_t* dst = (uint32_t*)ctx->keys[1];
+
+  LS_PHASE_BEGIN(ctx);
+  keys_gather_u32(keys, idx, src, n, plan.threads);
+  LS_PHASE_END(ctx, "key_gather", -1,
+               n * (2 * sizeof(uint32_t) + sizeof(uint32_t)));
+
+  uint32_t* res = idx;
+  ls_lsd_u32(ctx, src, dst, &res, (uint32_t*)ctx->idx, n, plan.digit_bits,
+             plan.threads);
+  if (res != idx)
+    memcpy(idx, res, n * sizeof(uint32_t));
+  return SORT_OK;
+}
+
+int argsort_refine_u64(sort_ctx* ctx, const uint64_t* keys, size_t n,
+                       uint32_t* idx) {
+  if (!ctx)
+    return SORT_EINVAL;
+  if (n <= 1)
+    return SORT_OK;
+  ls_plan plan;
+  ls_plan_for(ctx, LS_T_F64, n, 1, &plan);
+  int rc = ls_reserve(ctx, n, sizeof(uint64_t), 1, plan.threads);
+  if (rc != SORT_OK)
+    return rc;
+  uint64_t* src = (uint64_t*)ctx->keys[0];
+  uint64_t* dst = (uint64_t*)ctx->keys[1];
+
+  LS_PHASE_BEGIN(ctx);
+  keys_gather_u64(keys, idx, src, n, plan.threads);
+  LS_PHASE_END(ctx, "key_gather", -1,
+               n * (2 * sizeof(uint64_t) + sizeof(uint32_t)));
+
+  uint32_t* res = idx;
+  ls_lsd_u64(ctx, src, dst, &res, (uint32_t*)ctx->idx, n, plan.digit_bits,
+             plan.threads);
+  if (res != idx)
+    memcpy(idx, res, n * sizeof(uint32_t));
+  return SORT_OK;
+}
@@ -0,0 +1,360 @@
+// Sort engine bodies, included by radix.c once per key width with:
+//   RADIX_KEY    unsigned key type (uint32_t / uint64_t)
+//   RADIX_FN(x)  name mangler
+//
+// LSD radix: each thread counts digits over its contiguous slice into its
+// own table, the tables are turned into per-thread scatter offsets, and each
+// thread scatters its slice. Slices are scattered in thread order, so the
+// sort is stable and can carry a uint32 index payload. The offsets come
+// from a parallel scan: every thread owns a range of buckets and walks the
+// count tables row by row over that range, so no thread reads a table
+// column with a 2^bits stride. The digit width is a
+// runtime parameter (8..16 bits): narrow digits mean more passes but count
+// tables that stay in L1/L2 and cheaper per-pass setup on small inputs.
+//
+// Introsort: in-place comparison sort on the keys for inputs too small to
+// amortize radix setup. Not stable, so argsort never uses it.
+//
+// Presorted fast paths: run_starts and reverse back the sorted / reversed /
+// few-runs shortcuts that sort_* takes after the fused presortedness scan.
+
+// Digit counts of src[start..end) into local. Long enough slices send
+// consecutive keys to LS_HIST_TABLES interleaved tables (local, then the
+// `buckets`-sized tables in sub), so a run of equal digits makes
+// independent increment chains rather than one chain of store-to-load
+// forwards on a single counter; the tables are summed into local at the
+// end.
+static void RADIX_FN(count_range)(const RADIX_KEY* src,
+                                  size_t start,
+                                  size_t end,
+                                  int shift,
+                                  RADIX_KEY mask,
+                                  uint32_t* local,
+                                  uint32_t* sub) {
+  const size_t buckets = (size_t)mask + 1;
+  if (buckets > 256 && end - start < LS_HIST_INTERLEAVE_MIN * buckets) {
+    for (size_t i = start; i < end; i++)
+      local[(uint32_t)((src[i] >> shift) & mask)]++;
+    return;
+  }
+  memset(sub, 0, (LS_HIST_TABLES - 1) * buckets * sizeof(uint32_t));
+  size_t i = start;
+  for (; i + LS_HIST_TABLES <= end; i += LS_HIST_TABLES) {
+    local[(uint32_t)((src[i] >> shift) & mask)]++;
+    for (int j = 1; j < LS_HIST_TABLES; j++) {
+      uint32_t d = (uint32_t)((src[i + j] >> shift) & mask);
+      sub[(size_t)(j - 1) * buckets + d]++;
+    }
+  }
+  for (; i < end; i++)
+    local[(uint32_t)((src[i] >> shift) & mask)]++;
+  for (int j = 1; j < LS_HIST_TABLES; j++) {
+    const uint32_t* t = sub + (size_t)(j - 1) * buckets;
+    for (size_t b = 0; b < buckets; b++)
+      local[b] += t[b];
+  }
+}
+
+static void RADIX_FN(scatter_range)(const RADIX_KEY* src,
+                                    RADIX_KEY* dst,
+                                    const uint32_t* isrc,
+                                    uint32_t* idst,
+                                    size_t start,
+                                    size_t end,
+                                    int shift,
+                                    RADIX_KEY mask,
+                                    uint32_t* off) {
+  if (isrc) {
+    for (size_t i = start; i < end; i++) {
+      RADIX_KEY x = src[i];
+      uint32_t o = off[(uint32_t)((x >> shift) & mask)]++;
+      dst[o] = x;
+      idst[o] = isrc[i];
+    }
+  } else {
+    for (size_t i = start; i < end; i++) {
+      RADIX_KEY x = src[i];
+      dst[off[(uint32_t)((x >> shift) & mask)]++] = x;
+    }
+  }
+}
+
+// One digit pass: counts digit (key >> shift) & (2^bits - 1) per thread
+// slice, scans the counts into per-thread offsets and scatters src (and isrc
+// when set) into dst. Returns 0, leaving dst untouched, when every key has
+// the same digit and the pass would move nothing, else the size of the team
+// that ran it. Count tables come from the context arenas, which the caller
+// has sized for `threads`; the work is sliced by the team actually started,
+// which may be smaller. Afterwards offset row (team - 1) holds the end of
+// every bucket.
+static int RADIX_FN(ls_pass)(sort_ctx* ctx,
+                             const RADIX_KEY* src,
+                             RADIX_KEY* dst,
+                             const uint32_t* isrc,
+                             uint32_t* idst,
+                             size_t n,
+                             int shift,
+                             int bits,
+                             int threads) {
+  uint32_t* all_counts = (uint32_t*)ctx->counts;
+  uint32_t* all_offsets = (uint32_t*)ctx->offsets;
+  const uint32_t buckets = 1u << bits;
+  const RADIX_KEY mask = (RADIX_KEY)(buckets - 1u);
+  uint32_t* range_sum = all_offsets + (size_t)threads * buckets;
+  int trivial = 0, ran = 1;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads) if (threads > 1)
+#endif
+  {
+    const int tid = ls_tid();
+    const int team = ls_team();
+    size_t start = (n * (size_t)tid) / (size_t)team;
+    size_t end = (n * (size_t)(tid + 1)) / (size_t)team;
+    uint32_t* local = all_counts + (size_t)tid * buckets;
+    memset(local, 0, buckets * sizeof(uint32_t));
+    RADIX_FN(count_range)(
+        src, start, end, shift, mask, local,
+        all_counts +
+            ((size_t)team + (size_t)tid * (LS_HIST_TABLES - 1)) * buckets);
+    if (tid == 0)
+      ran = team;
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+
+    // Bucket totals of this thread's range go into offsets row 0.
+    size_t b0 = ((size_t)buckets * (size_t)tid) / (size_t)team;
+    size_t b1 = ((size_t)buckets * (size_t)(tid + 1)) / (size_t)team;
+    uint32_t* row0 = all_offsets;
+    memcpy(row0 + b0, all_counts + b0, (b1 - b0) * sizeof(uint32_t));
+    for (int t = 1; t < team; t++) {
+      const uint32_t* c = all_counts + (size_t)t * buckets;
+      for (size_t b = b0; b < b1; b++)
+        row0[b] += c[b];
+    }
+    uint32_t sum = 0;
+    int single = 0;
+    for (size_t b = b0; b < b1; b++) {
+      single |= (size_t)row0[b] == n;
+      sum += row0[b];
+    }
+    range_sum[tid] = sum;
+    if (single) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      trivial = 1;
+    }
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+
+    if (!trivial) {
+      // Row 0 becomes the bucket starts, row t adds rows 0..t-1 counts.
+      uint32_t pos = 0;
+      for (int t = 0; t < tid; t++)
+        pos += range_sum[t];
+      for (size_t b = b0; b < b1; b++) {
+        uint32_t c = row0[b];
+        row0[b] = pos;
+        pos += c;
+      }
+      for (int t = 1; t < team; t++) {
+        uint32_t* o = all_offsets + (size_t)t * buckets;
+        const uint32_t* prev = o - buckets;
+        const uint32_t* c = all_counts + (size_t)(t - 1) * buckets;
+        for (size_t b = b0; b < b1; b++)
+          o[b] = prev[b] + c[b];
+      }
+    }
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+
+    if (!trivial)
+      RADIX_FN(scatter_range)(src, dst, isrc, idst, start, end, shift, mask,
+                              all_offsets + (size_t)tid * buckets);
+  }
+  return trivial ? 0 : ran;
+}
+
+// Runs digit passes of `bits` bits from the least significant digit until
+// the key is covered, ping-ponging between src and dst (and *pidx / idx_tmp
+// when pidx is set). A pass whose digit is the same for every key moves
+// nothing and is skipped after counting, which drops the high passes of
+// narrow-range data. Returns the buffer holding the sorted keys; *pidx is
+// updated to the matching index buffer.
+static RADIX_KEY* RADIX_FN(ls_lsd)(sort_ctx* ctx,
+                                   RADIX_KEY* src,
+                                   RADIX_KEY* dst,
+                                   uint32_t** pidx,
+                                   uint32_t* idx_tmp,
+                                   size_t n,
+                                   int bits,
+                                   int threads) {
+  uint32_t* isrc = pidx ? *pidx : NULL;
+  uint32_t* idst = idx_tmp;
+  const int passes = (int)((sizeof(RADIX_KEY) * 8 + (size_t)bits - 1) /
+                           (size_t)bits);
+  const uint64_t pass_bytes =
+      3 * n * sizeof(RADIX_KEY) + (isrc ? 2 * n * sizeof(uint32_t) : 0);
+  (void)pass_bytes;
+
+  for (int pass = 0; pass < passes; pass++) {
+    LS_PHASE_BEGIN(ctx);
+    if (!RADIX_FN(ls_pass)(ctx, src, dst, isrc, idst, n, pass * bits, bits,
+                           threads)) {
+      LS_PHASE_END(ctx, "radix_pass_skipped", pass, n * sizeof(RADIX_KEY));
+      continue;
+    }
+
+    RADIX_KEY* tmp = src;
+    src = dst;
+    dst = tmp;
+    if (isrc) {
+      uint32_t* itmp = isrc;
+      isrc = idst;
+      idst = itmp;
+    }
+    LS_PHASE_END(ctx, "radix_pass", pass, pass_bytes);
+  }
+
+  if (pidx)
+    *pidx = isrc;
+  return src;
+}
+
+// ===================== presorted input =====================
+// Writes the start of every ascending run of k[0..n) to starts (starts[0] is
+// 0) and returns the run count. The caller has counted the descents, so it
+// knows there are at most max_runs runs; each thread records the descents
+// of its own slice.
+static int RADIX_FN(ls_run_starts)(const RADIX_KEY* k,
+                                size_t n,
+                                size_t* starts,
+                                int max_runs,
+                                int threads) {
+  size_t found[LS_MAX_MERGE_RUNS * 64];
+  int count[64];
+  int ran = 1;
+  if (threads > 64)
+    threads = 64;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads) if (threads > 1)
+#endif
+  {
+    const int tid = ls_tid();
+    const int team = ls_team();
+    size_t start = (n * (size_t)tid) / (size_t)team;
+    size_t end = (n * (size_t)(tid + 1)) / (size_t)team;
+    if (tid == 0)
+      ran = team;
+    size_t* mine = found + (size_t)tid * LS_MAX_MERGE_RUNS;
+    int c = 0;
+    for (size_t i = start > 0 ? start : 1; i < end; i++)
+      if (k[i] < k[i - 1] && c < LS_MAX_MERGE_RUNS)
+        mine[c++] = i;
+    count[tid] = c;
+  }
+  int runs = 1;
+  starts[0] = 0;
+  for (int t = 0; t < ran; t++)
+    for (int c = 0; c < count[t] && runs < max_runs; c++)
+      starts[runs++] = found[(size_t)t * LS_MAX_MERGE_RUNS + (size_t)c];
+  return runs;
+}
+
+// Reverses a[0..n) in place; elements are handled as raw key-sized words.
+static void RADIX_FN(ls_reverse)(RADIX_KEY* a, size_t n, int threads) {
+  size_t half = n / 2;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) if (threads > 1) \
+    schedule(static)
+#endif
+  for (size_t i = 0; i < half; i++) {
+    RADIX_KEY t = a[i];
+    a[i] = a[n - 1 - i];
+    a[n - 1 - i] = t;
+  }
+  (void)threads;
+}
+
+// ===================== introsort =====================
+static void RADIX_FN(insertion)(RADIX_KEY* a, size_t n) {
+  for (size_t i = 1; i < n; i++) {
+    RADIX_KEY x = a[i];
+    size_t j = i;
+    for (; j > 0 && a[j - 1] > x; j--)
+      a[j] = a[j - 1];
+    a[j] = x;
+  }
+}
+
+static void RADIX_FN(sift_down)(RADIX_KEY* a, size_t root, size_t n) {
+  RADIX_KEY x = a[root];
+  for (size_t child; (child = 2 * root + 1) < n; root = child) {
+    if (child + 1 < n && a[child + 1] > a[child])
+      child++;
+    if (a[child] <= x)
+      break;
+    a[root] = a[child];
+  }
+  a[root] = x;
+}
+
+static void RADIX_FN(heapsort)(RADIX_KEY* a, size_t n) {
+  for (size_t i = n / 2; i-- > 0;)
+    RADIX_FN(sift_down)(a, i, n);
+  for (size_t end = n; end-- > 1;) {
+    RADIX_KEY t = a[0];
+    a[0] = a[end];
+    a[end] = t;
+    RADIX_FN(sift_down)(a, 0, end);
+  }
+}
+
+static void RADIX_FN(introsort_rec)(RADIX_KEY* a, size_t n, int depth) {
+  while (n > 24) {
+    if (depth-- == 0) {
+      RADIX_FN(heapsort)(a, n);
+      return;
+    }
+    // median of three as pivot, Hoare partition
+    RADIX_KEY x = a[0], y = a[n / 2], z = a[n - 1];
+    RADIX_KEY pivot = x < y ? (y < z ? y : (x < z ? z : x))
+                            : (x < z ? x : (y < z ? z : y));
+    size_t i = (size_t)-1, j = n;
+    for (;;) {
+      do
+        i++;
+      while (a[i] < pivot);
+      do
+        j--;
+      while (a[j] > pivot);
+      if (i >= j)
+        break;
+      RADIX_KEY t = a[i];
+      a[i] = a[j];
+      a[j] = t;
+    }
+    // recurse into the smaller side, loop on the larger
+    size_t left = j + 1;
+    if (left < n - left) {
+      RADIX_FN(introsort_rec)(a, left, depth);
+      a += left;
+      n -= left;
+    } else {
+      RADIX_FN(introsort_rec)(a + left, n - left, depth);
+      n = left;
+    }
+  }
+  RADIX_FN(insertion)(a, n);
+}
+
+static void RADIX_FN(ls_introsort)(RADIX_KEY* a, size_t n) {
+  int depth = 0;
+  for (size_t m = n; m > 1; m >>= 1)
+    depth += 2;
+  RADIX_FN(introsort_rec)(a, n, depth);
+}
@@ -0,0 +1,56 @@
+// Segmented sort: many independent segments of one flat buffer.
+//
+// Per-call setup (count tables, arena checks, the presortedness scan) is
+// what sinks sort_* on arrays of a few dozen elements, so segments are
+// bucketed by length instead. Short ones are insertion-sorted on a key copy
+// in L1, medium ones get a single-threaded 8-bit LSD that needs 1-2 KB of
+// count tables, and long ones go through sort_* with the whole team. Short
+// and medium segments are load-balanced over the team dynamically.
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sort_internal.h"
+
+#define SEG_T int32_t
+#define SEG_KEY uint32_t
+#define SEG_TO_KEY(v) ls_key_i32(v)
+#define SEG_FROM_KEY(k) ls_from_key_i32(k)
+#define SEG_SORT sort_i32
+#define SEG_FN(x) x##_i32
+#include "segment_impl.h"
+#undef SEG_T
+#undef SEG_KEY
+#undef SEG_TO_KEY
+#undef SEG_FROM_KEY
+#undef SEG_SORT
+#undef SEG_FN
+
+#define SEG_T float
+#define SEG_KEY uint32_t
+#define SEG_TO_KEY(v) ls_key_f32(v)
+#define SEG_FROM_KEY(k) ls_from_key_f32(k)
+#define SEG_SORT sort_f32
+#define SEG_FN(x) x##_f32
+#include "segment_impl.h"
+#undef SEG_T
+#undef SEG_KEY
+#undef SEG_TO_KEY
+#undef SEG_FROM_KEY
+#undef SEG_SORT
+#undef SEG_FN
+
+#define SEG_T double
+#define SEG_KEY uint64_t
+#define SEG_TO_KEY(v) ls_key_f64(v)
+#define SEG_FROM_KEY(k) ls_from_key_f64(k)
+#define SEG_SORT sort_f64
+#define SEG_FN(x) x##_f64
+#include "segment_impl.h"
+#undef SEG_T
+#undef SEG_KEY
+#undef SEG_TO_KEY
+#undef SEG_FROM_KEY
+#undef SEG_SORT
+#undef SEG_FN
@@ -0,0 +1,124 @@
+// Segmented sort bodies, included by segment.c once per element type with:
+//   SEG_T            element type
+//   SEG_KEY          unsigned key type (uint32_t / uint64_t)
+//   SEG_TO_KEY(v)    order-preserving key of an element (ls_key_*)
+//   SEG_FROM_KEY(k)  element of a key (ls_from_key_*)
+//   SEG_SORT         whole-array sort for long segments (sort_*)
+//   SEG_FN(x)        name mangler
+
+// Insertion sort through a key copy; n <= LS_SEG_SHORT.
+static void SEG_FN(short)(SEG_T* a, size_t n) {
+  SEG_KEY k[LS_SEG_SHORT];
+  for (size_t i = 0; i < n; i++) {
+    SEG_KEY x = (SEG_KEY)SEG_TO_KEY(a[i]);
+    size_t j = i;
+    for (; j > 0 && k[j - 1] > x; j--)
+      k[j] = k[j - 1];
+    k[j] = x;
+  }
+  for (size_t i = 0; i < n; i++)
+    a[i] = SEG_FROM_KEY(k[i]);
+}
+
+// Single-threaded LSD with 8-bit digits: the counts of every pass come from
+// one read of the keys, and passes with a single digit value are skipped.
+// tmp holds n keys.
+static void SEG_FN(medium)(SEG_T* a, SEG_KEY* tmp, size_t n) {
+  enum { kPasses = (int)sizeof(SEG_KEY) };
+  uint32_t count[kPasses][256];
+  memset(count, 0, sizeof(count));
+  SEG_KEY* k = (SEG_KEY*)(void*)a;
+  for (size_t i = 0; i < n; i++) {
+    SEG_KEY x = (SEG_KEY)SEG_TO_KEY(a[i]);
+    k[i] = x;
+    for (int p = 0; p < kPasses; p++)
+      count[p][(uint32_t)(x >> (8 * p)) & 255u]++;
+  }
+
+  SEG_KEY* src = k;
+  SEG_KEY* dst = tmp;
+  for (int p = 0; p < kPasses; p++) {
+    uint32_t* c = count[p];
+    if (c[(uint32_t)(src[0] >> (8 * p)) & 255u] == n)
+      continue;
+    uint32_t pos = 0;
+    for (int d = 0; d < 256; d++) {
+      uint32_t v = c[d];
+      c[d] = pos;
+      pos += v;
+    }
+    for (size_t i = 0; i < n; i++) {
+      SEG_KEY x = src[i];
+      dst[c[(uint32_t)(x >> (8 * p)) & 255u]++] = x;
+    }
+    SEG_KEY* t = src;
+    src = dst;
+    dst = t;
+  }
+  for (size_t i = 0; i < n; i++)
+    a[i] = SEG_FROM_KEY(src[i]);
+}
+
+int SEG_FN(sort_segments)(sort_ctx* ctx,
+                          SEG_T* a,
+                          const size_t* offsets,
+                          size_t segments) {
+  if (!ctx || (segments && (!a || !offsets)))
+    return SORT_EINVAL;
+  size_t small_total = 0, mid_max = 0;
+  for (size_t s = 0; s < segments; s++) {
+    if (offsets[s + 1] < offsets[s])
+      return SORT_EINVAL;
+    size_t len = offsets[s + 1] - offsets[s];
+    if (len < LS_SEG_LONG) {
+      small_total += len;
+      if (len > LS_SEG_SHORT && len > mid_max)
+        mid_max = len;
+    }
+  }
+
+  // Short and medium segments: dynamic schedule over the team, one
+  // medium-sized scratch slice per thread from the key arena.
+  int threads = ls_threads(ctx, small_total);
+  if (mid_max) {
+    int rc = ls_reserve(ctx, (size_t)threads * mid_max, sizeof(SEG_KEY), 0,
+                        threads);
+    if (rc != SORT_OK)
+      return rc;
+  }
+  SEG_KEY* scratch = (SEG_KEY*)ctx->keys[1];
+  long long count = (long long)segments;
+  LS_PHASE_BEGIN(ctx);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) if (threads > 1) \
+    schedule(dynamic, 64)
+#endif
+  for (long long s = 0; s < count; s++) {
+    size_t len = offsets[s + 1] - offsets[s];
+    SEG_T* seg = a + offsets[s];
+    if (len <= 1 || len >= LS_SEG_LONG)
+      continue;
+    if (len <= LS_SEG_SHORT) {
+      SEG_FN(short)(seg, len);
+    } else {
+#ifdef _OPENMP
+      size_t tid = (size_t)omp_get_thread_num();
+#else
+      size_t tid = 0;
+#endif
+      SEG_FN(medium)(seg, scratch + tid * mid_max, len);
+    }
+  }
+  LS_PHASE_END(ctx, "segments", -1, 3 * small_total * sizeof(SEG_T));
+
+  // Long segments: one at a time, each with the full engine.
+  for (size_t s = 0; s < segments; s++) {
+    size_t len = offsets[s + 1] - offsets[s];
+    if (len >= LS_SEG_LONG) {
+      int rc = SEG_SORT(ctx, a + offsets[s], len);
+      if (rc != SORT_OK)
+        return rc;
+    }
+  }
+  return SORT_OK;
+}
@@ -0,0 +1,250 @@
+// libsort - reusable radix sort kernels with caller-owned context.
+//
+// A sort_ctx owns the scratch arenas (key ping-pong buffers, index buffers,
+// per-thread digit count/offset tables), the thread-team size and the tuning
+// parameters. Arenas only grow, so a context reused across calls of similar
+// size allocates and page-faults once. A context must not be used by two
+// threads at the same time; use one context per calling thread.
+//
+// All entry points return SORT_OK or a negative SORT_E* code and never exit.
+// Element counts are limited to UINT32_MAX (digit counts are 32-bit).
+
+#ifndef LIBSORT_SORT_H
+#define LIBSORT_SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum { SORT_OK = 0, SORT_ENOMEM = -1, SORT_EINVAL = -2 };
+
+// Page backing for scratch arenas and sort_alloc() buffers of 2 MB or more.
+enum {
+  SORT_PAGES_DEFAULT = 0,  // system THP policy
+  SORT_PAGES_SMALL = 1,    // 4 KB pages only (MADV_NOHUGEPAGE)
+  SORT_PAGES_THP = 2,      // transparent huge pages (MADV_HUGEPAGE)
+  SORT_PAGES_HUGETLB = 3,  // explicit hugetlbfs pages, THP if none reserved
+};
+
+typedef struct sort_ctx sort_ctx;
+
+// Element types for the entry points that take one as a parameter.
+enum { SORT_TYPE_I32 = 0, SORT_TYPE_F32 = 1, SORT_TYPE_F64 = 2 };
+
+enum {
+  SORT_ENGINE_AUTO = 0,
+  SORT_ENGINE_LSD = 1,        // parallel LSD radix
+  SORT_ENGINE_INTROSORT = 2,  // in-place comparison sort for small inputs
+  SORT_ENGINE_HYBRID = 3,     // MSD pass, then cache-resident LSD per bucket
+                              // (sort_f64; 32-bit keys use LSD)
+};
+
+// Fields left at 0 are chosen per call from the loaded profile (see
+// sort_ctx_load_profile) or, without one, from built-in rules: introsort
+// below 1K elements, 8-bit digits below 128K and 16-bit digits above, and
+// a team size derived from n and
+// omp_get_max_threads() (which follows OMP_NUM_THREADS and the affinity
+// mask), so small inputs run sequentially without entering OpenMP.
+typedef struct {
+  int threads;            // worker threads, 0 = chosen per call
+  size_t parallel_min_n;  // below this size run on one thread (unless the
+                          // profile says otherwise)
+  int pages;              // SORT_PAGES_* for arenas allocated from now on
+  int prefault;           // fault arenas in when they are (re)allocated
+  int engine;             // SORT_ENGINE_*; argsort always uses LSD
+  int digit_bits;         // LSD digit width 8..16, 0 = chosen per call
+  int no_presort_check;   // sort_*: skip the sorted / reversed / few-runs
+                          // detection fused into the key transform
+} sort_tuning;
+
+// Optional per-phase callbacks (key transform, each radix pass, untransform),
+// e.g. to feed instrument.h. Not called when built with NO_TIMING.
+typedef struct {
+  void* user;
+  void (*phase_begin)(void* user);
+  void (*phase_end)(void* user, const char* name, int index, uint64_t bytes);
+} sort_hooks;
+
+void sort_tuning_default(sort_tuning* t);
+
+sort_ctx* sort_ctx_create(const sort_tuning* tuning);  // NULL = defaults
+void sort_ctx_destroy(sort_ctx* ctx);
+void sort_ctx_set_tuning(sort_ctx* ctx, const sort_tuning* tuning);
+void sort_ctx_get_tuning(const sort_ctx* ctx, sort_tuning* tuning);
+void sort_ctx_set_hooks(sort_ctx* ctx, const sort_hooks* hooks);
+
+// Pre-sizes the arenas for n elements of key_size bytes (4 or 8): one key
+// buffer for sort_*, two plus the index buffer when with_index is set.
+// Optional; sorts grow the arenas on demand.
+// With tuning.prefault this also moves the first-touch page faults here,
+// out of the sort calls.
+int sort_ctx_reserve(sort_ctx* ctx, size_t n, size_t key_size, int with_index);
+
+// Frees all scratch memory but keeps tuning and hooks.
+void sort_ctx_release(sort_ctx* ctx);
+
+// In-place ascending sorts. Floats use the IEEE total order
+// (-NaN < -inf < ... < -0 < +0 < ... < +inf < +NaN). Keys are transformed
+// in place in `a`, so the only scratch is one array of n keys. Already
+// sorted input costs the transform and its inverse, reversed input an
+// in-place reversal on top, and input made of a few ascending runs (up to 4
+// for 32-bit types, 16 for 64-bit ones) a k-way merge instead of the radix
+// passes. sort_i64 (e.g. for fixed-point decimals scaled to integers) uses
+// the profile entries and engines of sort_f64.
+int sort_i32(sort_ctx* ctx, int32_t* a, size_t n);
+int sort_f32(sort_ctx* ctx, float* a, size_t n);
+int sort_f64(sort_ctx* ctx, double* a, size_t n);
+int sort_i64(sort_ctx* ctx, int64_t* a, size_t n);
+
+// Segmented sort: sorts each a[offsets[s] .. offsets[s + 1]) for
+// s < segments independently and in place (offsets has segments + 1
+// non-decreasing entries). Meant for many small arrays in one buffer:
+// segments of up to 32 elements are insertion-sorted, those below 64K get a
+// single-threaded 8-bit LSD, and both are spread over the context's
+// threads; longer segments are sorted one after another like sort_*.
+int sort_segments_i32(sort_ctx* ctx, int32_t* a, const size_t* offsets,
+                      size_t segments);
+int sort_segments_f32(sort_ctx* ctx, float* a, const size_t* offsets,
+                      size_t segments);
+int sort_segments_f64(sort_ctx* ctx, double* a, const size_t* offsets,
+                      size_t segments);
+
+// A string reference for sort_strings: bytes [ptr, ptr + len).
+typedef struct {
+  const char* ptr;
+  size_t len;
+} sort_str;
+
+// Sorts n string references in place by unsigned bytes (memcmp order, a
+// proper prefix first), the order of `LC_ALL=C sort`. Only the references
+// move; the strings are read, never copied. Large inputs are split by a
+// parallel MSD radix pass after their common prefix and the buckets sorted
+// across the context's threads by multikey quicksort on cached 8-byte
+// prefixes. Scratch comes from the context's arenas: 24 bytes per string,
+// and the count tables of sort_* for inputs of 64K strings and more.
+int sort_strings(sort_ctx* ctx, sort_str* s, size_t n);
+
+// Stable argsort: idx[i] receives the position in `a` of the i-th smallest
+// element. `a` is not modified.
+int argsort_i32(sort_ctx* ctx, const int32_t* a, size_t n, uint32_t* idx);
+int argsort_f32(sort_ctx* ctx, const float* a, size_t n, uint32_t* idx);
+int argsort_f64(sort_ctx* ctx, const double* a, size_t n, uint32_t* idx);
+
+// Stable argsort on keys that are already unsigned-ordered (callers apply
+// their own transform, e.g. to pack several columns into one key). On entry
+// idx[] holds an order of 0..n-1, which is re-sorted by keys[idx[i]] with
+// ties keeping their incoming order. Starting from the identity and calling
+// once per key word, least significant word first, sorts by a composite key
+// wider than 64 bits.
+int argsort_refine_u32(sort_ctx* ctx, const uint32_t* keys, size_t n,
+                       uint32_t* idx);
+int argsort_refine_u64(sort_ctx* ctx, const uint64_t* keys, size_t n,
+                       uint32_t* idx);
+
+// k-way merge of sorted runs (ascending, same order as sort_*) into `out`,
+// which must hold the sum of lens[] and not overlap the runs. Uses a loser
+// tree, so each element costs about log2(k) compares; large merges are
+// split into key ranges across the context's threads. Stable: equal
+// elements keep run order.
+int merge_i32(sort_ctx* ctx, const int32_t* const* runs, const size_t* lens,
+              int k, int32_t* out);
+int merge_f32(sort_ctx* ctx, const float* const* runs, const size_t* lens,
+              int k, float* out);
+int merge_f64(sort_ctx* ctx, const double* const* runs, const size_t* lens,
+              int k, double* out);
+
+// Compressed sorted columns. A sorted array is stored as blocks of
+// SORT_COL_BLOCK values: each block holds its first order-preserving key
+// (the ls_key_* transform, so floats and ints alike) and the deltas between
+// neighbouring keys bit-packed at the width of the largest, in interleaved
+// lanes that unpack with whole vector shifts. An index of block offsets
+// gives random access. The buffer is native-endian and position-free, so
+// it can be written to a file and mapped back as is.
+#define SORT_COL_BLOCK 1024
+enum {
+  SORT_COL_I32 = SORT_TYPE_I32,
+  SORT_COL_F32 = SORT_TYPE_F32,
+  SORT_COL_F64 = SORT_TYPE_F64,
+};
+
+// Upper bound of the encoded size of n values of `type`.
+size_t sort_col_bound(int type, size_t n);
+
+// Encodes ascending a[0..n) (in sort_* order) into `out`, which must hold
+// sort_col_bound() bytes; *bytes receives the size used. SORT_EINVAL if
+// `a` is not ascending.
+int sort_col_encode(sort_ctx* ctx, int type, const void* a, size_t n,
+                    void* out, size_t* bytes);
+
+// An encoded column opened for reading; `base` is borrowed, not copied.
+typedef struct {
+  const unsigned char* base;
+  size_t bytes;
+  int type;  // SORT_COL_*
+  size_t n;
+  size_t blocks;
+} sort_col;
+
+// Checks the header and block index of buf[0..bytes) and fills `c`.
+int sort_col_open(sort_col* c, const void* buf, size_t bytes);
+
+// Decodes values [first, first + count) into `out` (int32_t, float or
+// double per c->type). Only the blocks overlapping the range are read;
+// they are spread over the context's threads.
+int sort_col_decode(sort_ctx* ctx, const sort_col* c, size_t first,
+                    size_t count, void* out);
+
+// Concurrent ingestion for data produced by many threads. Each producer
+// appends to its own blocks, padded apart and without locks, and counts
+// the radix digits of its values as it appends. sort_ingest_finish() sorts
+// everything ingested into `out`, which must hold sort_ingest_count()
+// elements: the first pass scatters straight from the producers' blocks,
+// one range of them per thread, so the values are never gathered into one
+// array first, and passes that would not move anything are skipped from
+// the producers' counts. Producer ids are 0..producers-1, and one id must
+// not be used by two threads at a time. finish and count must not overlap
+// appends. finish empties the ingest for reuse; it uses the context like a
+// sort call.
+typedef struct sort_ingest sort_ingest;
+sort_ingest* sort_ingest_create(sort_ctx* ctx, int type, int producers);
+int sort_ingest_append(sort_ingest* g, int producer, const void* values,
+                       size_t n);
+size_t sort_ingest_count(const sort_ingest* g);
+int sort_ingest_finish(sort_ingest* g, void* out);
+void sort_ingest_destroy(sort_ingest* g);
+
+// Buffers with the same page policy as the arenas, e.g. for the array being
+// sorted. Mappings are 2 MB aligned and rounded; `populate` faults them in
+// up front. sort_free() takes the size passed to sort_alloc().
+void* sort_alloc(size_t bytes, int pages, int populate);
+void sort_free(void* p, size_t bytes);
+size_t sort_alloc_size(size_t bytes);  // bytes actually mapped
+int sort_pages_parse(const char* s);   // "default" | "small" | "thp" |
+                                       // "hugetlb", -1 if unknown
+
+// Kernel variant chosen by CPUID dispatch: "avx512", "avx2" or "scalar".
+const char* sort_isa(void);
+
+// CPUs this process may use: the affinity mask, further limited by a cgroup
+// CPU quota (cpu.max / cpu.cfs_quota_us) rounded up.
+int sort_available_cpus(void);
+
+// Tuning profiles map (type, n) to engine, thread count and digit width.
+// sort_calibrate() times every candidate on uniform random data for each
+// type and for n = 1e3, 1e4, ... up to max_n on this host, and writes the
+// fastest per (type, n) to `path` (progress lines go to `log` if non-NULL).
+// A loaded profile answers calls by the calibrated size nearest in log
+// scale; thread counts are capped at sort_available_cpus() at load time.
+// Explicit (non-zero) tuning fields still take precedence.
+int sort_calibrate(const char* path, size_t max_n, FILE* log);
+int sort_ctx_load_profile(sort_ctx* ctx, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // LIBSORT_SORT_H
@@ -0,0 +1,181 @@
+// sort_ctx lifecycle and scratch arenas.
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sort_internal.h"
+
+void sort_tuning_default(sort_tuning* t) {
+  t->threads = 0;
+  t->parallel_min_n = 2 * LS_MIN_PER_THREAD;
+  t->pages = SORT_PAGES_DEFAULT;
+  t->prefault = 0;
+  t->engine = SORT_ENGINE_AUTO;
+  t->digit_bits = 0;
+  t->no_presort_check = 0;
+}
+
+sort_ctx* sort_ctx_create(const sort_tuning* tuning) {
+  sort_ctx* ctx = (sort_ctx*)calloc(1, sizeof(sort_ctx));
+  if (!ctx)
+    return NULL;
+  if (tuning)
+    ctx->tuning = *tuning;
+  else
+    sort_tuning_default(&ctx->tuning);
+  return ctx;
+}
+
+void sort_ctx_release(sort_ctx* ctx) {
+  if (!ctx)
+    return;
+  for (int b = 0; b < 2; b++) {
+    sort_free(ctx->keys[b], ctx->keys_cap[b]);
+    ctx->keys[b] = NULL;
+    ctx->keys_cap[b] = 0;
+  }
+  sort_free(ctx->idx, ctx->idx_cap);
+  ctx->idx = NULL;
+  ctx->idx_cap = 0;
+  sort_free(ctx->counts, ctx->counts_cap);
+  sort_free(ctx->offsets, ctx->offsets_cap);
+  ctx->counts = ctx->offsets = NULL;
+  ctx->counts_cap = ctx->offsets_cap = 0;
+}
+
+void sort_ctx_destroy(sort_ctx* ctx) {
+  sort_ctx_release(ctx);
+  free(ctx);
+}
+
+void sort_ctx_set_tuning(sort_ctx* ctx, const sort_tuning* tuning) {
+  ctx->tuning = *tuning;
+}
+
+void sort_ctx_get_tuning(const sort_ctx* ctx, sort_tuning* tuning) {
+  *tuning = ctx->tuning;
+}
+
+void sort_ctx_set_hooks(sort_ctx* ctx, const sort_hooks* hooks) {
+  if (hooks)
+    ctx->hooks = *hooks;
+  else
+    memset(&ctx->hooks, 0, sizeof(ctx->hooks));
+}
+
+void* ls_arena(const sort_ctx* ctx, void** p, size_t* cap, size_t bytes) {
+  if (*p && *cap >= bytes)
+    return *p;
+  sort_free(*p, *cap);
+  *p = sort_alloc(bytes, ctx->tuning.pages, ctx->tuning.prefault);
+  *cap = *p ? sort_alloc_size(bytes ? bytes : 1) : 0;
+  return *p;
+}
+
+int ls_threads(const sort_ctx* ctx, size_t n) {
+  if (n < ctx->tuning.parallel_min_n)
+    return 1;
+#ifdef _OPENMP
+  if (ctx->tuning.threads > 0)
+    return ctx->tuning.threads;
+  size_t threads = (size_t)omp_get_max_threads();
+  if (threads > n / LS_MIN_PER_THREAD)
+    threads = n / LS_MIN_PER_THREAD;
+  return threads < 1 ? 1 : (int)threads;
+#else
+  return 1;
+#endif
+}
+
+// Profile entry of `type` whose size is nearest to n in log scale
+// (n is nearer to hi than to lo exactly when n * n > lo * hi).
+static const ls_profile_entry* profile_lookup(const sort_ctx* ctx, int type,
+                                              size_t n) {
+  const ls_profile_entry* best = NULL;
+  for (int i = 0; i < ctx->n_profile; i++) {
+    const ls_profile_entry* e = &ctx->profile[i];
+    if (e->type != type)
+      continue;
+    if (!best) {
+      best = e;
+      continue;
+    }
+    double lo = (double)(best->n < e->n ? best->n : e->n);
+    double hi = (double)(best->n < e->n ? e->n : best->n);
+    int closer_to_hi = (double)n * (double)n > lo * hi;
+    if (closer_to_hi == (e->n > best->n))
+      best = e;
+  }
+  return best;
+}
+
+void ls_plan_for(const sort_ctx* ctx, int type, size_t n, int stable,
+                 ls_plan* plan) {
+  const sort_tuning* t = &ctx->tuning;
+  const ls_profile_entry* e = profile_lookup(ctx, type, n);
+
+  if (e) {
+    plan->engine = e->engine;
+    plan->threads = e->threads;
+    plan->digit_bits = e->digit_bits;
+  } else {
+    plan->engine =
+        n < LS_INTROSORT_MAX_N ? SORT_ENGINE_INTROSORT : SORT_ENGINE_LSD;
+    plan->threads = ls_threads(ctx, n);
+    plan->digit_bits =
+        n < LS_NARROW_DIGITS_MAX_N ? LS_MIN_DIGIT_BITS : LS_DIGIT_BITS;
+  }
+
+  if (t->engine != SORT_ENGINE_AUTO)
+    plan->engine = t->engine;
+  if (t->threads > 0)
+    plan->threads = n < t->parallel_min_n ? 1 : t->threads;
+  if (t->digit_bits > 0)
+    plan->digit_bits = t->digit_bits;
+  if (stable)
+    plan->engine = SORT_ENGINE_LSD;
+
+#ifndef _OPENMP
+  plan->threads = 1;
+#endif
+  if (plan->threads < 1)
+    plan->threads = 1;
+  if (plan->digit_bits < LS_MIN_DIGIT_BITS)
+    plan->digit_bits = LS_MIN_DIGIT_BITS;
+  if (plan->digit_bits > LS_DIGIT_BITS)
+    plan->digit_bits = LS_DIGIT_BITS;
+}
+
+int ls_reserve(sort_ctx* ctx,
+               size_t n,
+               size_t key_size,
+               int with_index,
+               int threads) {
+  if (n > UINT32_MAX)
+    return SORT_EINVAL;
+  size_t table = (size_t)threads * LS_BUCKETS * sizeof(uint32_t);
+  // sort_* transform the caller's array in place and need only keys[1];
+  // argsort keeps the input intact and ping-pongs between both.
+  for (int b = with_index ? 0 : 1; b < 2; b++)
+    if (!ls_arena(ctx, &ctx->keys[b], &ctx->keys_cap[b], n * key_size))
+      return SORT_ENOMEM;
+  if (with_index &&
+      !ls_arena(ctx, &ctx->idx, &ctx->idx_cap, n * sizeof(uint32_t)))
+    return SORT_ENOMEM;
+  // counts: one table per thread, then each thread's extra histogram tables;
+  // offsets: one table per thread, then one bucket-range total per thread
+  if (!ls_arena(ctx, &ctx->counts, &ctx->counts_cap, table * LS_HIST_TABLES) ||
+      !ls_arena(ctx, &ctx->offsets, &ctx->offsets_cap,
+                table + (size_t)threads * sizeof(uint32_t)))
+    return SORT_ENOMEM;
+  return SORT_OK;
+}
+
+int sort_ctx_reserve(sort_ctx* ctx, size_t n, size_t key_size, int with_index) {
+  ls_plan plan;
+  ls_plan_for(ctx, key_size == 8 ? LS_T_F64 : LS_T_I32, n, with_index, &plan);
+  return ls_reserve(ctx, n, key_size, with_index, plan.threads);
+}
@@ -0,0 +1,219 @@
+// Private declarations shared by the libsort translation units.
+
+#ifndef LIBSORT_SORT_INTERNAL_H
+#define LIBSORT_SORT_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sort.h"
+
+#define LS_DIGIT_BITS 16  // widest (and default) digit; tables are sized for it
+#define LS_BUCKETS (1u << LS_DIGIT_BITS)
+#define LS_MIN_DIGIT_BITS 8
+
+// Digit counting spreads consecutive keys over this many interleaved tables
+// (see count_range in radix_impl.h), for 8-bit digits or slices of at least
+// LS_HIST_INTERLEAVE_MIN keys per bucket; shorter slices of wide digits
+// spend more clearing and summing the extra tables than they save.
+#define LS_HIST_TABLES 4
+#define LS_HIST_INTERLEAVE_MIN 4
+
+// Defaults without a profile: introsort below LS_INTROSORT_MAX_N, 8-bit
+// digits below LS_NARROW_DIGITS_MAX_N (clearing and scanning 64K-entry
+// tables per pass dominates there), 16-bit digits above.
+#define LS_INTROSORT_MAX_N 1024
+#define LS_NARROW_DIGITS_MAX_N ((size_t)1 << 17)
+
+// Order-preserving unsigned keys of single elements; the same transforms
+// radix.c applies in bulk (floats by IEEE total order).
+static inline uint64_t ls_key_i32(int32_t v) {
+  return (uint32_t)v ^ 0x80000000u;
+}
+static inline uint64_t ls_key_f32(float v) {
+  uint32_t x;
+  memcpy(&x, &v, sizeof(x));
+  return x ^ ((uint32_t)((int32_t)x >> 31) | 0x80000000u);
+}
+static inline uint64_t ls_key_f64(double v) {
+  uint64_t x;
+  memcpy(&x, &v, sizeof(x));
+  return x ^ ((uint64_t)((int64_t)x >> 63) | 0x8000000000000000ull);
+}
+static inline uint64_t ls_key_i64(int64_t v) {
+  return (uint64_t)v ^ 0x8000000000000000ull;
+}
+
+// Inverses of the above.
+static inline int32_t ls_from_key_i32(uint32_t k) {
+  return (int32_t)(k ^ 0x80000000u);
+}
+static inline float ls_from_key_f32(uint32_t k) {
+  uint32_t x = k ^ ((uint32_t)((int32_t)~k >> 31) | 0x80000000u);
+  float v;
+  memcpy(&v, &x, sizeof(v));
+  return v;
+}
+static inline double ls_from_key_f64(uint64_t k) {
+  uint64_t x = k ^ ((uint64_t)((int64_t)~k >> 63) | 0x8000000000000000ull);
+  double v;
+  memcpy(&v, &x, sizeof(v));
+  return v;
+}
+static inline int64_t ls_from_key_i64(uint64_t k) {
+  return (int64_t)(k ^ 0x8000000000000000ull);
+}
+
+// sort_* count descents while transforming keys. Input with no descents is
+// left as is, input with no ascents is reversed in place, and input of a
+// few ascending runs (never more than LS_MAX_MERGE_RUNS; see ls_merge_pays)
+// is merged instead of radix-sorted.
+#define LS_MAX_MERGE_RUNS 16
+
+// Segmented sort buckets: insertion sort up to LS_SEG_SHORT elements, the
+// single-threaded 8-bit LSD below LS_SEG_LONG, sort_* from there on.
+#define LS_SEG_SHORT 32
+#define LS_SEG_LONG ((size_t)1 << 16)
+
+// Inputs below this many elements per thread do not gain from another
+// thread: the fork/join and per-thread count tables cost more than the
+// slice saves. Used for the default parallel_min_n and to cap the team.
+#define LS_MIN_PER_THREAD ((size_t)1 << 16)
+
+// Thread id and team size inside a parallel region. The team OpenMP starts
+// can be smaller than the num_threads asked for (a call from inside another
+// parallel region, OMP_DYNAMIC, OMP_THREAD_LIMIT), so regions that slice
+// work by hand slice it by ls_team(), never by the requested count; tables
+// sized for the request are then always large enough.
+#ifdef _OPENMP
+static inline int ls_tid(void) {
+  return omp_get_thread_num();
+}
+static inline int ls_team(void) {
+  return omp_get_num_threads();
+}
+#else
+static inline int ls_tid(void) {
+  return 0;
+}
+static inline int ls_team(void) {
+  return 1;
+}
+#endif
+
+// CPUID-dispatched kernel variants (see radix.c).
+#if defined(__x86_64__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define LS_HAVE_CLONES 1
+#define LS_DISPATCH \
+  __attribute__((target_clones("arch=x86-64-v4", "avx2", "default")))
+#endif
+#endif
+#ifndef LS_HAVE_CLONES
+#define LS_HAVE_CLONES 0
+#define LS_DISPATCH
+#endif
+
+enum { LS_T_I32, LS_T_F32, LS_T_F64, LS_T_COUNT };
+
+#define LS_MAX_PROFILE 64
+
+typedef struct {
+  int type;  // LS_T_*
+  size_t n;  // calibrated size
+  int engine;
+  int threads;
+  int digit_bits;
+} ls_profile_entry;
+
+// What one call runs with, after profile and tuning are applied.
+typedef struct {
+  int engine;
+  int threads;
+  int digit_bits;
+} ls_plan;
+
+struct sort_ctx {
+  sort_tuning tuning;
+  sort_hooks hooks;
+  ls_profile_entry profile[LS_MAX_PROFILE];
+  int n_profile;
+
+  // Scratch arenas; capacities are in bytes.
+  void* keys[2];  // key ping-pong buffers (sort_* use only keys[1],
+                  // sort_strings its cached-prefix references there)
+  size_t keys_cap[2];
+  void* idx;  // uint32 index payload scratch (argsort; sort_strings' stack
+              // of ranges to split)
+  size_t idx_cap;
+  void* counts;  // threads x buckets uint32 digit counts
+  size_t counts_cap;
+  void* offsets;  // threads x buckets uint32 scatter offsets
+  size_t offsets_cap;
+};
+
+// Grows *p to at least `bytes` with the context's page policy; contents are
+// not preserved. *cap is the mapped size.
+void* ls_arena(const sort_ctx* ctx, void** p, size_t* cap, size_t bytes);
+
+// Ensures the arenas hold n keys of key_size bytes (both key buffers and
+// the index scratch when with_index, else one key buffer) and count tables
+// for `threads`.
+int ls_reserve(sort_ctx* ctx,
+               size_t n,
+               size_t key_size,
+               int with_index,
+               int threads);
+
+// Threads to use for an input of n elements without a profile: 1 below
+// parallel_min_n, otherwise at most one per LS_MIN_PER_THREAD elements.
+int ls_threads(const sort_ctx* ctx, size_t n);
+
+// Resolves engine, threads and digit width for one call. `stable` forces
+// the LSD engine (argsort).
+void ls_plan_for(const sort_ctx* ctx, int type, size_t n, int stable,
+                 ls_plan* plan);
+
+// Merges the k ascending runs of src[0..n) that start at starts[0..k)
+// (starts[0] == 0) into dst, `threads` key ranges in parallel.
+int ls_merge_runs_u32(const uint32_t* src, uint32_t* dst, size_t n,
+                      const size_t* starts, int k, int threads);
+int ls_merge_runs_u64(const uint64_t* src, uint64_t* dst, size_t n,
+                      const size_t* starts, int k, int threads);
+
+// One LSD digit pass of src[0..n) into dst (radix_impl.h ls_pass) on the
+// context's count tables, sized by ls_reserve for `threads`. Returns 0,
+// leaving dst untouched, when every key has the same digit.
+int ls_radix_pass_u32(sort_ctx* ctx, const uint32_t* src, uint32_t* dst,
+                      size_t n, int shift, int bits, int threads);
+int ls_radix_pass_u64(sort_ctx* ctx, const uint64_t* src, uint64_t* dst,
+                      size_t n, int shift, int bits, int threads);
+
+// The inverse key transform of sort_* for an LS_T_* type, in place on
+// a[0..n) across `threads`.
+void ls_keys_to(int type, void* a, size_t n, int threads);
+
+const char* ls_type_name(int type);
+const char* ls_engine_name(int engine);
+
+#ifndef NO_TIMING
+#define LS_PHASE_BEGIN(ctx)                           \
+  do {                                                \
+    if ((ctx)->hooks.phase_begin)                     \
+      (ctx)->hooks.phase_begin((ctx)->hooks.user);    \
+  } while (0)
+#define LS_PHASE_END(ctx, name, index, bytes)                             \
+  do {                                                                    \
+    if ((ctx)->hooks.phase_end)                                           \
+      (ctx)->hooks.phase_end((ctx)->hooks.user, (name), (index), (bytes)); \
+  } while (0)
+#else
+#define LS_PHASE_BEGIN(ctx)
+#define LS_PHASE_END(ctx, name, index, bytes)
+#endif
+
+#endif  // LIBSORT_SORT_INTERNAL_H
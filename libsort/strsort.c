@@ -0,0 +1,335 @@
+// Lexicographic sort of string references (sort_strings).
+//
+// Strings are never copied; only (pointer, length) references move. Large
+// ranges are split by a parallel MSD radix pass on the two bytes after
+// their common prefix, and the resulting buckets are sorted independently
+// with the team handing them out dynamically; buckets that are still large
+// are split again the same way. A bucket is sorted by multikey quicksort on
+// 8-byte "characters": each reference carries the next 8 bytes of its
+// string, big-endian and zero-padded, so partitioning compares cached
+// integers instead of chasing pointers, and only references whose cached
+// bytes tie reload at the next 8.
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sort_internal.h"
+
+#define LS_STR_SPLIT_MIN ((size_t)1 << 16)  // smaller ranges: quicksort only
+#define LS_STR_INSERTION 16                 // insertion sort below this
+#define LS_STR_BUCKETS ((size_t)1 << 16)    // MSD pass: two bytes
+
+typedef struct {
+  uint64_t key;  // bytes [depth, depth + 8), big-endian, zero-padded
+  const unsigned char* ptr;
+  size_t len;
+} ls_str_item;
+
+static inline uint64_t str_key(const unsigned char* p, size_t len,
+                               size_t depth) {
+  uint64_t x = 0;
+  if (len >= depth + 8) {
+    memcpy(&x, p + depth, 8);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    return x;
+  }
+  for (size_t i = depth; i < len; i++)  // short tail, no memcpy call
+    x |= (uint64_t)p[i] << (56 - 8 * (i - depth));
+  return x;
+}
+
+// Order of a and b, whose first `depth` bytes are equal.
+static inline int str_cmp(const ls_str_item* a, const ls_str_item* b,
+                          size_t depth) {
+  if (a->key != b->key)
+    return a->key < b->key ? -1 : 1;
+  size_t from = depth + 8;
+  size_t m = a->len < b->len ? a->len : b->len;
+  if (m > from) {
+    int c = memcmp(a->ptr + from, b->ptr + from, m - from);
+    if (c)
+      return c;
+  }
+  return a->len < b->len ? -1 : a->len > b->len;
+}
+
+static void str_insertion(ls_str_item* a, size_t n, size_t depth) {
+  for (size_t i = 1; i < n; i++) {
+    ls_str_item v = a[i];
+    size_t j = i;
+    for (; j > 0 && str_cmp(&v, &a[j - 1], depth) < 0; j--)
+      a[j] = a[j - 1];
+    a[j] = v;
+  }
+}
+
+static inline void str_swap(ls_str_item* a, size_t i, size_t j) {
+  ls_str_item t = a[i];
+  a[i] = a[j];
+  a[j] = t;
+}
+
+static inline uint64_t med3(uint64_t a, uint64_t b, uint64_t c) {
+  return a < b ? (b < c ? b : a < c ? c : a) : (a < c ? a : b < c ? c : b);
+}
+
+// Multikey quicksort of a[0..n), whose keys hold bytes [depth, depth + 8).
+// Recurses on the two smaller of the <, = and > parts and loops on the
+// largest, so the stack stays logarithmic.
+static void str_mkqs(ls_str_item* a, size_t n, size_t depth) {
+  while (n > 1) {
+    if (n < LS_STR_INSERTION) {
+      str_insertion(a, n, depth);
+      return;
+    }
+    const uint64_t pivot = med3(a[0].key, a[n / 2].key, a[n - 1].key);
+    size_t lt = 0, i = 0, gt = n;
+    while (i < gt) {
+      uint64_t k = a[i].key;
+      if (k < pivot)
+        str_swap(a, lt++, i++);
+      else if (k > pivot)
+        str_swap(a, i, --gt);
+      else
+        i++;
+    }
+
+    // Ties that end within these 8 bytes are prefixes of every other tie
+    // and otherwise differ only in length (embedded NULs); they go first.
+    size_t done = lt;
+    size_t min_len = SIZE_MAX, max_len = 0;
+    for (size_t j = lt; j < gt; j++) {
+      if (a[j].len <= depth + 8) {
+        min_len = a[j].len < min_len ? a[j].len : min_len;
+        max_len = a[j].len > max_len ? a[j].len : max_len;
+        str_swap(a, done++, j);
+      }
+    }
+    for (size_t len = min_len, at = lt; len < max_len; len++)
+      for (size_t j = at; j < done; j++)
+        if (a[j].len == len)
+          str_swap(a, at++, j);
+    for (size_t j = done; j < gt; j++)
+      a[j].key = str_key(a[j].ptr, a[j].len, depth + 8);
+
+    ls_str_item* part[3] = {a, a + done, a + gt};
+    size_t size[3] = {lt, gt - done, n - gt};
+    size_t dep[3] = {depth, depth + 8, depth};
+    int big = size[1] > size[0] ? 1 : 0;
+    big = size[2] > size[big] ? 2 : big;
+    for (int k = 0; k < 3; k++)
+      if (k != big)
+        str_mkqs(part[k], size[k], dep[k]);
+    a = part[big];
+    n = size[big];
+    depth = dep[big];
+  }
+}
+
+static void str_fill(const sort_str* s, ls_str_item* a, size_t n,
+                     size_t depth) {
+  for (size_t i = 0; i < n; i++) {
+    a[i].ptr = (const unsigned char*)s[i].ptr;
+    a[i].len = s[i].len;
+    a[i].key = str_key(a[i].ptr, a[i].len, depth);
+  }
+}
+
+static void str_store(const ls_str_item* a, sort_str* s, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    s[i].ptr = (const char*)a[i].ptr;
+    s[i].len = a[i].len;
+  }
+}
+
+// Bytes after `depth` that every string of s[0..n) shares, up to `cap`.
+static size_t str_common_prefix(const sort_str* s, size_t n, size_t depth,
+                                size_t cap, int threads) {
+  const unsigned char* p0 = (const unsigned char*)s[0].ptr;
+  const size_t len0 = s[0].len;
+  const size_t limit = depth + cap;  // shared bound; lcp is only reduced
+  size_t lcp = cap;
+  long long count = (long long)n;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) if (threads > 1) \
+    schedule(static) reduction(min : lcp)
+#endif
+  for (long long i = 1; i < count; i++) {
+    const unsigned char* p = (const unsigned char*)s[i].ptr;
+    size_t end = s[i].len < len0 ? s[i].len : len0;
+    end = end < limit ? end : limit;
+    size_t j = depth;
+    while (j < end && p[j] == p0[j])
+      j++;
+    size_t m = j > depth ? j - depth : 0;
+    lcp = m < lcp ? m : lcp;
+  }
+  return lcp;
+}
+
+// A range still to be split: s[first, first + n), first `depth` bytes equal.
+typedef struct {
+  size_t first;
+  size_t n;
+  size_t depth;
+} ls_str_range;
+
+// Splits s[0..n), whose first `depth` bytes are equal, by an MSD pass into
+// a[0..n) and sorts the buckets below LS_STR_SPLIT_MIN back into s. Large
+// buckets are left in a (bucket b ends at ends[b]) for the caller to store
+// and split again; returns the depth the pass split at.
+static size_t str_split(sort_ctx* ctx, sort_str* s, ls_str_item* a,
+                        size_t n, size_t depth, int threads) {
+  LS_PHASE_BEGIN(ctx);
+  depth += str_common_prefix(s, n, depth, 64, threads);
+  LS_PHASE_END(ctx, "common_prefix", -1, n * sizeof(sort_str));
+
+  // MSD pass on bytes [depth, depth + 2): the top of each cached key. The
+  // offsets come from the row-wise parallel scan of ls_pass: every thread
+  // owns a range of buckets and walks the count rows over that range.
+  // Count rows and range totals live in the context's counts, bucket ends
+  // in its offsets (ls_reserve sizes both for `threads`).
+  const size_t buckets = LS_STR_BUCKETS;
+  uint32_t* counts = (uint32_t*)ctx->counts;
+  uint32_t* ends = (uint32_t*)ctx->offsets;
+  LS_PHASE_BEGIN(ctx);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads) if (threads > 1)
+#endif
+  {
+    const size_t tid = (size_t)ls_tid();
+    const size_t team = (size_t)ls_team();
+    const size_t first = n * tid / team;
+    const size_t last = n * (tid + 1) / team;
+    uint32_t* c = counts + tid * buckets;
+    memset(c, 0, buckets * sizeof(uint32_t));
+    for (size_t i = first; i < last; i++)
+      c[str_key((const unsigned char*)s[i].ptr, s[i].len, depth) >> 48]++;
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+    // Bucket totals of this thread's range go into ends, then become the
+    // bucket starts.
+    uint32_t* range_sum = counts + team * buckets;
+    const size_t b0 = buckets * tid / team;
+    const size_t b1 = buckets * (tid + 1) / team;
+    for (size_t b = b0; b < b1; b++)
+      ends[b] = 0;
+    for (size_t t = 0; t < team; t++) {
+      const uint32_t* row = counts + t * buckets;
+      for (size_t b = b0; b < b1; b++)
+        ends[b] += row[b];
+    }
+    uint32_t sum = 0;
+    for (size_t b = b0; b < b1; b++)
+      sum += ends[b];
+    range_sum[tid] = sum;
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+    uint32_t pos = 0;
+    for (size_t t = 0; t < tid; t++)
+      pos += range_sum[t];
+    for (size_t b = b0; b < b1; b++) {
+      uint32_t v = ends[b];
+      ends[b] = pos;
+      pos += v;
+    }
+    // Row t starts where rows 0..t-1 end; ends[b] finishes as the end.
+    for (size_t t = 0; t < team; t++) {
+      uint32_t* row = counts + t * buckets;
+      for (size_t b = b0; b < b1; b++) {
+        uint32_t v = row[b];
+        row[b] = ends[b];
+        ends[b] += v;
+      }
+    }
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+    for (size_t i = first; i < last; i++) {
+      const unsigned char* p = (const unsigned char*)s[i].ptr;
+      uint64_t key = str_key(p, s[i].len, depth);
+      ls_str_item* d = &a[c[key >> 48]++];
+      d->key = key;
+      d->ptr = p;
+      d->len = s[i].len;
+    }
+  }
+  LS_PHASE_END(ctx, "msd_pass", -1,
+               n * (2 * sizeof(sort_str) + sizeof(ls_str_item)));
+
+  // Buckets below LS_STR_SPLIT_MIN are finished by quicksort, their keys
+  // already holding bytes [depth, depth + 8).
+  LS_PHASE_BEGIN(ctx);
+  long long count = (long long)buckets;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) if (threads > 1) \
+    schedule(dynamic, 16)
+#endif
+  for (long long b = 0; b < count; b++) {
+    size_t first = b ? ends[b - 1] : 0;
+    size_t len = ends[b] - first;
+    if (len >= LS_STR_SPLIT_MIN && len < n)
+      continue;
+    str_mkqs(a + first, len, depth);
+    str_store(a + first, s + first, len);
+  }
+  LS_PHASE_END(ctx, "bucket_sort", -1, n * sizeof(ls_str_item));
+  return depth;
+}
+
+int sort_strings(sort_ctx* ctx, sort_str* s, size_t n) {
+  if (!ctx || (!s && n))
+    return SORT_EINVAL;
+  if (n > UINT32_MAX)  // bucket offsets are 32-bit
+    return SORT_EINVAL;
+  if (n < 2)
+    return SORT_OK;
+  const int threads = ls_threads(ctx, n);
+  if (n < LS_STR_SPLIT_MIN) {
+    ls_str_item* a = (ls_str_item*)ls_arena(
+        ctx, &ctx->keys[1], &ctx->keys_cap[1], n * sizeof(ls_str_item));
+    if (!a)
+      return SORT_ENOMEM;
+    str_fill(s, a, n, 0);
+    str_mkqs(a, n, 0);
+    str_store(a, s, n);
+    return SORT_OK;
+  }
+
+  // Ranges waiting to be split are disjoint and at least LS_STR_SPLIT_MIN
+  // long, so the stack never holds more than n / LS_STR_SPLIT_MIN.
+  int rc = ls_reserve(ctx, n, sizeof(ls_str_item), 0, threads);
+  if (rc != SORT_OK)
+    return rc;
+  ls_str_range* stack = (ls_str_range*)ls_arena(
+      ctx, &ctx->idx, &ctx->idx_cap,
+      (n / LS_STR_SPLIT_MIN + 1) * sizeof(ls_str_range));
+  if (!stack)
+    return SORT_ENOMEM;
+  ls_str_item* const a = (ls_str_item*)ctx->keys[1];
+  const uint32_t* const ends = (const uint32_t*)ctx->offsets;
+  size_t top = 0;
+  stack[top++] = (ls_str_range){0, n, 0};
+  while (top) {
+    const ls_str_range r = stack[--top];
+    const size_t depth =
+        str_split(ctx, s + r.first, a + r.first, r.n, r.depth, threads);
+    // Large buckets are split again two bytes deeper. A pass that left
+    // everything in one bucket was finished by quicksort above.
+    for (size_t b = 0; b < LS_STR_BUCKETS; b++) {
+      size_t first = b ? ends[b - 1] : 0;
+      size_t len = ends[b] - first;
+      if (len < LS_STR_SPLIT_MIN || len == r.n)
+        continue;
+      first += r.first;
+      str_store(a + first, s + first, len);
+      stack[top++] = (ls_str_range){first, len, depth + 2};
+    }
+  }
+  return SORT_OK;
+}
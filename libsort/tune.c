@@ -0,0 +1,316 @@
+// CPU budget detection, tuning profiles and the calibration run.
+
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sort_internal.h"
+
+static const char* const kTypeNames[LS_T_COUNT] = {"i32", "f32", "f64"};
+
+const char* ls_type_name(int type) {
+  return type >= 0 && type < LS_T_COUNT ? kTypeNames[type] : "?";
+}
+
+const char* ls_engine_name(int engine) {
+  return engine == SORT_ENGINE_INTROSORT ? "introsort"
+         : engine == SORT_ENGINE_HYBRID  ? "hybrid"
+                                         : "lsd";
+}
+
+// ===================== CPU budget =====================
+// cgroup v2 cpu.max holds "max <period>" or "<quota> <period>"; v1 splits
+// them over two files with -1 for no limit. Returns 0 when unlimited.
+static int cgroup_cpu_limit(void) {
+  long long quota = -1, period = 0;
+  char path[512] = "/sys/fs/cgroup/cpu.max";
+
+  // Own cgroup first ("0::/path" in /proc/self/cgroup), then the root
+  // of the (possibly namespaced) hierarchy.
+  FILE* f = fopen("/proc/self/cgroup", "r");
+  if (f) {
+    char line[400];
+    while (fgets(line, sizeof(line), f)) {
+      if (strncmp(line, "0::", 3) == 0) {
+        line[strcspn(line, "\n")] = 0;
+        snprintf(path, sizeof(path), "/sys/fs/cgroup%s/cpu.max", line + 3);
+        break;
+      }
+    }
+    fclose(f);
+  }
+
+  const char* v2[] = {path, "/sys/fs/cgroup/cpu.max"};
+  for (int i = 0; i < 2 && period <= 0; i++) {
+    f = fopen(v2[i], "r");
+    if (!f)
+      continue;
+    char q[32];
+    if (fscanf(f, "%31s %lld", q, &period) == 2)
+      quota = strcmp(q, "max") == 0 ? -1 : atoll(q);
+    fclose(f);
+  }
+
+  if (period <= 0) {
+    f = fopen("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r");
+    if (f) {
+      if (fscanf(f, "%lld", &quota) != 1)
+        quota = -1;
+      fclose(f);
+    }
+    f = fopen("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r");
+    if (f) {
+      if (fscanf(f, "%lld", &period) != 1)
+        period = 0;
+      fclose(f);
+    }
+  }
+
+  if (quota <= 0 || period <= 0)
+    return 0;
+  return (int)((quota + period - 1) / period);
+}
+
+int sort_available_cpus(void) {
+  int cpus = 0;
+#ifdef __linux__
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    cpus = CPU_COUNT(&set);
+#endif
+  if (cpus <= 0)
+    cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int limit = cgroup_cpu_limit();
+  if (limit > 0 && limit < cpus)
+    cpus = limit;
+  return cpus < 1 ? 1 : cpus;
+}
+
+// ===================== profiles =====================
+// Text format, one entry per line:
+//   <i32|f32|f64> <n> <lsd|introsort|hybrid> <threads> <digit_bits>
+// '#' starts a comment line.
+
+int sort_ctx_load_profile(sort_ctx* ctx, const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f)
+    return SORT_EINVAL;
+
+  int cpus = sort_available_cpus();
+  int count = 0, bad = 0;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    char type[8], engine[16];
+    unsigned long long n;
+    int threads, bits;
+    if (line[0] == '#' || line[strspn(line, " \t\r\n")] == 0)
+      continue;
+    if (sscanf(line, "%7s %llu %15s %d %d", type, &n, engine, &threads,
+               &bits) != 5) {
+      bad = 1;
+      break;
+    }
+    int t = -1;
+    for (int k = 0; k < LS_T_COUNT; k++)
+      if (strcmp(type, kTypeNames[k]) == 0)
+        t = k;
+    int e = strcmp(engine, "lsd") == 0         ? SORT_ENGINE_LSD
+            : strcmp(engine, "introsort") == 0 ? SORT_ENGINE_INTROSORT
+            : strcmp(engine, "hybrid") == 0    ? SORT_ENGINE_HYBRID
+                                               : -1;
+    if (t < 0 || e < 0 || count == LS_MAX_PROFILE) {
+      bad = 1;
+      break;
+    }
+    ls_profile_entry* p = &ctx->profile[count++];
+    p->type = t;
+    p->n = (size_t)n;
+    p->engine = e;
+    p->threads = threads > cpus ? cpus : threads;
+    p->digit_bits = bits;
+  }
+  fclose(f);
+  if (bad)
+    return SORT_EINVAL;
+  ctx->n_profile = count;
+  return SORT_OK;
+}
+
+// ===================== calibration =====================
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t splitmix64(uint64_t* s) {
+  uint64_t z = (*s += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+static void fill_uniform(int type, void* p, size_t n) {
+  uint64_t s = 42;
+  for (size_t i = 0; i < n; i++) {
+    uint64_t r = splitmix64(&s);
+    double u = (double)(r >> 11) * 0x1.0p-53 * 2e6 - 1e6;
+    if (type == LS_T_I32)
+      ((int32_t*)p)[i] = (int32_t)(uint32_t)r;
+    else if (type == LS_T_F32)
+      ((float*)p)[i] = (float)u;
+    else
+      ((double*)p)[i] = u;
+  }
+}
+
+static int run_sort(sort_ctx* ctx, int type, void* p, size_t n) {
+  if (type == LS_T_I32)
+    return sort_i32(ctx, (int32_t*)p, n);
+  if (type == LS_T_F32)
+    return sort_f32(ctx, (float*)p, n);
+  return sort_f64(ctx, (double*)p, n);
+}
+
+// Median time of `reps` sorts of a fresh copy, after one untimed warm-up
+// that sizes and faults the arenas.
+static double time_candidate(sort_ctx* ctx, int type, const void* pristine,
+                             void* work, size_t n, size_t bytes, int reps) {
+  double t[16];
+  memcpy(work, pristine, bytes);
+  if (run_sort(ctx, type, work, n) != SORT_OK)
+    return -1.0;
+  for (int r = 0; r < reps; r++) {
+    memcpy(work, pristine, bytes);
+    double t0 = now_sec();
+    run_sort(ctx, type, work, n);
+    t[r] = now_sec() - t0;
+  }
+  for (int i = 1; i < reps; i++)  // reps is tiny: insertion sort
+    for (int j = i; j > 0 && t[j - 1] > t[j]; j--) {
+      double x = t[j];
+      t[j] = t[j - 1];
+      t[j - 1] = x;
+    }
+  return t[reps / 2];
+}
+
+int sort_calibrate(const char* path, size_t max_n, FILE* log) {
+  static const int kBits[] = {8, 11, 16};
+  const int cpus = sort_available_cpus();
+  if (max_n < 1000)
+    max_n = 1000;
+
+  const size_t bytes_max = max_n * sizeof(double);
+  void* pristine = malloc(bytes_max);
+  void* work = malloc(bytes_max);
+  sort_ctx* ctx = sort_ctx_create(NULL);
+  if (!pristine || !work || !ctx) {
+    free(pristine);
+    free(work);
+    sort_ctx_destroy(ctx);
+    return SORT_ENOMEM;
+  }
+
+  // team sizes tried: powers of two below the CPU budget, then the budget
+  int team[20];
+  int n_team = 0;
+  for (int th = 1; th < cpus && n_team < 19; th *= 2)
+    team[n_team++] = th;
+  team[n_team++] = cpus;
+
+  ls_profile_entry best[LS_MAX_PROFILE];
+  int count = 0;
+  int rc = SORT_OK;
+
+  for (int type = 0; type < LS_T_COUNT && rc == SORT_OK; type++) {
+    const size_t esz = type == LS_T_F64 ? 8 : 4;
+    for (size_t n = 1000; n <= max_n && count < LS_MAX_PROFILE; n *= 10) {
+      const size_t bytes = n * esz;
+      const int reps = n <= 100000 ? 9 : 3;
+      fill_uniform(type, pristine, n);
+
+      ls_profile_entry* b = &best[count];
+      double best_t = -1.0;
+      sort_tuning tuning;
+      sort_tuning_default(&tuning);
+      tuning.parallel_min_n = 0;
+
+      // introsort runs on one thread with no digits; only small sizes
+      int cand = 0;
+      int engine[96], threads[96], bits[96];
+      if (n <= 100000) {
+        engine[cand] = SORT_ENGINE_INTROSORT;
+        threads[cand] = 1;
+        bits[cand++] = LS_DIGIT_BITS;
+      }
+      for (int bi = 0; bi < 3; bi++)
+        for (int ti = 0; ti < n_team; ti++) {
+          if (team[ti] > 1 && n / (size_t)team[ti] < 1024)
+            break;  // slices too small to matter
+          engine[cand] = SORT_ENGINE_LSD;
+          threads[cand] = team[ti];
+          bits[cand++] = kBits[bi];
+        }
+      // the MSD + LSD hybrid picks its own digits; 64-bit keys only
+      if (type == LS_T_F64 && n >= 100000)
+        for (int ti = 0; ti < n_team; ti++) {
+          engine[cand] = SORT_ENGINE_HYBRID;
+          threads[cand] = team[ti];
+          bits[cand++] = LS_DIGIT_BITS;
+        }
+
+      for (int c = 0; c < cand; c++) {
+        tuning.engine = engine[c];
+        tuning.threads = threads[c];
+        tuning.digit_bits = bits[c];
+        sort_ctx_set_tuning(ctx, &tuning);
+        double t = time_candidate(ctx, type, pristine, work, n, bytes, reps);
+        if (t < 0) {
+          rc = SORT_ENOMEM;
+          goto done;
+        }
+        if (best_t < 0 || t < best_t) {
+          best_t = t;
+          b->type = type;
+          b->n = n;
+          b->engine = engine[c];
+          b->threads = threads[c];
+          b->digit_bits = bits[c];
+        }
+      }
+      if (log)
+        fprintf(log, "%s n=%zu: %s threads=%d digit_bits=%d %.3f ms\n",
+                kTypeNames[type], n, ls_engine_name(b->engine), b->threads,
+                b->digit_bits, best_t * 1e3);
+      count++;
+    }
+  }
+
+done:
+  if (rc == SORT_OK) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+      rc = SORT_EINVAL;
+    } else {
+      fprintf(f, "# libsort tuning profile (isa %s, cpus %d)\n", sort_isa(),
+              cpus);
+      fprintf(f, "# type n engine threads digit_bits\n");
+      for (int i = 0; i < count; i++)
+        fprintf(f, "%s %zu %s %d %d\n", kTypeNames[best[i].type], best[i].n,
+                ls_engine_name(best[i].engine), best[i].threads,
+                best[i].digit_bits);
+      if (fclose(f) != 0)
+        rc = SORT_EINVAL;
+    }
+  }
+  free(pristine);
+  free(work);
+  sort_ctx_destroy(ctx);
+  return rc;
+}
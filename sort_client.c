@@ -0,0 +1,366 @@
+// Client for `sort_omp --serve`.
+//
+// Build:
+//   gcc -O3 -std=c11 -Wall -Wextra -o sort_client sort_client.c
+//
+// usage: sort_client [--socket PATH] [--type int|float|double] <in> <out>
+//        sort_client [--socket PATH] [--type T] --bench ITERS [--n N]
+//        sort_client [--socket PATH] --ping | --shutdown
+//
+// <in> is a raw native-endian array (e.g. gen_input --binary); the sorted
+// array is written to <out>. The payload is handed to the server as a memfd
+// and sorted in place there, so nothing is copied through the socket.
+//
+// --bench sends ITERS sort jobs of N uniform random elements over one
+// connection (refilling the memfd before each, untimed) and prints latency
+// percentiles of the full round trip and of the server-side sort.
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libsort/sort.h"
+#include "sort_proto.h"
+
+#define DEFAULT_SOCKET "/tmp/sort_omp.sock"
+
+static void usage(void) {
+  fprintf(stderr,
+          "usage: sort_client [--socket PATH] [--type int|float|double] <in> "
+          "<out>\n"
+          "       sort_client [--socket PATH] [--type T] --bench ITERS [--n "
+          "N]\n"
+          "       sort_client [--socket PATH] --ping | --shutdown\n");
+}
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static const char* status_name(int status) {
+  switch (status) {
+    case SORT_OK:
+      return "ok";
+    case SORT_ENOMEM:
+      return "server out of memory";
+    case SORT_EINVAL:
+      return "invalid input";
+    case SORT_PROTO_EBADREQ:
+      return "bad request";
+    case SORT_PROTO_EPAYLOAD:
+      return "payload could not be mapped";
+    default:
+      return "unknown error";
+  }
+}
+
+// ===================== connection =====================
+static int connect_server(const char* path) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Socket path too long: '%s'\n", path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    fprintf(stderr, "Failed to connect to '%s': %s\n", path, strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Sends one request (with payload_fd attached when >= 0) and waits for the
+// reply. Returns 0 when a well-formed reply arrived.
+static int call(int conn, const sort_request* req, int payload_fd,
+                sort_reply* rep) {
+  char cbuf[CMSG_SPACE(sizeof(int))];
+  struct iovec iov = {(void*)req, sizeof(*req)};
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  if (payload_fd >= 0) {
+    memset(cbuf, 0, sizeof(cbuf));
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    struct cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(c), &payload_fd, sizeof(int));
+  }
+  if (sendmsg(conn, &msg, MSG_NOSIGNAL) != (ssize_t)sizeof(*req))
+    return -1;
+
+  size_t got = 0;
+  while (got < sizeof(*rep)) {
+    ssize_t r = recv(conn, (char*)rep + got, sizeof(*rep) - got, 0);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      return -1;
+    got += (size_t)r;
+  }
+  return rep->magic == SORT_PROTO_MAGIC ? 0 : -1;
+}
+
+static void* map_payload(int fd, size_t bytes) {
+  if (ftruncate(fd, (off_t)bytes) != 0)
+    return NULL;
+  void* p = mmap(NULL, bytes ? bytes : 1, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 fd, 0);
+  return p == MAP_FAILED ? NULL : p;
+}
+
+// ===================== file mode =====================
+static int read_full(int fd, char* p, size_t len) {
+  while (len) {
+    ssize_t r = read(fd, p, len);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      return -1;
+    p += r;
+    len -= (size_t)r;
+  }
+  return 0;
+}
+
+static int write_full(int fd, const char* p, size_t len) {
+  while (len) {
+    ssize_t w = write(fd, p, len);
+    if (w < 0 && errno == EINTR)
+      continue;
+    if (w < 0)
+      return -1;
+    p += w;
+    len -= (size_t)w;
+  }
+  return 0;
+}
+
+static int sort_file(int conn, uint32_t elem, size_t esz, const char* in_path,
+                     const char* out_path) {
+  int in = open(in_path, O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (in < 0 || fstat(in, &st) != 0) {
+    fprintf(stderr, "Failed to open input file '%s': %s\n", in_path,
+            strerror(errno));
+    return 1;
+  }
+  size_t n = (size_t)st.st_size / esz;
+  size_t bytes = n * esz;
+
+  int mfd = memfd_create("sort_payload", MFD_CLOEXEC);
+  char* p = mfd >= 0 ? (char*)map_payload(mfd, bytes) : NULL;
+  if (!p) {
+    fprintf(stderr, "Failed to create payload: %s\n", strerror(errno));
+    return 1;
+  }
+  if (read_full(in, p, bytes) != 0) {
+    fprintf(stderr, "Failed to read input file '%s'\n", in_path);
+    return 1;
+  }
+  close(in);
+
+  sort_request req = {SORT_PROTO_MAGIC, SORT_OP_SORT, elem, 0, (uint64_t)n};
+  sort_reply rep;
+  double t0 = now_sec();
+  if (call(conn, &req, mfd, &rep) != 0) {
+    fprintf(stderr, "Server did not answer\n");
+    return 1;
+  }
+  double rtt = now_sec() - t0;
+  if (rep.status != SORT_OK) {
+    fprintf(stderr, "Sort failed (%s)\n", status_name(rep.status));
+    return 1;
+  }
+  fprintf(stderr, "SORT_ONLY: %.6f s\n", (double)rep.sort_ns * 1e-9);
+  fprintf(stderr, "ROUND_TRIP: %.6f s\n", rtt);
+
+  int out = open(out_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (out < 0 || write_full(out, p, bytes) != 0 || close(out) != 0) {
+    fprintf(stderr, "Failed to write output file '%s': %s\n", out_path,
+            strerror(errno));
+    return 1;
+  }
+  munmap(p, bytes ? bytes : 1);
+  close(mfd);
+  return 0;
+}
+
+// ===================== bench mode =====================
+static uint64_t splitmix64(uint64_t* s) {
+  uint64_t z = (*s += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+static void fill_uniform(char* p, uint32_t elem, size_t n) {
+  uint64_t s = 42;
+  for (size_t i = 0; i < n; i++) {
+    uint64_t r = splitmix64(&s);
+    if (elem == SORT_ELEM_I32) {
+      ((int32_t*)p)[i] = (int32_t)(uint32_t)r;
+    } else if (elem == SORT_ELEM_F32) {
+      ((float*)p)[i] = (float)((double)(r >> 11) * 0x1.0p-53 * 2e6 - 1e6);
+    } else {
+      ((double*)p)[i] = (double)(r >> 11) * 0x1.0p-53 * 2e6 - 1e6;
+    }
+  }
+}
+
+static int cmp_double(const void* x, const void* y) {
+  double a = *(const double*)x, b = *(const double*)y;
+  return (a > b) - (a < b);
+}
+
+static double pct(const double* sorted, size_t count, double q) {
+  size_t i = (size_t)(q * (double)(count - 1) + 0.5);
+  return sorted[i];
+}
+
+static void print_latency(const char* label, double* v, size_t count) {
+  qsort(v, count, sizeof(double), cmp_double);
+  printf("%-11s p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f us\n", label,
+         pct(v, count, 0.50) * 1e6, pct(v, count, 0.90) * 1e6,
+         pct(v, count, 0.99) * 1e6, v[count - 1] * 1e6);
+}
+
+static int bench(int conn, uint32_t elem, size_t esz, size_t n, size_t iters) {
+  size_t bytes = n * esz;
+  char* pristine = (char*)malloc(bytes ? bytes : 1);
+  double* rtt = (double*)malloc(iters * sizeof(double));
+  double* srv = (double*)malloc(iters * sizeof(double));
+  int mfd = memfd_create("sort_bench", MFD_CLOEXEC);
+  char* p = mfd >= 0 ? (char*)map_payload(mfd, bytes) : NULL;
+  if (!pristine || !rtt || !srv || !p) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
+  fill_uniform(pristine, elem, n);
+
+  sort_request req = {SORT_PROTO_MAGIC, SORT_OP_SORT, elem, 0, (uint64_t)n};
+  for (size_t it = 0; it < iters; it++) {
+    memcpy(p, pristine, bytes);
+    sort_reply rep;
+    double t0 = now_sec();
+    if (call(conn, &req, mfd, &rep) != 0) {
+      fprintf(stderr, "Server did not answer\n");
+      return 1;
+    }
+    rtt[it] = now_sec() - t0;
+    if (rep.status != SORT_OK) {
+      fprintf(stderr, "Sort failed (%s)\n", status_name(rep.status));
+      return 1;
+    }
+    srv[it] = (double)rep.sort_ns * 1e-9;
+  }
+
+  printf("n=%zu iters=%zu\n", n, iters);
+  print_latency("round_trip", rtt, iters);
+  print_latency("server_sort", srv, iters);
+
+  munmap(p, bytes ? bytes : 1);
+  close(mfd);
+  free(pristine);
+  free(rtt);
+  free(srv);
+  return 0;
+}
+
+// ===================== main =====================
+int main(int argc, char** argv) {
+  const char* sock_path = DEFAULT_SOCKET;
+  const char* in_path = NULL;
+  const char* out_path = NULL;
+  uint32_t elem = SORT_ELEM_I32;
+  size_t bench_iters = 0;
+  size_t bench_n = 1000000;
+  uint32_t op = SORT_OP_SORT;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+    if (strcmp(a, "--socket") == 0 && v) {
+      sock_path = v;
+      i++;
+    } else if (strcmp(a, "--type") == 0 && v) {
+      if (strcmp(v, "int") == 0)
+        elem = SORT_ELEM_I32;
+      else if (strcmp(v, "float") == 0)
+        elem = SORT_ELEM_F32;
+      else if (strcmp(v, "double") == 0)
+        elem = SORT_ELEM_F64;
+      else {
+        fprintf(stderr, "Unknown type '%s'\n", v);
+        return 2;
+      }
+      i++;
+    } else if (strcmp(a, "--bench") == 0 && v) {
+      bench_iters = (size_t)strtod(v, NULL);
+      i++;
+    } else if (strcmp(a, "--n") == 0 && v) {
+      bench_n = (size_t)strtod(v, NULL);
+      i++;
+    } else if (strcmp(a, "--ping") == 0) {
+      op = SORT_OP_PING;
+    } else if (strcmp(a, "--shutdown") == 0) {
+      op = SORT_OP_SHUTDOWN;
+    } else if (a[0] == '-' && a[1] == '-') {
+      usage();
+      return 2;
+    } else if (!in_path) {
+      in_path = a;
+    } else if (!out_path) {
+      out_path = a;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (op == SORT_OP_SORT && !bench_iters && (!in_path || !out_path)) {
+    usage();
+    return 2;
+  }
+
+  int conn = connect_server(sock_path);
+  if (conn < 0)
+    return 1;
+
+  const size_t esz = elem == SORT_ELEM_F64 ? 8 : 4;
+  int rc;
+  if (op != SORT_OP_SORT) {
+    sort_request req = {SORT_PROTO_MAGIC, op, 0, 0, 0};
+    sort_reply rep;
+    double t0 = now_sec();
+    rc = call(conn, &req, -1, &rep) == 0 ? 0 : 1;
+    if (rc == 0 && op == SORT_OP_PING)
+      printf("pong %.1f us\n", (now_sec() - t0) * 1e6);
+  } else if (bench_iters) {
+    rc = bench(conn, elem, esz, bench_n, bench_iters);
+  } else {
+    rc = sort_file(conn, elem, esz, in_path, out_path);
+  }
+  close(conn);
+  return rc;
+}
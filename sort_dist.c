@@ -0,0 +1,503 @@
+// Distributed sample sort: transports, mesh setup, exchange, sample sort.
+// See sort_dist.h.
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "sort_dist.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sort_proto.h"
+
+#define DIST_SAMPLES 64  // regular samples contributed per worker
+#define DIST_CHUNK ((size_t)1 << 20)
+
+// ===================== transports =====================
+static int unix_addr(const char* path, struct sockaddr_un* sa) {
+  memset(sa, 0, sizeof(*sa));
+  sa->sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(sa->sun_path))
+    return -1;
+  strcpy(sa->sun_path, path);
+  return 0;
+}
+
+static int unix_listen(const char* path) {
+  struct sockaddr_un sa;
+  if (unix_addr(path, &sa) != 0)
+    return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  unlink(path);
+  if (fd < 0 || bind(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 ||
+      listen(fd, 64) != 0) {
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int unix_connect(const char* path) {
+  struct sockaddr_un sa;
+  if (unix_addr(path, &sa) != 0)
+    return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd >= 0 && connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  return fd;
+}
+
+// "host:port"; the last colon separates the port.
+static struct addrinfo* tcp_resolve(const char* addr, int passive) {
+  char host[256];
+  const char* colon = strrchr(addr, ':');
+  if (!colon || (size_t)(colon - addr) >= sizeof(host))
+    return NULL;
+  memcpy(host, addr, (size_t)(colon - addr));
+  host[colon - addr] = 0;
+  struct addrinfo hints, *res = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+  if (getaddrinfo(host[0] ? host : NULL, colon + 1, &hints, &res) != 0)
+    return NULL;
+  return res;
+}
+
+static int tcp_open(const char* addr, int passive) {
+  struct addrinfo* res = tcp_resolve(addr, passive);
+  int fd = -1;
+  for (struct addrinfo* ai = res; ai && fd < 0; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+                ai->ai_protocol);
+    if (fd < 0)
+      continue;
+    int one = 1;
+    int ok;
+    if (passive) {
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      ok = bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 64) == 0;
+    } else {
+      ok = connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    if (!ok) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  if (res)
+    freeaddrinfo(res);
+  return fd;
+}
+
+static int tcp_listen(const char* addr) {
+  return tcp_open(addr, 1);
+}
+
+static int tcp_connect(const char* addr) {
+  return tcp_open(addr, 0);
+}
+
+static const dist_transport kTransports[] = {
+    {"unix", unix_listen, unix_connect},
+    {"tcp", tcp_listen, tcp_connect},
+};
+
+// Splits "scheme:rest" and returns the transport, or NULL.
+static const dist_transport* find_transport(const char* addr,
+                                            const char** rest) {
+  for (size_t i = 0; i < sizeof(kTransports) / sizeof(kTransports[0]); i++) {
+    size_t len = strlen(kTransports[i].scheme);
+    if (strncmp(addr, kTransports[i].scheme, len) == 0 && addr[len] == ':') {
+      *rest = addr + len + 1;
+      return &kTransports[i];
+    }
+  }
+  return NULL;
+}
+
+// ===================== mesh =====================
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int io_full(int fd, void* p, size_t len, int writing) {
+  char* b = (char*)p;
+  while (len) {
+    ssize_t got =
+        writing ? send(fd, b, len, MSG_NOSIGNAL) : recv(fd, b, len, 0);
+    if (got < 0 && errno == EINTR)
+      continue;
+    if (got <= 0)
+      return -1;
+    b += got;
+    len -= (size_t)got;
+  }
+  return 0;
+}
+
+// Lower ranks listen, higher ranks connect: rank r dials every rank below
+// it (retrying until that rank is up) and accepts one connection from every
+// rank above. Each connection starts with the dialer's rank.
+int dist_open(dist_comm* c, int rank, char* const* addrs, int size,
+              int timeout_s) {
+  c->rank = rank;
+  c->size = size;
+  c->fds = (int*)malloc((size_t)size * sizeof(int));
+  if (!c->fds)
+    return -1;
+  for (int r = 0; r < size; r++)
+    c->fds[r] = -1;
+
+  const char* mine;
+  const dist_transport* t = find_transport(addrs[rank], &mine);
+  if (!t) {
+    fprintf(stderr, "Unknown transport in '%s' (want unix: or tcp:)\n",
+            addrs[rank]);
+    return -1;
+  }
+  int lfd = t->listen(mine);
+  if (lfd < 0) {
+    fprintf(stderr, "Failed to listen on '%s': %s\n", addrs[rank],
+            strerror(errno));
+    return -1;
+  }
+
+  const double deadline = now_sec() + timeout_s;
+  int rc = 0;
+  for (int r = 0; r < rank && rc == 0; r++) {
+    const char* peer;
+    const dist_transport* pt = find_transport(addrs[r], &peer);
+    int fd = -1;
+    while (pt && (fd = pt->connect(peer)) < 0 && now_sec() < deadline) {
+      struct timespec ts = {0, 50 * 1000 * 1000};
+      nanosleep(&ts, NULL);
+    }
+    uint32_t me = (uint32_t)rank;
+    if (fd < 0 || io_full(fd, &me, sizeof(me), 1) != 0) {
+      fprintf(stderr, "Failed to connect to worker %d at '%s'\n", r,
+              addrs[r]);
+      if (fd >= 0)
+        close(fd);
+      rc = -1;
+      break;
+    }
+    c->fds[r] = fd;
+  }
+
+  for (int accepted = 0; rc == 0 && accepted < size - 1 - rank;) {
+    int wait_ms = (int)((deadline - now_sec()) * 1e3);
+    struct pollfd pfd = {lfd, POLLIN, 0};
+    if (wait_ms <= 0 || poll(&pfd, 1, wait_ms) <= 0) {
+      if (wait_ms > 0 && errno == EINTR)
+        continue;
+      fprintf(stderr, "Timed out waiting for workers\n");
+      rc = -1;
+      break;
+    }
+    int fd = accept(lfd, NULL, NULL);
+    uint32_t peer;
+    if (fd < 0 || io_full(fd, &peer, sizeof(peer), 0) != 0 ||
+        peer <= (uint32_t)rank || peer >= (uint32_t)size ||
+        c->fds[peer] >= 0) {
+      fprintf(stderr, "Bad handshake from a worker\n");
+      if (fd >= 0)
+        close(fd);
+      rc = -1;
+      break;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    c->fds[peer] = fd;
+    accepted++;
+  }
+
+  close(lfd);
+  if (t->listen == unix_listen)
+    unlink(mine);
+  for (int r = 0; r < size && rc == 0; r++)
+    if (c->fds[r] >= 0)
+      fcntl(c->fds[r], F_SETFL, fcntl(c->fds[r], F_GETFL) | O_NONBLOCK);
+  if (rc != 0)
+    dist_close(c);
+  return rc;
+}
+
+void dist_close(dist_comm* c) {
+  for (int r = 0; c->fds && r < c->size; r++)
+    if (c->fds[r] >= 0)
+      close(c->fds[r]);
+  free(c->fds);
+  c->fds = NULL;
+}
+
+// ===================== exchange =====================
+// Sends sbuf[r] to and receives rbuf[r] from every peer r at once, polling
+// all connections so that no pair can block on full socket buffers. The
+// self entries are ignored.
+static int exchange(dist_comm* c,
+                    const char* const* sbuf,
+                    const size_t* slen,
+                    char* const* rbuf,
+                    const size_t* rlen) {
+  const int p = c->size;
+  size_t* sent = (size_t*)calloc((size_t)p, sizeof(size_t));
+  size_t* got = (size_t*)calloc((size_t)p, sizeof(size_t));
+  struct pollfd* pfd = (struct pollfd*)malloc((size_t)p * sizeof(*pfd));
+  int* peer = (int*)malloc((size_t)p * sizeof(int));
+  int rc = (sent && got && pfd && peer) ? 0 : -1;
+
+  while (rc == 0) {
+    int np = 0;
+    for (int r = 0; r < p; r++) {
+      if (r == c->rank)
+        continue;
+      short ev = (short)((sent[r] < slen[r] ? POLLOUT : 0) |
+                         (got[r] < rlen[r] ? POLLIN : 0));
+      if (!ev)
+        continue;
+      pfd[np].fd = c->fds[r];
+      pfd[np].events = ev;
+      pfd[np].revents = 0;
+      peer[np++] = r;
+    }
+    if (np == 0)
+      break;
+    if (poll(pfd, (nfds_t)np, -1) < 0) {
+      if (errno != EINTR)
+        rc = -1;
+      continue;
+    }
+    for (int i = 0; i < np && rc == 0; i++) {
+      int r = peer[i];
+      if (pfd[i].revents & POLLOUT) {
+        size_t len = slen[r] - sent[r];
+        ssize_t w = send(pfd[i].fd, sbuf[r] + sent[r],
+                         len < DIST_CHUNK ? len : DIST_CHUNK, MSG_NOSIGNAL);
+        if (w > 0)
+          sent[r] += (size_t)w;
+        else if (w < 0 && errno != EAGAIN && errno != EINTR)
+          rc = -1;
+      }
+      if (pfd[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+        size_t len = rlen[r] - got[r];
+        ssize_t n = len ? recv(pfd[i].fd, rbuf[r] + got[r],
+                               len < DIST_CHUNK ? len : DIST_CHUNK, 0)
+                        : 0;
+        if (n > 0)
+          got[r] += (size_t)n;
+        else if (len && (n == 0 || (errno != EAGAIN && errno != EINTR)))
+          rc = -1;  // peer closed or failed mid-exchange
+      }
+    }
+  }
+  free(sent);
+  free(got);
+  free(pfd);
+  free(peer);
+  return rc;
+}
+
+int dist_allgather(dist_comm* c, const void* mine, size_t bytes, void* all) {
+  const int p = c->size;
+  const char** sbuf = (const char**)malloc((size_t)p * sizeof(char*));
+  char** rbuf = (char**)malloc((size_t)p * sizeof(char*));
+  size_t* len = (size_t*)malloc((size_t)p * sizeof(size_t));
+  int rc = -1;
+  if (sbuf && rbuf && len) {
+    for (int r = 0; r < p; r++) {
+      sbuf[r] = (const char*)mine;
+      rbuf[r] = (char*)all + (size_t)r * bytes;
+      len[r] = bytes;
+    }
+    memcpy(rbuf[c->rank], mine, bytes);
+    rc = exchange(c, sbuf, len, rbuf, len);
+  }
+  free(sbuf);
+  free(rbuf);
+  free(len);
+  return rc;
+}
+
+// ===================== sample sort =====================
+// Splitters and partition bounds compare total-order keys, the order the
+// local sorts and the merge use.
+static uint64_t elem_key(int elem, const void* a, size_t i) {
+  if (elem == SORT_ELEM_I32)
+    return (uint32_t)((const int32_t*)a)[i] ^ 0x80000000u;
+  if (elem == SORT_ELEM_F32) {
+    uint32_t x;
+    memcpy(&x, (const float*)a + i, sizeof(x));
+    return x ^ ((uint32_t)((int32_t)x >> 31) | 0x80000000u);
+  }
+  uint64_t x;
+  memcpy(&x, (const double*)a + i, sizeof(x));
+  return x ^ ((uint64_t)((int64_t)x >> 63) | 0x8000000000000000ull);
+}
+
+// First index in sorted a[0..n) whose key is >= key.
+static size_t lower_bound(int elem, const void* a, size_t n, uint64_t key) {
+  size_t lo = 0, hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (elem_key(elem, a, mid) < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static int cmp_u64(const void* x, const void* y) {
+  uint64_t a = *(const uint64_t*)x, b = *(const uint64_t*)y;
+  return (a > b) - (a < b);
+}
+
+typedef struct {
+  uint64_t count;
+  uint64_t keys[DIST_SAMPLES];
+} dist_sample;
+
+int dist_sort(dist_comm* c, sort_ctx* ctx, int elem, void* a, size_t n,
+              void** out, size_t* out_n) {
+  const int p = c->size;
+  const size_t esz = elem == SORT_ELEM_F64 ? 8 : 4;
+  int rc = elem == SORT_ELEM_I32   ? sort_i32(ctx, (int32_t*)a, n)
+           : elem == SORT_ELEM_F32 ? sort_f32(ctx, (float*)a, n)
+                                   : sort_f64(ctx, (double*)a, n);
+  if (rc != SORT_OK)
+    return rc;
+
+  // ---- splitters from regular samples of every sorted shard ----
+  dist_sample mine;
+  memset(&mine, 0, sizeof(mine));
+  mine.count = n < DIST_SAMPLES ? n : DIST_SAMPLES;
+  for (size_t s = 0; s < mine.count; s++)
+    mine.keys[s] =
+        elem_key(elem, a, (s * n) / mine.count + n / (2 * mine.count));
+  dist_sample* all = (dist_sample*)malloc((size_t)p * sizeof(dist_sample));
+  uint64_t* pool =
+      (uint64_t*)malloc((size_t)p * DIST_SAMPLES * sizeof(uint64_t));
+  size_t* bound = (size_t*)malloc((size_t)(p + 1) * sizeof(size_t));
+  uint64_t* scount = (uint64_t*)malloc((size_t)p * sizeof(uint64_t));
+  uint64_t* rcount = (uint64_t*)malloc((size_t)p * sizeof(uint64_t));
+  const char** sbuf = (const char**)calloc((size_t)p, sizeof(char*));
+  char** rbuf = (char**)calloc((size_t)p, sizeof(char*));
+  size_t* slen = (size_t*)calloc((size_t)p, sizeof(size_t));
+  size_t* rlen = (size_t*)calloc((size_t)p, sizeof(size_t));
+  const void** runs = (const void**)malloc((size_t)p * sizeof(void*));
+  char* recv = NULL;
+  rc = SORT_ENOMEM;
+  if (!all || !pool || !bound || !scount || !rcount || !sbuf || !rbuf ||
+      !slen || !rlen || !runs)
+    goto done;
+  rc = SORT_EINVAL;
+  if (dist_allgather(c, &mine, sizeof(mine), all) != 0)
+    goto done;
+  size_t m = 0;
+  for (int r = 0; r < p; r++)
+    for (uint64_t s = 0; s < all[r].count && s < DIST_SAMPLES; s++)
+      pool[m++] = all[r].keys[s];
+  qsort(pool, m, sizeof(uint64_t), cmp_u64);
+
+  // Rank r receives keys in [splitter r-1, splitter r).
+  bound[0] = 0;
+  bound[p] = n;
+  for (int r = 1; r < p; r++)
+    bound[r] =
+        m ? lower_bound(elem, a, n, pool[((size_t)r * m) / (size_t)p]) : n;
+
+  // ---- all-to-all: counts, then the partitions ----
+  for (int r = 0; r < p; r++) {
+    scount[r] = bound[r + 1] - bound[r];
+    sbuf[r] = (const char*)&scount[r];
+    rbuf[r] = (char*)&rcount[r];
+    slen[r] = rlen[r] = sizeof(uint64_t);
+  }
+  rcount[c->rank] = scount[c->rank];
+  if (exchange(c, sbuf, slen, rbuf, rlen) != 0)
+    goto done;
+
+  size_t total = 0, remote = 0;
+  for (int r = 0; r < p; r++) {
+    total += rcount[r];
+    if (r != c->rank)
+      remote += rcount[r];
+  }
+  rc = SORT_ENOMEM;
+  recv = (char*)malloc(remote ? remote * esz : 1);
+  if (!recv)
+    goto done;
+  size_t off = 0;
+  for (int r = 0; r < p; r++) {
+    sbuf[r] = (const char*)a + bound[r] * esz;
+    slen[r] = scount[r] * esz;
+    rlen[r] = rcount[r] * esz;
+    if (r == c->rank) {
+      runs[r] = sbuf[r];
+      rbuf[r] = NULL;
+    } else {
+      rbuf[r] = recv + off;
+      runs[r] = rbuf[r];
+      off += rlen[r];
+    }
+  }
+  rc = SORT_EINVAL;
+  if (exchange(c, sbuf, slen, rbuf, rlen) != 0)
+    goto done;
+  for (int r = 0; r < p; r++)
+    rlen[r] /= esz;  // bytes -> run lengths
+
+  // ---- merge the p sorted partitions ----
+  sort_tuning tuning;
+  sort_ctx_get_tuning(ctx, &tuning);
+  *out = sort_alloc(total * esz, tuning.pages, 0);
+  *out_n = total;
+  rc = SORT_ENOMEM;
+  if (!*out)
+    goto done;
+  if (elem == SORT_ELEM_I32)
+    rc = merge_i32(ctx, (const int32_t* const*)runs, rlen, p, (int32_t*)*out);
+  else if (elem == SORT_ELEM_F32)
+    rc = merge_f32(ctx, (const float* const*)runs, rlen, p, (float*)*out);
+  else
+    rc = merge_f64(ctx, (const double* const*)runs, rlen, p, (double*)*out);
+  if (rc != SORT_OK) {
+    sort_free(*out, total * esz);
+    *out = NULL;
+  }
+
+done:
+  free(all);
+  free(pool);
+  free(bound);
+  free(scount);
+  free(rcount);
+  free(sbuf);
+  free(rbuf);
+  free(slen);
+  free(rlen);
+  free(runs);
+  free(recv);
+  return rc;
+}
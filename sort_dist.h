@@ -0,0 +1,52 @@
+// Distributed sample sort between `sort_omp --dist` workers.
+//
+// Every worker holds one shard of the input. The workers form a full mesh of
+// stream connections, sort their shards locally with libsort, agree on p-1
+// splitters from a regular sample of every shard, exchange range partitions
+// in a single all-to-all, and k-way merge what they receive. Afterwards
+// worker r holds the r-th slice of the global order, so the output shards
+// concatenated in rank order are the sorted input.
+//
+// Transports are looked up by the scheme of the worker address:
+//   unix:/path/to/socket
+//   tcp:host:port
+// A transport only has to produce connected stream sockets; everything
+// above that (handshake, exchange) is shared.
+
+#ifndef SORT_DIST_H
+#define SORT_DIST_H
+
+#include <stddef.h>
+
+#include "libsort/sort.h"
+
+typedef struct {
+  const char* scheme;
+  int (*listen)(const char* addr);   // listening socket, or -1
+  int (*connect)(const char* addr);  // connected socket, or -1
+} dist_transport;
+
+typedef struct {
+  int rank;
+  int size;
+  int* fds;  // fds[r]: connection to rank r, -1 for self
+} dist_comm;
+
+// Connects worker `rank` to all of addrs[0..size). Waits up to timeout_s
+// seconds for peers to come up. Returns 0, or -1 with a message on stderr.
+int dist_open(dist_comm* c, int rank, char* const* addrs, int size,
+              int timeout_s);
+void dist_close(dist_comm* c);
+
+// all[r * bytes ..] receives rank r's `mine`. Returns 0 or -1.
+int dist_allgather(dist_comm* c, const void* mine, size_t bytes, void* all);
+
+// Sample sort of this worker's n elements of `elem` (SORT_ELEM_* from
+// sort_proto.h). `a` is sorted in place as the local step. *out is a
+// sort_alloc() buffer (pages policy from ctx tuning) holding this worker's
+// part of the global order, *out_n elements. Returns SORT_OK, SORT_ENOMEM,
+// or SORT_EINVAL on a transport failure.
+int dist_sort(dist_comm* c, sort_ctx* ctx, int elem, void* a, size_t n,
+              void** out, size_t* out_n);
+
+#endif  // SORT_DIST_H
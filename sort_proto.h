@@ -0,0 +1,43 @@
+// Wire protocol between `sort_omp --serve` and sort_client.
+//
+// The client connects to the server's Unix stream socket and sends
+// fixed-size sort_request messages; each is answered by one sort_reply.
+// SORT_OP_SORT carries a memfd (SCM_RIGHTS) holding n native-endian
+// elements at offset 0. The server maps it MAP_SHARED and sorts it in place,
+// so the payload is never copied through the socket. Requests on one
+// connection are served in order; the connection may be kept open for any
+// number of jobs.
+
+#ifndef SORT_PROTO_H
+#define SORT_PROTO_H
+
+#include <stdint.h>
+
+#define SORT_PROTO_MAGIC 0x54524f53u  // "SORT"
+
+enum {
+  SORT_OP_SORT = 1,      // sort the attached memfd in place
+  SORT_OP_PING = 2,      // round trip only, no payload
+  SORT_OP_SHUTDOWN = 3,  // reply, then stop the server
+};
+
+enum { SORT_ELEM_I32 = 0, SORT_ELEM_F32 = 1, SORT_ELEM_F64 = 2 };
+
+// Reply status: SORT_OK / SORT_E* from libsort/sort.h, or one of these.
+enum { SORT_PROTO_EBADREQ = -100, SORT_PROTO_EPAYLOAD = -101 };
+
+typedef struct {
+  uint32_t magic;
+  uint32_t op;
+  uint32_t elem;
+  uint32_t reserved;
+  uint64_t n;
+} sort_request;
+
+typedef struct {
+  uint32_t magic;
+  int32_t status;
+  uint64_t sort_ns;  // server-side sort time, excludes mapping
+} sort_reply;
+
+#endif  // SORT_PROTO_H
@@ -0,0 +1,199 @@
+// Regression test: libsort calls must sort correctly when OpenMP starts a
+// smaller team than the plan asked for. Each check runs once at top level
+// and once per thread from inside a caller's parallel region (one context
+// per calling thread, as sort.h documents), where the inner team is a
+// single thread. ctest also runs it under OMP_THREAD_LIMIT and OMP_DYNAMIC.
+//
+// usage: nested_parallel   (exit status 0 when every check passes)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sort.h"
+
+#define N ((size_t)300000)  // several LS_MIN_PER_THREAD slices
+#define THREADS 4
+
+static uint64_t next(uint64_t* s) {
+  *s ^= *s << 13;
+  *s ^= *s >> 7;
+  *s ^= *s << 17;
+  return *s;
+}
+
+static int cmp_i32(const void* a, const void* b) {
+  int32_t x = *(const int32_t*)a, y = *(const int32_t*)b;
+  return (x > y) - (x < y);
+}
+
+static int cmp_str(const void* a, const void* b) {
+  const sort_str* x = (const sort_str*)a;
+  const sort_str* y = (const sort_str*)b;
+  size_t m = x->len < y->len ? x->len : y->len;
+  int c = memcmp(x->ptr, y->ptr, m);
+  return c ? c : (x->len > y->len) - (x->len < y->len);
+}
+
+// Runs every check on ctx; returns the number that failed.
+static int run_checks(sort_ctx* ctx, uint64_t seed, const char* where) {
+  int failed = 0;
+  int32_t* a = (int32_t*)malloc(N * sizeof(int32_t));
+  int32_t* ref = (int32_t*)malloc(N * sizeof(int32_t));
+  int32_t* out = (int32_t*)malloc(N * sizeof(int32_t));
+  double* d = (double*)malloc(N * sizeof(double));
+  uint32_t* idx = (uint32_t*)malloc(N * sizeof(uint32_t));
+  char* bytes = (char*)malloc(N * 8);
+  sort_str* s = (sort_str*)malloc(N * sizeof(sort_str));
+  sort_str* sref = (sort_str*)malloc(N * sizeof(sort_str));
+  if (!a || !ref || !out || !d || !idx || !bytes || !s || !sref) {
+    fprintf(stderr, "%s: allocation failed\n", where);
+    exit(1);
+  }
+  for (size_t i = 0; i < N; i++)
+    ref[i] = (int32_t)next(&seed);
+  qsort(ref, N, sizeof(int32_t), cmp_i32);
+
+#define CHECK(name, cond)                                \
+  do {                                                   \
+    if (!(cond)) {                                       \
+      fprintf(stderr, "%s: %s failed\n", where, name);   \
+      failed++;                                          \
+    }                                                    \
+  } while (0)
+
+  // LSD passes, key transforms and their presortedness scan.
+  for (size_t i = 0; i < N; i++)
+    a[i] = ref[(size_t)(next(&seed) % N)];
+  memcpy(out, a, N * sizeof(int32_t));
+  qsort(out, N, sizeof(int32_t), cmp_i32);
+  CHECK("sort_i32", sort_i32(ctx, a, N) == SORT_OK &&
+                        memcmp(a, out, N * sizeof(int32_t)) == 0);
+
+  // A few ascending runs: run detection and the parallel merge.
+  for (size_t i = 0; i < N; i++)
+    a[i] = ref[3 * (i % (N / 3)) + i / (N / 3)];  // 3 ascending runs
+  CHECK("sort_i32 runs", sort_i32(ctx, a, N) == SORT_OK &&
+                             memcmp(a, ref, N * sizeof(int32_t)) == 0);
+
+  // Hybrid MSD + LSD reads the bucket ends of the MSD pass.
+  sort_tuning t;
+  sort_ctx_get_tuning(ctx, &t);
+  const int engines[2] = {SORT_ENGINE_LSD, SORT_ENGINE_HYBRID};
+  for (int e = 0; e < 2; e++) {
+    const int engine = engines[e];
+    t.engine = engine;
+    sort_ctx_set_tuning(ctx, &t);
+    for (size_t i = 0; i < N; i++)
+      d[i] = (double)(int64_t)next(&seed) * 1e-9;
+    int ok = sort_f64(ctx, d, N) == SORT_OK;
+    for (size_t i = 1; i < N && ok; i++)
+      ok = d[i - 1] <= d[i];
+    CHECK(engine == SORT_ENGINE_LSD ? "sort_f64 lsd" : "sort_f64 hybrid",
+          ok);
+  }
+  t.engine = SORT_ENGINE_AUTO;
+  sort_ctx_set_tuning(ctx, &t);
+
+  // Argsort: the index payload through the same passes.
+  for (size_t i = 0; i < N; i++)
+    a[i] = (int32_t)(next(&seed) % 1000);
+  int ok = argsort_i32(ctx, a, N, idx) == SORT_OK;
+  for (size_t i = 1; i < N && ok; i++)
+    ok = a[idx[i - 1]] < a[idx[i]] ||
+         (a[idx[i - 1]] == a[idx[i]] && idx[i - 1] < idx[i]);
+  CHECK("argsort_i32", ok);
+
+  // k-way merge split into per-thread key ranges.
+  const int32_t* runs[2];
+  size_t lens[2] = {N / 2, N - N / 2};
+  for (size_t i = 0; i < N; i++)
+    a[i] = ref[2 * (i % (N / 2)) + i / (N / 2)];  // 2 ascending runs
+  runs[0] = a;
+  runs[1] = a + N / 2;
+  ok = merge_i32(ctx, runs, lens, 2, out) == SORT_OK;
+  CHECK("merge_i32", ok && memcmp(out, ref, N * sizeof(int32_t)) == 0);
+
+  // Strings: common prefix and the MSD pass.
+  for (size_t i = 0; i < N; i++) {
+    uint64_t x = next(&seed);
+    memcpy(bytes + 8 * i, "pre/", 4);
+    for (int j = 4; j < 8; j++)
+      bytes[8 * i + (size_t)j] = (char)('a' + (x >> (5 * j)) % 26);
+    s[i].ptr = bytes + 8 * i;
+    s[i].len = 4 + (size_t)(x % 5);
+  }
+  memcpy(sref, s, N * sizeof(sort_str));
+  qsort(sref, N, sizeof(sort_str), cmp_str);
+  ok = sort_strings(ctx, s, N) == SORT_OK;
+  for (size_t i = 0; i < N && ok; i++)
+    ok = cmp_str(&s[i], &sref[i]) == 0;
+  CHECK("sort_strings", ok);
+
+  // Ingest: two uneven producers' blocks, scattered in ranges that cross
+  // from one producer into the other.
+  for (size_t i = 0; i < N; i++)
+    a[i] = (int32_t)next(&seed);
+  memcpy(ref, a, N * sizeof(int32_t));
+  qsort(ref, N, sizeof(int32_t), cmp_i32);
+  sort_ingest* g = sort_ingest_create(ctx, SORT_TYPE_I32, 2);
+  ok = g && sort_ingest_append(g, 0, a, N / 5) == SORT_OK &&
+       sort_ingest_append(g, 1, a + N / 5, N - N / 5) == SORT_OK &&
+       sort_ingest_finish(g, out) == SORT_OK &&
+       memcmp(out, ref, N * sizeof(int32_t)) == 0;
+  sort_ingest_destroy(g);
+  CHECK("sort_ingest", ok);
+#undef CHECK
+
+  free(a);
+  free(ref);
+  free(out);
+  free(d);
+  free(idx);
+  free(bytes);
+  free(s);
+  free(sref);
+  return failed;
+}
+
+static sort_ctx* make_ctx(void) {
+  sort_tuning t;
+  sort_tuning_default(&t);
+  t.threads = THREADS;  // ask for a team whatever the host has
+  t.parallel_min_n = 1;
+  sort_ctx* ctx = sort_ctx_create(&t);
+  if (!ctx) {
+    fprintf(stderr, "sort_ctx_create failed\n");
+    exit(1);
+  }
+  return ctx;
+}
+
+int main(void) {
+  int failed = 0;
+  sort_ctx* ctx = make_ctx();
+  failed += run_checks(ctx, 0x9e3779b97f4a7c15ull, "top level");
+  sort_ctx_destroy(ctx);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(2) reduction(+ : failed)
+#endif
+  {
+#ifdef _OPENMP
+    uint64_t seed = 0x2545f4914f6cdd1dull + (uint64_t)omp_get_thread_num();
+#else
+    uint64_t seed = 0x2545f4914f6cdd1dull;
+#endif
+    sort_ctx* mine = make_ctx();
+    failed += run_checks(mine, seed, "nested");
+    sort_ctx_destroy(mine);
+  }
+
+  if (failed)
+    fprintf(stderr, "%d check(s) failed\n", failed);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+#!/bin/sh
+# Regression test: sort_omp modes with their own parallel regions must keep
+# every value when OpenMP starts fewer threads than --threads asks for.
+# ctest runs this under OMP_THREAD_LIMIT=2; the outputs are checked against
+# the inputs with verify_sorted (same values, ascending).
+#
+# usage: sort_omp_team.sh <dir with sort_omp and verify_sorted>
+set -e
+bin=$1
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+n=200000
+
+# Distinct values, so --unique keeps them all; a small range takes the
+# histogram path.
+awk -v n=$n 'BEGIN { for (i = 0; i < n; i++) print (i * 7919) % n }' \
+  > "$tmp/ints.txt"
+"$bin/sort_omp" --threads 4 --unique "$tmp/ints.txt" "$tmp/unique.txt" \
+  2> /dev/null
+"$bin/verify_sorted" "$tmp/unique.txt" "$tmp/ints.txt"
+
+# Equal-width lines sort the same as bytes and as numbers.
+awk -v n=$n 'BEGIN { for (i = 0; i < n; i++) printf "%08d\n", (i * 7919) % n }' \
+  > "$tmp/lines.txt"
+"$bin/sort_omp" --threads 4 --lines "$tmp/lines.txt" "$tmp/sorted.txt" \
+  2> /dev/null
+"$bin/verify_sorted" "$tmp/sorted.txt" "$tmp/lines.txt"
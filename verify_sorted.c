@@ -0,0 +1,388 @@
+// Build:
+//   gcc -O3 -march=native -std=c11 -Wall -Wextra -fopenmp -o verify_sorted verify_sorted.c
+//
+// usage: verify_sorted [--type int|float|double] [--cap N] <output> [input]
+//
+// Checks that <output> (first token of every line) is in ascending order and,
+// when <input> is given, that it holds exactly the same multiset of values.
+// Both files are memory-mapped and processed in parallel chunks; ordering is
+// also checked across chunk boundaries. The permutation check compares an
+// order-independent hash (two lanes of summed 64-bit mixes) plus the count.
+//
+// --cap N hashes only the first N input values, matching a sorter built with
+// N_EXPECTED=N.
+//
+// Values are compared as the type the sort binaries would pick for <input>
+// (same detect rule: 'e'/'E' -> double, '.' -> float, else int), using the
+// radix total order, so -0 < +0 and NaNs are ordered by sign like the sorter.
+//
+// Exit status: 0 sorted (and a permutation), 1 violation, 2 usage or I/O error.
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define MAX_CHUNKS 1024
+#define MAX_TOKEN  64
+
+// ===================== type detect =====================
+typedef enum { T_INT32, T_FLOAT32, T_FLOAT64 } NumType;
+
+static NumType detect_type(const unsigned char* b, size_t len) {
+    int saw_dot = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (b[i] == 'e' || b[i] == 'E') return T_FLOAT64;
+        if (b[i] == '.') saw_dot = 1;
+    }
+    return saw_dot ? T_FLOAT32 : T_INT32;
+}
+
+static const char* type_name(NumType t) {
+    return t == T_INT32 ? "int" : (t == T_FLOAT32 ? "float" : "double");
+}
+
+// ===================== keys =====================
+// Every value maps to a uint64 radix key (total order) and its raw bits
+// (multiset identity).
+
+static inline uint64_t flip_f32(uint32_t x) {
+    return (x & 0x80000000u) ? ~x : (x ^ 0x80000000u);
+}
+static inline uint64_t flip_f64(uint64_t x) {
+    return (x & 0x8000000000000000ull) ? ~x : (x ^ 0x8000000000000000ull);
+}
+
+static inline int is_ws(unsigned char c) { return c <= ' '; }
+
+// Parses the token [p, e) into *key / *bits. Returns 0 if it is not a number.
+static int parse_token(const unsigned char* p, const unsigned char* e, NumType type,
+                       uint64_t* key, uint64_t* bits) {
+    char tok[MAX_TOKEN];
+    size_t len = (size_t)(e - p);
+    if (len == 0 || len >= sizeof(tok)) return 0;
+    memcpy(tok, p, len);
+    tok[len] = 0;
+
+    char* endp;
+    if (type == T_INT32) {
+        long v = strtol(tok, &endp, 10);
+        if (endp == tok) return 0;
+        if (v > INT32_MAX) v = INT32_MAX;
+        if (v < INT32_MIN) v = INT32_MIN;
+        uint32_t u = (uint32_t)(int32_t)v;
+        *bits = u;
+        *key = u ^ 0x80000000u;
+    } else if (type == T_FLOAT32) {
+        float v = strtof(tok, &endp);
+        if (endp == tok) return 0;
+        uint32_t u;
+        memcpy(&u, &v, sizeof(u));
+        *bits = u;
+        *key = flip_f32(u);
+    } else {
+        double v = strtod(tok, &endp);
+        if (endp == tok) return 0;
+        uint64_t u;
+        memcpy(&u, &v, sizeof(u));
+        *bits = u;
+        *key = flip_f64(u);
+    }
+    return 1;
+}
+
+// ===================== multiset hash =====================
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+typedef struct {
+    uint64_t count;
+    uint64_t h1, h2;
+} MultisetHash;
+
+static inline void ms_add(MultisetHash* h, uint64_t bits) {
+    h->count++;
+    h->h1 += mix64(bits);
+    h->h2 += mix64(bits ^ 0x9E3779B97F4A7C15ull) * 0xD6E8FEB86659FD93ull;
+}
+
+// ===================== file mapping =====================
+typedef struct {
+    const unsigned char* data;
+    size_t len;
+} Mapped;
+
+static int map_file(const char* path, Mapped* m) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        fprintf(stderr, "Failed to stat '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    m->len = (size_t)st.st_size;
+    m->data = NULL;
+    if (m->len) {
+        void* p = mmap(NULL, m->len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            fprintf(stderr, "Failed to map '%s': %s\n", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        madvise(p, m->len, MADV_SEQUENTIAL);
+        m->data = (const unsigned char*)p;
+    }
+    close(fd);
+    return 0;
+}
+
+static void unmap_file(Mapped* m) {
+    if (m->data) munmap((void*)m->data, m->len);
+}
+
+// Splits [0, len) into `parts` ranges that start right after a newline (or
+// whitespace when `any_ws`), so no line/token straddles two chunks.
+static void split_chunks(const Mapped* m, int parts, int any_ws, size_t* bounds) {
+    bounds[0] = 0;
+    for (int c = 1; c < parts; c++) {
+        size_t pos = (m->len * (size_t)c) / (size_t)parts;
+        if (pos < bounds[c - 1]) pos = bounds[c - 1];
+        while (pos < m->len && !(any_ws ? is_ws(m->data[pos]) : m->data[pos] == '\n')) pos++;
+        if (pos < m->len) pos++;
+        bounds[c] = pos;
+    }
+    bounds[parts] = m->len;
+}
+
+// ===================== output scan =====================
+typedef struct {
+    size_t       lines;          // newline-terminated or final partial line
+    size_t       values;
+    uint64_t     first_key, last_key;
+    size_t       bad_line;       // 1-based within chunk, 0 = none
+    size_t       bad_offset;     // byte offset of the offending line
+    int          bad_kind;       // 1 = out of order, 2 = not a number
+    MultisetHash hash;
+} OutChunk;
+
+static void scan_output_chunk(const Mapped* m, size_t begin, size_t end, NumType type, OutChunk* r) {
+    memset(r, 0, sizeof(*r));
+    const unsigned char* d = m->data;
+    size_t pos = begin;
+    while (pos < end) {
+        size_t line_start = pos;
+        size_t nl = pos;
+        while (nl < end && d[nl] != '\n') nl++;
+        r->lines++;
+
+        // first token of the line, like awk's $1
+        size_t p = line_start;
+        while (p < nl && is_ws(d[p])) p++;
+        size_t q = p;
+        while (q < nl && !is_ws(d[q])) q++;
+
+        if (q > p) {
+            uint64_t key, bits;
+            if (!parse_token(d + p, d + q, type, &key, &bits)) {
+                if (!r->bad_line) {
+                    r->bad_line = r->lines;
+                    r->bad_offset = line_start;
+                    r->bad_kind = 2;
+                }
+            } else {
+                if (r->values == 0) r->first_key = key;
+                else if (key < r->last_key && !r->bad_line) {
+                    r->bad_line = r->lines;
+                    r->bad_offset = line_start;
+                    r->bad_kind = 1;
+                }
+                r->last_key = key;
+                r->values++;
+                ms_add(&r->hash, bits);
+            }
+        }
+        pos = nl + 1;
+    }
+}
+
+// ===================== input scan =====================
+static void scan_input_chunk(const Mapped* m, size_t begin, size_t end, NumType type, MultisetHash* h) {
+    memset(h, 0, sizeof(*h));
+    const unsigned char* d = m->data;
+    size_t pos = begin;
+    while (pos < end) {
+        while (pos < end && is_ws(d[pos])) pos++;
+        size_t q = pos;
+        while (q < end && !is_ws(d[q])) q++;
+        if (q > pos) {
+            uint64_t key, bits;
+            if (parse_token(d + pos, d + q, type, &key, &bits)) ms_add(h, bits);
+        }
+        pos = q;
+    }
+}
+
+// With a cap the sorter only saw the first `cap` values, so the input has to
+// be hashed sequentially up to that point.
+static void hash_input_capped(const Mapped* m, NumType type, uint64_t cap, MultisetHash* h) {
+    memset(h, 0, sizeof(*h));
+    const unsigned char* d = m->data;
+    size_t pos = 0;
+    while (pos < m->len && h->count < cap) {
+        while (pos < m->len && is_ws(d[pos])) pos++;
+        size_t q = pos;
+        while (q < m->len && !is_ws(d[q])) q++;
+        if (q == pos) break;
+        uint64_t key, bits;
+        if (!parse_token(d + pos, d + q, type, &key, &bits)) break;   // sorter stops here too
+        ms_add(h, bits);
+        pos = q;
+    }
+}
+
+// ===================== main =====================
+static void usage(void) {
+    fprintf(stderr, "usage: verify_sorted [--type int|float|double] [--cap N] <output> [input]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* out_path = NULL;
+    const char* in_path = NULL;
+    int forced_type = -1;
+    uint64_t cap = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--type") == 0 && i + 1 < argc) {
+            const char* t = argv[++i];
+            if (strcmp(t, "int") == 0) forced_type = T_INT32;
+            else if (strcmp(t, "float") == 0) forced_type = T_FLOAT32;
+            else if (strcmp(t, "double") == 0) forced_type = T_FLOAT64;
+            else { usage(); return 2; }
+        } else if (strcmp(argv[i], "--cap") == 0 && i + 1 < argc) {
+            cap = (uint64_t)strtod(argv[++i], NULL);
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            usage();
+            return 2;
+        } else if (!out_path) out_path = argv[i];
+        else if (!in_path) in_path = argv[i];
+        else { usage(); return 2; }
+    }
+    if (!out_path) { usage(); return 2; }
+
+    Mapped out = {0}, in = {0};
+    if (map_file(out_path, &out) != 0) return 2;
+    if (in_path && map_file(in_path, &in) != 0) { unmap_file(&out); return 2; }
+
+    NumType type;
+    if (forced_type >= 0) type = (NumType)forced_type;
+    else if (in_path) type = detect_type(in.data, in.len);
+    else type = detect_type(out.data, out.len);
+
+#ifdef _OPENMP
+    int chunks = omp_get_max_threads() * 4;
+#else
+    int chunks = 1;
+#endif
+    if (chunks > MAX_CHUNKS) chunks = MAX_CHUNKS;
+    if (chunks < 1) chunks = 1;
+
+    // ---- ordering ----
+    static size_t bounds[MAX_CHUNKS + 1];
+    static OutChunk res[MAX_CHUNKS];
+    split_chunks(&out, chunks, 0, bounds);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (int c = 0; c < chunks; c++) scan_output_chunk(&out, bounds[c], bounds[c + 1], type, &res[c]);
+
+    int status = 0;
+    size_t line_base = 0;
+    int have_prev = 0;
+    uint64_t prev_key = 0;
+    MultisetHash out_hash = {0, 0, 0};
+    for (int c = 0; c < chunks; c++) {
+        const OutChunk* r = &res[c];
+        if (!status) {
+            if (have_prev && r->values && r->first_key < prev_key) {
+                // violation sits on the chunk's first value line
+                size_t p = bounds[c], line = 1;
+                while (p < out.len && is_ws(out.data[p])) {
+                    if (out.data[p] == '\n') line++;
+                    p++;
+                }
+                printf("Not sorted at line %zu\n", line_base + line);
+                status = 1;
+            } else if (r->bad_line) {
+                size_t e = r->bad_offset;
+                while (e < out.len && out.data[e] != '\n') e++;
+                if (r->bad_kind == 1) printf("Not sorted at line %zu\n", line_base + r->bad_line);
+                else printf("Not a %s value at line %zu: '%.*s'\n", type_name(type),
+                            line_base + r->bad_line, (int)(e - r->bad_offset), out.data + r->bad_offset);
+                status = 1;
+            }
+        }
+        if (r->values) {
+            have_prev = 1;
+            prev_key = r->last_key;
+        }
+        line_base += r->lines;
+        out_hash.count += r->hash.count;
+        out_hash.h1 += r->hash.h1;
+        out_hash.h2 += r->hash.h2;
+    }
+    if (!status) printf("Sorted (%llu %s values)\n", (unsigned long long)out_hash.count, type_name(type));
+
+    // ---- permutation ----
+    if (in_path) {
+        MultisetHash in_hash = {0, 0, 0};
+        if (cap) {
+            hash_input_capped(&in, type, cap, &in_hash);
+        } else {
+            static MultisetHash parts[MAX_CHUNKS];
+            split_chunks(&in, chunks, 1, bounds);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+            for (int c = 0; c < chunks; c++)
+                scan_input_chunk(&in, bounds[c], bounds[c + 1], type, &parts[c]);
+            for (int c = 0; c < chunks; c++) {
+                in_hash.count += parts[c].count;
+                in_hash.h1 += parts[c].h1;
+                in_hash.h2 += parts[c].h2;
+            }
+        }
+
+        if (in_hash.count != out_hash.count) {
+            printf("Not a permutation: input has %llu values, output has %llu\n",
+                   (unsigned long long)in_hash.count, (unsigned long long)out_hash.count);
+            status = 1;
+        } else if (in_hash.h1 != out_hash.h1 || in_hash.h2 != out_hash.h2) {
+            printf("Not a permutation: value multisets differ\n");
+            status = 1;
+        } else {
+            printf("Permutation of input\n");
+        }
+    }
+
+    unmap_file(&out);
+    unmap_file(&in);
+    return status;
+}